@@ -35,6 +35,7 @@ extern "C" {
 #include <string.h>
 #include <destroshell.h>
 #include <shell_cmd.h>
+#include <shell_top.h>
 /* USER CODE END Includes */
 
 /* Exported types ------------------------------------------------------------*/
@@ -24,6 +24,9 @@
 #include <FreeRTOS.h>
 #include <task.h>
 #include <queue.h>
+#include <shell_uart.h>
+#include <shell_rtt.h>
+#include <shell_periph.h>
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -34,6 +37,10 @@
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
 #define DWT_CTRL    (*(volatile uint32_t*)0xE0001000)
+/* Shell UART flow control, UART_HWCONTROL_RTS_CTS once PD3/PD4 are wired to the host */
+#ifndef SHELL_UART_FLOW
+#define SHELL_UART_FLOW UART_HWCONTROL_NONE
+#endif
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -43,15 +50,29 @@
 
 /* Private variables ---------------------------------------------------------*/
 UART_HandleTypeDef shellUSART;
+UART_HandleTypeDef auxUSART;
+DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
+DMA_HandleTypeDef hdma_usart6_rx;
+DMA_HandleTypeDef hdma_usart6_tx;
 
 /* USER CODE BEGIN PV */
 Shell_Handle_t shellHandle;
+Shell_Handle_t auxHandle;
+static ShellUartLink_t shellLink = { .huart = &shellUSART };
+static ShellUartLink_t auxLink = { .huart = &auxUSART };
+#if ( configUSE_SHELL_RTT == 1 )
+static ShellRttLink_t shellRttLink = { .channel = SHELL_RTT_CHANNEL };
+#endif
+extern TIM_HandleTypeDef htim6;
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART2_UART_Init(void);
+static void MX_USART6_UART_Init(void);
 /* USER CODE BEGIN PFP */
 
 /* USER CODE END PFP */
@@ -90,7 +111,9 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART2_UART_Init();
+  MX_USART6_UART_Init();
   /* USER CODE BEGIN 2 */
   
   //CYCLCNT enable
@@ -98,24 +121,27 @@ int main(void)
 
   SEGGER_SYSVIEW_Conf();
 
-  /* Initialize shell */
-  Shell_Init(&shellHandle, &shellUSART);
+  /* Initialize shell, on RTT when a debugger is there to read it */
+#if ( configUSE_SHELL_RTT == 1 )
+  if (0 != (CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk))
+  {
+    Shell_Init(&shellHandle, &shellRtt, &shellRttLink);
+  }
+  else
+#endif
+  {
+    Shell_Init(&shellHandle, &shellUartDma, &shellLink);
+  }
+  /* Second session on USART6 for automation, same commands */
+  Shell_Init(&auxHandle, &shellUartDma, &auxLink);
+  /* TIM6 is the HAL timebase, keep init away from it */
+  Shell_BusReserveTim(&htim6);
   
   /* Create shell task */
   xTaskCreate(Shell_Task, "Shell", 512, &shellHandle, 1, NULL);
   xTaskCreate(vUartTask, "UART", 512, &shellHandle, 1, NULL);
-
-  Shell_RegisterCommand("clear", "Clear the terminal screen", "clear", shell_cmd_clear);
-  Shell_RegisterCommand("help", "Display help information for commands", "help [command]", shell_cmd_help);
-  Shell_RegisterCommand("status", "Show system status information", "status", shell_cmd_status);
-  Shell_RegisterCommand("reset", "Reset the system", "reset", shell_cmd_reset);
-  Shell_RegisterCommand("cancel", "Cancel pending reset", "cancel reset", shell_cmd_reset_cancel);
-  Shell_RegisterCommand("pin", "Control GPIO pins", "pin <set/reset/read/toggle> <port: A, B, etc.> <pin_number>", shell_cmd_pin);
-  Shell_RegisterCommand("tasks", "Manage system tasks", "tasks list | tasks info <task_name>", shell_cmd_tasks);
-  Shell_RegisterCommand("heap", "Show heap memory information", "heap", shell_cmd_heap);
-  Shell_RegisterCommand("stack", "Show stack usage for all tasks", "stack", shell_cmd_stack);
-  Shell_RegisterCommand("init", "Initialize peripheral", "init", shell_cmd_init);
-
+  xTaskCreate(Shell_Task, "AuxShell", 512, &auxHandle, 1, NULL);
+  xTaskCreate(vUartTask, "AuxUART", 512, &auxHandle, 1, NULL);
 
   //start the freeRTOS scheduler
   vTaskStartScheduler();
@@ -206,12 +232,81 @@ static void MX_USART2_UART_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN USART2_Init 2 */
+  if (UART_HWCONTROL_NONE != SHELL_UART_FLOW)
+  {
+    Shell_PeriphEnableFlow(Shell_PeriphFromBase(USART2_BASE), SHELL_UART_FLOW);
+    shellUSART.Init.HwFlowCtl = SHELL_UART_FLOW;
+    if (HAL_UART_Init(&shellUSART) != HAL_OK)
+    {
+      Error_Handler();
+    }
+  }
+  /* RX runs on circular DMA + IDLE line, started by Shell_Init() */
   __HAL_UART_ENABLE_IT(&shellUSART, UART_IT_ERR);
-  __HAL_UART_ENABLE_IT(&shellUSART, UART_IT_RXNE);
   /* USER CODE END USART2_Init 2 */
 
 }
 
+/**
+  * @brief USART6 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_USART6_UART_Init(void)
+{
+
+  /* USER CODE BEGIN USART6_Init 0 */
+
+  /* USER CODE END USART6_Init 0 */
+
+  /* USER CODE BEGIN USART6_Init 1 */
+
+  /* USER CODE END USART6_Init 1 */
+  auxUSART.Instance = USART6;
+  auxUSART.Init.BaudRate = 115200;
+  auxUSART.Init.WordLength = UART_WORDLENGTH_8B;
+  auxUSART.Init.StopBits = UART_STOPBITS_1;
+  auxUSART.Init.Parity = UART_PARITY_NONE;
+  auxUSART.Init.Mode = UART_MODE_TX_RX;
+  auxUSART.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+  auxUSART.Init.OverSampling = UART_OVERSAMPLING_16;
+  if (HAL_UART_Init(&auxUSART) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN USART6_Init 2 */
+  /* RX runs on circular DMA + IDLE line, started by Shell_Init() */
+  __HAL_UART_ENABLE_IT(&auxUSART, UART_IT_ERR);
+  /* USER CODE END USART6_Init 2 */
+
+}
+
+/**
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init(void)
+{
+
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+  __HAL_RCC_DMA2_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA1_Stream5_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+  /* DMA1_Stream6_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+  /* DMA2_Stream1_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA2_Stream1_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA2_Stream1_IRQn);
+  /* DMA2_Stream6_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA2_Stream6_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA2_Stream6_IRQn);
+
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -225,6 +320,7 @@ static void MX_GPIO_Init(void)
 
   /* GPIO Ports Clock Enable */
   __HAL_RCC_GPIOA_CLK_ENABLE();
+  __HAL_RCC_GPIOC_CLK_ENABLE();
   __HAL_RCC_GPIOD_CLK_ENABLE();
 
   /*Configure GPIO pin Output Level */
@@ -252,7 +348,15 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
-
+/**
+  * @brief  FreeRTOS tick hook
+  * @note   reads the run time counter every tick so its CYCCNT extension never misses a wrap
+  * @retval None
+  */
+void vApplicationTickHook(void)
+{
+  (void)Shell_TopCounter();
+}
 /* USER CODE END 4 */
 
 /**
@@ -285,6 +389,7 @@ void Error_Handler(void)
   /* USER CODE BEGIN Error_Handler_Debug */
   /* User can add his own implementation to report the HAL error return state */
   __disable_irq();
+  sh_drain(&shellHandle);
   while (1)
   {
   }
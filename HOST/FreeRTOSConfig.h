@@ -0,0 +1,113 @@
+/*
+ * FreeRTOS configuration of the host build (FreeRTOS POSIX port).
+ *
+ * Kernel features and the shell hooks follow PROJECT/FreeRTOSConfig.h so
+ * the shell core sees the same kernel as on the board. What differs is what
+ * the port needs: every task runs on a pthread whose stack is the FreeRTOS
+ * stack, so stacks must exceed PTHREAD_STACK_MIN, and the heap is sized for
+ * that. The trace recorder and the MPU stack guard are Cortex-M only.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#if defined(__GNUC__)
+	#include <stdint.h>
+	extern uint32_t SystemCoreClock;
+	extern void Shell_TopTimerInit( void );
+	extern uint32_t Shell_TopCounter( void );
+	extern void *pvShellTopLastTask;
+	extern volatile uint32_t ulShellHeapTraceOn;
+	extern void Shell_HeapTraceMalloc( void *pvAddress, void *pvCaller );
+	extern void Shell_HeapTraceFree( void *pvAddress, uint32_t ulSize );
+	extern void vAssertCalled( const char *pcFile, unsigned long ulLine );
+#endif
+
+#define configUSE_PREEMPTION			1
+#define configUSE_IDLE_HOOK				0
+#define configUSE_TICK_HOOK				1
+#define configCPU_CLOCK_HZ				( SystemCoreClock )
+#define configTICK_RATE_HZ				( ( TickType_t ) 1000 )
+#define configMAX_PRIORITIES			( 5 )
+#define configMINIMAL_STACK_SIZE		( ( unsigned short ) 3072 )	/* 24 KB of 8 byte words, above PTHREAD_STACK_MIN */
+#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 512 * 1024 ) )
+#define configAPPLICATION_ALLOCATED_HEAP	1	/* ucHeap is in shell_heap.c so heap frag can walk it */
+#define configMAX_TASK_NAME_LEN			( 10 )
+#define configUSE_TRACE_FACILITY		1
+#define configUSE_STATS_FORMATTING_FUNCTIONS    1
+#define configUSE_16_BIT_TICKS			0
+#define configIDLE_SHOULD_YIELD			1
+#define configUSE_MUTEXES				1
+#define configQUEUE_REGISTRY_SIZE		8
+#define configCHECK_FOR_STACK_OVERFLOW	0
+#define configUSE_RECURSIVE_MUTEXES		1
+#define configUSE_MALLOC_FAILED_HOOK	0
+#define configUSE_APPLICATION_TASK_TAG	1
+#define configUSE_COUNTING_SEMAPHORES	1
+#define configGENERATE_RUN_TIME_STATS	1
+#define configSUPPORT_DYNAMIC_ALLOCATION    1
+
+/* Co-routine definitions. */
+#define configUSE_CO_ROUTINES 		0
+#define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
+
+/* Software timer definitions. */
+#define configUSE_TIMERS				1
+#define configTIMER_TASK_PRIORITY		( 2 )
+#define configTIMER_QUEUE_LENGTH		10
+#define configTIMER_TASK_STACK_DEPTH	( configMINIMAL_STACK_SIZE * 2 )
+
+/* Set the following definitions to 1 to include the API function, or zero
+to exclude the API function. */
+#define INCLUDE_vTaskPrioritySet		1
+#define INCLUDE_uxTaskPriorityGet		1
+#define INCLUDE_vTaskDelete				1
+#define INCLUDE_vTaskCleanUpResources	1
+#define INCLUDE_vTaskSuspend			1
+#define INCLUDE_vTaskDelayUntil			1
+#define INCLUDE_vTaskDelay				1
+
+#define INCLUDE_xTaskGetIdleTaskHandle  1
+#define INCLUDE_xTaskGetSchedulerState  1
+#define INCLUDE_pxTaskGetStackStart		1
+
+/* Report the failing line and stop the process; there is no debugger to halt in. */
+#define configASSERT( x ) if( ( x ) == 0 ) { vAssertCalled( __FILE__, __LINE__ ); }
+
+/* Run time stats come from CYCCNT as on the board; host_hal.c keeps the
+simulated counter running at SystemCoreClock. */
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()	Shell_TopTimerInit()
+#define portGET_RUN_TIME_COUNTER_VALUE()			Shell_TopCounter()
+
+/* Cortex-M only, see PROJECT/FreeRTOSConfig.h */
+#define configUSE_SHELL_TRACE			0
+#define configUSE_SHELL_STACK_GUARD		0
+#define configUSE_SHELL_RTT				0
+
+#ifndef configUSE_SHELL_HEAP_TRACE
+	#define configUSE_SHELL_HEAP_TRACE	1
+#endif
+
+#if ( configUSE_SHELL_HEAP_TRACE == 1 )
+	#define traceMALLOC( pvAddress, uiSize )															\
+		if( 0 != ulShellHeapTraceOn )																	\
+		{																								\
+			Shell_HeapTraceMalloc( ( pvAddress ), __builtin_return_address( 0 ) );						\
+		}
+	#define traceFREE( pvAddress, uiSize )																\
+		if( 0 != ulShellHeapTraceOn )																	\
+		{																								\
+			Shell_HeapTraceFree( ( pvAddress ), ( uint32_t ) ( uiSize ) );								\
+		}
+#endif
+
+/* Context switch counting for top, as on the board. The tag is a counter
+stored in a pointer, so it goes through uintptr_t on a 64-bit host. */
+#define traceTASK_SWITCHED_OUT()																\
+	if( pvShellTopLastTask != ( void * ) pxCurrentTCB )											\
+	{																							\
+		pxCurrentTCB->pxTaskTag = ( TaskHookFunction_t ) ( ( uintptr_t ) pxCurrentTCB->pxTaskTag + 1 );	\
+		pvShellTopLastTask = ( void * ) pxCurrentTCB;											\
+	}
+
+#endif /* FREERTOS_CONFIG_H */
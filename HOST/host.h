@@ -0,0 +1,41 @@
+#ifndef __HOST_H__
+#define __HOST_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+ * Host build of destroshell: the shell core on the FreeRTOS POSIX port with
+ * the shell UART on a pseudo-terminal. CMSIS peripheral and core register
+ * addresses are backed by memory (host_hal.c), the HAL calls the shell
+ * makes are stubbed, and DWT->CYCCNT counts at SystemCoreClock. UARTs
+ * are lines with the timing of their baud rate and frame (host_uart.c).
+ */
+
+#include <stm32f4xx_hal.h>
+
+/* Simulated UART line counters, see host_uart.c */
+typedef struct {
+    uint32_t txBytes;                   /* Bytes whose stop bit has ended */
+    uint32_t txLost;                    /* Bytes the far end did not take */
+    uint32_t rxBytes;                   /* Bytes taken out of the receiver */
+    uint32_t rxOverruns;                /* ORE events */
+    uint32_t rxLost;                    /* Bytes lost to overruns */
+} HostUartStats_t;
+
+/* API prototypes */
+void Host_Init(int argc, char *argv[]);
+uint64_t Host_Now(void);
+const char *Shell_PtyOpen(UART_HandleTypeDef *huart, const char *link);
+void Host_UartAttach(UART_HandleTypeDef *huart, int fd);
+uint32_t Host_UartCharTime(UART_HandleTypeDef *huart);
+size_t Host_UartSend(UART_HandleTypeDef *huart, const uint8_t *data, size_t len, uint64_t *done);
+size_t Host_UartRecv(UART_HandleTypeDef *huart, uint8_t *data, size_t len);
+void Host_UartStats(UART_HandleTypeDef *huart, HostUartStats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __HOST_H__ */
@@ -0,0 +1,115 @@
+#ifndef __HOST_CMSIS_H__
+#define __HOST_CMSIS_H__
+
+/*
+ * CMSIS compiler layer for the host build, force-included ahead of every
+ * source (-include host_cmsis.h). It defines the include guard of
+ * cmsis_gcc.h, so core_cm4.h and the HAL headers get these definitions
+ * instead of the Cortex-M inline assembly. Peripheral and core registers
+ * stay where CMSIS puts them; host_hal.c backs those addresses with memory.
+ */
+#define __CMSIS_GCC_H
+
+#include <stdint.h>
+
+/* Compiler attributes, as in cmsis_gcc.h */
+#define __ASM                                  __asm
+#define __INLINE                               inline
+#define __STATIC_INLINE                        static inline
+#define __STATIC_FORCEINLINE                   __attribute__((always_inline)) static inline
+#define __NO_RETURN                            __attribute__((__noreturn__))
+#define __USED                                 __attribute__((used))
+#define __WEAK                                 __attribute__((weak))
+#define __PACKED                               __attribute__((packed, aligned(1)))
+#define __PACKED_STRUCT                        struct __attribute__((packed, aligned(1)))
+#define __PACKED_UNION                         union __attribute__((packed, aligned(1)))
+#define __ALIGNED(x)                           __attribute__((aligned(x)))
+#define __RESTRICT                             __restrict
+#define __COMPILER_BARRIER()                   __ASM volatile("":::"memory")
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Implemented in host_hal.c */
+void Host_Barrier(void);
+void vPortDisableInterrupts(void);
+void vPortEnableInterrupts(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* Barriers also act on writes with side effects, see Host_Barrier */
+#define __NOP()                                __COMPILER_BARRIER()
+#define __WFI()                                __COMPILER_BARRIER()
+#define __WFE()                                __COMPILER_BARRIER()
+#define __SEV()                                __COMPILER_BARRIER()
+#define __ISB()                                Host_Barrier()
+#define __DSB()                                Host_Barrier()
+#define __DMB()                                __sync_synchronize()
+#define __BKPT(value)                          __builtin_trap()
+
+__STATIC_FORCEINLINE uint32_t __REV(uint32_t value)       { return __builtin_bswap32(value); }
+__STATIC_FORCEINLINE uint32_t __REV16(uint32_t value)     { return (uint32_t)(((value & 0x00FF00FFu) << 8) | ((value >> 8) & 0x00FF00FFu)); }
+__STATIC_FORCEINLINE int16_t __REVSH(int16_t value)       { return (int16_t)__builtin_bswap16((uint16_t)value); }
+__STATIC_FORCEINLINE uint32_t __ROR(uint32_t op1, uint32_t op2)
+{
+    op2 %= 32u;
+    return (0u == op2) ? op1 : ((op1 >> op2) | (op1 << (32u - op2)));
+}
+__STATIC_FORCEINLINE uint8_t __CLZ(uint32_t value)        { return (uint8_t)((0u == value) ? 32u : (uint32_t)__builtin_clz(value)); }
+__STATIC_FORCEINLINE uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0;
+
+    for (uint32_t i = 0; i < 32u; i++)
+    {
+        result = (result << 1) | ((value >> i) & 1u);
+    }
+    return result;
+}
+
+/* Exclusive access: the simulated CPU runs one task at a time, a plain access is exclusive */
+__STATIC_FORCEINLINE uint16_t __LDREXH(volatile uint16_t *addr)                 { return *addr; }
+__STATIC_FORCEINLINE uint32_t __LDREXW(volatile uint32_t *addr)                 { return *addr; }
+__STATIC_FORCEINLINE uint32_t __STREXH(uint16_t value, volatile uint16_t *addr) { *addr = value; return 0u; }
+__STATIC_FORCEINLINE uint32_t __STREXW(uint32_t value, volatile uint32_t *addr) { *addr = value; return 0u; }
+__STATIC_FORCEINLINE void __CLREX(void)                                         { }
+
+/* Interrupt masking maps onto the FreeRTOS POSIX port, which masks the tick signal */
+__STATIC_FORCEINLINE void __enable_irq(void)              { vPortEnableInterrupts(); }
+__STATIC_FORCEINLINE void __disable_irq(void)             { vPortDisableInterrupts(); }
+
+/* Special registers read as thread mode on the main stack with nothing masked */
+__STATIC_FORCEINLINE uint32_t __get_CONTROL(void)         { return 0u; }
+__STATIC_FORCEINLINE uint32_t __get_IPSR(void)            { return 0u; }
+__STATIC_FORCEINLINE uint32_t __get_APSR(void)            { return 0u; }
+__STATIC_FORCEINLINE uint32_t __get_xPSR(void)            { return 0u; }
+__STATIC_FORCEINLINE uint32_t __get_PSP(void)             { return 0u; }
+__STATIC_FORCEINLINE uint32_t __get_MSP(void)             { return 0u; }
+__STATIC_FORCEINLINE uint32_t __get_PRIMASK(void)         { return 0u; }
+__STATIC_FORCEINLINE uint32_t __get_BASEPRI(void)         { return 0u; }
+__STATIC_FORCEINLINE uint32_t __get_FAULTMASK(void)       { return 0u; }
+__STATIC_FORCEINLINE uint32_t __get_FPSCR(void)           { return 0u; }
+__STATIC_FORCEINLINE void __set_CONTROL(uint32_t value)   { (void)value; }
+__STATIC_FORCEINLINE void __set_PSP(uint32_t value)       { (void)value; }
+__STATIC_FORCEINLINE void __set_MSP(uint32_t value)       { (void)value; }
+__STATIC_FORCEINLINE void __set_PRIMASK(uint32_t value)   { (void)value; }
+__STATIC_FORCEINLINE void __set_BASEPRI(uint32_t value)   { (void)value; }
+__STATIC_FORCEINLINE void __set_BASEPRI_MAX(uint32_t value) { (void)value; }
+__STATIC_FORCEINLINE void __set_FAULTMASK(uint32_t value) { (void)value; }
+__STATIC_FORCEINLINE void __set_FPSCR(uint32_t value)     { (void)value; }
+
+/*
+ * core_cm4.h casts the 32-bit SCB->VTOR to a pointer in __NVIC_SetVector and
+ * __NVIC_GetVector, which warns with 64-bit pointers. The device header is
+ * pulled in here, once, with only that warning off; later includes hit its guard.
+ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wint-to-pointer-cast"
+#include "stm32f407xx.h"
+#pragma GCC diagnostic pop
+
+#endif /* __HOST_CMSIS_H__ */
@@ -0,0 +1,276 @@
+/*
+ * Simulated microcontroller for the host build.
+ *
+ * The shell reaches hardware three ways: CMSIS register pointers (GPIOD,
+ * DWT, SCB, ...), the intrinsics of cmsis_gcc.h (replaced by host_cmsis.h)
+ * and HAL calls. The register pointers keep their real addresses; both
+ * register windows are mapped as plain memory, so writes stick and reads
+ * return them. HAL calls succeed without touching anything but their
+ * handle, and GPIO pins read back what was last driven; the UART calls
+ * are simulated with their line timing in host_uart.c. A background
+ * thread keeps DWT->CYCCNT counting at SystemCoreClock, and a reset
+ * request in SCB->AIRCR restarts the process, keeping the pseudo-terminal.
+ */
+#include <destroshell.h>
+#include <host.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Register windows backed by memory */
+#define HOST_PERIPH_SIZE 0x10100000u    /* APB1 up to the end of AHB2 */
+#define HOST_CORE_BASE 0xE0000000u      /* ITM, DWT, SCS, TPI and DBGMCU */
+#define HOST_CORE_SIZE 0x00100000u
+#define HOST_CYCCNT_PERIOD_NS 20000     /* CYCCNT update period */
+
+/* Exported variables --------------------------------------------------------*/
+uint32_t SystemCoreClock = 168000000;   /* As after SystemClock_Config */
+
+/* Private variables ----------------------------------------------------------*/
+static char **hostArgv;
+static struct timespec hostStart;
+
+/**
+  * @brief  map memory at a fixed address
+  * @param base address
+  * @param size bytes
+  * @retval None, exits when the range is taken
+  */
+static void Host_MapRegisters(uintptr_t base, size_t size)
+{
+    void *mem = mmap((void *)base, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0);
+
+    if (mem != (void *)base)
+    {
+        fprintf(stderr, "destroshell: cannot map registers at 0x%08lx\n", (unsigned long)base);
+        exit(1);
+    }
+}
+
+/**
+  * @brief  time since Host_Init
+  * @retval nanoseconds, monotonic
+  */
+uint64_t Host_Now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - hostStart.tv_sec) * 1000000000u + (uint64_t)now.tv_nsec - (uint64_t)hostStart.tv_nsec;
+}
+
+/**
+  * @brief  keep DWT->CYCCNT in step with the monotonic clock
+  * @note   not a FreeRTOS thread; it only stores to the register window and
+  *         runs with every signal blocked so the port's tick signal never lands here
+  * @param arg unused
+  * @retval never returns
+  */
+static void *Host_CycleThread(void *arg)
+{
+    const struct timespec period = { 0, HOST_CYCCNT_PERIOD_NS };
+
+    (void)arg;
+    for (;;)
+    {
+        DWT->CYCCNT = (uint32_t)((Host_Now() * (SystemCoreClock / 1000000u)) / 1000u);
+        nanosleep(&period, NULL);
+    }
+    return NULL;
+}
+
+/**
+  * @brief  set up the simulated microcontroller, first thing in main
+  * @param argc argument count
+  * @param argv argument vector, kept to restart on a reset request
+  * @retval None
+  */
+void Host_Init(int argc, char *argv[])
+{
+    pthread_t thread;
+    sigset_t all;
+    sigset_t old;
+
+    (void)argc;
+    hostArgv = argv;
+
+    Host_MapRegisters(PERIPH_BASE, HOST_PERIPH_SIZE);
+    Host_MapRegisters(HOST_CORE_BASE, HOST_CORE_SIZE);
+
+    clock_gettime(CLOCK_MONOTONIC, &hostStart);
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    if (0 != pthread_create(&thread, NULL, Host_CycleThread, NULL))
+    {
+        fprintf(stderr, "destroshell: cannot start the cycle counter\n");
+        exit(1);
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+}
+
+/**
+  * @brief  __DSB and __ISB: act on register writes that have side effects
+  * @note   NVIC_SystemReset writes SYSRESETREQ between two barriers; the
+  *         process restarts itself, the pseudo-terminal survives (see shell_uart_pty.c)
+  * @retval None
+  */
+void Host_Barrier(void)
+{
+    sigset_t none;
+
+    __sync_synchronize();
+    if (0 == (SCB->AIRCR & SCB_AIRCR_SYSRESETREQ_Msk))
+    {
+        return;
+    }
+
+    fflush(NULL);
+    sigemptyset(&none);
+    pthread_sigmask(SIG_SETMASK, &none, NULL);
+    execv("/proc/self/exe", hostArgv);
+    perror("destroshell: reset");
+    _exit(1);
+}
+
+/**
+  * @brief  configASSERT failure
+  * @param pcFile source file
+  * @param ulLine source line
+  * @retval never returns
+  */
+void vAssertCalled(const char *pcFile, unsigned long ulLine)
+{
+    fprintf(stderr, "destroshell: assertion failed at %s:%lu\n", pcFile, ulLine);
+    abort();
+}
+
+/**
+  * @brief  the sampling profiler needs TIM7 and the Cortex-M exception frame, it is not built here
+  * @retval None
+  */
+void Shell_ProfInit(void)
+{
+}
+
+/* HAL -----------------------------------------------------------------------*/
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+    (void)GPIOx;
+    (void)GPIO_Init;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    if (GPIO_PIN_RESET != PinState)
+    {
+        GPIOx->ODR |= GPIO_Pin;
+    }
+    else
+    {
+        GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+    }
+    GPIOx->IDR = GPIOx->ODR;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    GPIOx->ODR ^= GPIO_Pin;
+    GPIOx->IDR = GPIOx->ODR;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return (0 != (GPIOx->IDR & GPIO_Pin)) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi)
+{
+    hspi->State = HAL_SPI_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_DeInit(SPI_HandleTypeDef *hspi)
+{
+    hspi->State = HAL_SPI_STATE_RESET;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c)
+{
+    hi2c->State = HAL_I2C_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c)
+{
+    hi2c->State = HAL_I2C_STATE_RESET;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim)
+{
+    htim->State = HAL_TIM_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_DeInit(TIM_HandleTypeDef *htim)
+{
+    htim->State = HAL_TIM_STATE_RESET;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim)
+{
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef *htim)
+{
+    htim->Instance->CR1 &= ~TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_Init(RTC_HandleTypeDef *hrtc)
+{
+    hrtc->State = HAL_RTC_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_DeInit(RTC_HandleTypeDef *hrtc)
+{
+    hrtc->State = HAL_RTC_STATE_RESET;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct)
+{
+    (void)RCC_OscInitStruct;
+    return HAL_OK;
+}
+
+/* APB1 at HCLK/4 and APB2 at HCLK/2, as SystemClock_Config sets them */
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+    return SystemCoreClock / 4u;
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void)
+{
+    return SystemCoreClock / 2u;
+}
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit)
+{
+    (void)PeriphClkInit;
+    return HAL_OK;
+}
+
+void HAL_PWR_EnableBkUpAccess(void)
+{
+}
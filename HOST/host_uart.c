@@ -0,0 +1,642 @@
+/*
+ * Simulated UART lines for the host build.
+ *
+ * Every USART is a line with the timing of its configuration: a frame is
+ * start bit, data bits (parity included, as on the STM32) and stop bits at
+ * Init.BaudRate, so HAL_UART_Init decides how fast bytes move. A line
+ * attached to a descriptor (the shell's pseudo-terminal) has a thread that
+ * plays the wire: it takes bytes from the far end no faster than they could
+ * arrive and hands transmitted bytes over once their stop bit has ended.
+ * Bytes arriving faster than they are taken out are lost, as on the wire;
+ * the far end only holds the line back with CTS on (HwFlowCtl), when it
+ * stops reading and the pseudo-terminal fills up.
+ *
+ * Reception has two consumers, like the hardware: Host_UartRecv is the DMA,
+ * which empties the receiver as each byte lands, and HAL_UART_Receive polls
+ * the holding register, so bytes that complete while nobody polls overrun
+ * (ORE) and are lost, all but the first.
+ */
+#include <destroshell.h>
+#include <host.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Configuration constants */
+#define HOST_UART_LINES 6               /* USART1..3, UART4, UART5, USART6 */
+#define HOST_UART_RING 4096             /* Bytes on the wire per direction, power of two */
+#define HOST_UART_IDLE_NS 100000000u    /* Line thread wake-up with nothing to do */
+
+typedef struct {
+    USART_TypeDef *instance;
+    const char *name;
+    int fd;                             /* Far end, -1 while unconnected */
+    int wake[2];                        /* Pipe, tells the line thread about new output */
+    volatile uint64_t charNs;           /* Frame time */
+    volatile bool cts;                  /* A far end that stops reading holds the transmitter */
+    /* Transmitter: tasks produce, the line thread consumes */
+    uint8_t txData[HOST_UART_RING];
+    uint64_t txDue[HOST_UART_RING];     /* When the stop bit of the byte ends */
+    uint32_t txHead;
+    uint32_t txTail;
+    uint64_t txFreeAt;                  /* Stop bit end of the last byte queued */
+    /* Receiver: the line thread produces, tasks consume */
+    uint8_t rxData[HOST_UART_RING];
+    uint32_t rxHead;
+    uint32_t rxTail;
+    uint64_t rxLastAt;                  /* Stop bit end of the last byte received */
+    bool rxIdle;                        /* The far end ran dry, the next byte restarts the clock */
+    uint8_t rdr;                        /* Holding register, polled reception */
+    bool rxne;
+    bool ore;
+    HostUartStats_t stats;
+} HostUart_t;
+
+/* Private variables ----------------------------------------------------------*/
+static HostUart_t hostUarts[HOST_UART_LINES] = {
+    { .instance = USART1, .name = "USART1", .fd = -1, .rxIdle = true },
+    { .instance = USART2, .name = "USART2", .fd = -1, .rxIdle = true },
+    { .instance = USART3, .name = "USART3", .fd = -1, .rxIdle = true },
+    { .instance = UART4,  .name = "UART4",  .fd = -1, .rxIdle = true },
+    { .instance = UART5,  .name = "UART5",  .fd = -1, .rxIdle = true },
+    { .instance = USART6, .name = "USART6", .fd = -1, .rxIdle = true },
+};
+
+/**
+  * @brief  line of a UART handle
+  * @param huart UART handle
+  * @retval line, NULL for an unknown instance
+  */
+static HostUart_t *Host_UartLine(UART_HandleTypeDef *huart)
+{
+    for (uint32_t i = 0; i < HOST_UART_LINES; i++)
+    {
+        if (huart->Instance == hostUarts[i].instance)
+        {
+            return &hostUarts[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @brief  sleep, the calling task keeps the CPU as it would busy waiting on a flag
+  * @param ns nanoseconds
+  * @retval None
+  */
+static void Host_UartSleep(uint64_t ns)
+{
+    struct timespec ts = { (time_t)(ns / 1000000000u), (long)(ns % 1000000000u) };
+
+    // the tick signal cuts the sleep short, callers check the time again anyway
+    (void)nanosleep(&ts, NULL);
+}
+
+/**
+  * @brief  hand the far end every transmitted byte whose stop bit has ended
+  * @param line line
+  * @param now current time
+  * @param held set when CTS holds the rest until the far end reads
+  * @retval time the next byte is due, 0 when the transmitter is empty or held
+  */
+static uint64_t Host_UartTxRelease(HostUart_t *line, uint64_t now, bool *held)
+{
+    uint32_t head = __atomic_load_n(&line->txHead, __ATOMIC_ACQUIRE);
+    uint32_t tail = line->txTail;
+    uint32_t count = 0;
+
+    while ((tail + count != head) && (line->txDue[(tail + count) & (HOST_UART_RING - 1)] <= now))
+    {
+        count++;
+    }
+
+    while (0 != count)
+    {
+        uint32_t first = tail & (HOST_UART_RING - 1);
+        uint32_t len = HOST_UART_RING - first;
+        ssize_t written;
+
+        if (len > count)
+        {
+            len = count;
+        }
+
+        written = write(line->fd, &line->txData[first], len);
+        if (written < 0)
+        {
+            written = 0;
+        }
+        if (line->cts && ((uint32_t)written < len))
+        {
+            // CTS deasserted: the rest stays on the line
+            line->stats.txBytes += (uint32_t)written;
+            tail += (uint32_t)written;
+            *held = true;
+            break;
+        }
+        line->stats.txBytes += len;
+        line->stats.txLost += len - (uint32_t)written;
+        tail += len;
+        count -= len;
+    }
+
+    __atomic_store_n(&line->txTail, tail, __ATOMIC_RELEASE);
+    return ((tail != head) && !*held) ? line->txDue[tail & (HOST_UART_RING - 1)] : 0;
+}
+
+/**
+  * @brief  take in what the far end sent, as fast as the wire carries it
+  * @param line line
+  * @param now current time
+  * @param readable set when the far end had nothing left
+  * @retval time the next byte can complete, 0 when the line waits for the far end
+  */
+static uint64_t Host_UartRxTake(HostUart_t *line, uint64_t now, bool *readable)
+{
+    uint64_t charNs = line->charNs;
+    uint32_t tail = __atomic_load_n(&line->rxTail, __ATOMIC_ACQUIRE);
+    uint32_t head = line->rxHead;
+    uint32_t room = HOST_UART_RING - (head - tail);
+    uint8_t burst[256];
+    uint64_t count;
+    ssize_t len;
+
+    // an idle line starts over: the first byte completes as it is noticed
+    if (line->rxIdle)
+    {
+        line->rxLastAt = now - charNs;
+    }
+
+    // a late thread catches up, the bytes completed while it slept
+    count = (now - line->rxLastAt) / charNs;
+    if (0 == count)
+    {
+        return line->rxLastAt + charNs;
+    }
+    if (count > sizeof(burst))
+    {
+        count = sizeof(burst);
+    }
+
+    len = read(line->fd, burst, count);
+    if (len <= 0)
+    {
+        line->rxIdle = true;
+        *readable = true;
+        return 0;
+    }
+    line->rxIdle = false;
+
+    for (ssize_t i = 0; i < len; i++)
+    {
+        // nobody emptied the receiver in time, the byte is gone
+        if (0 == room)
+        {
+            line->stats.rxOverruns++;
+            line->stats.rxLost++;
+        }
+        else
+        {
+            line->rxData[head & (HOST_UART_RING - 1)] = burst[i];
+            head++;
+            room--;
+        }
+    }
+    line->rxLastAt += (uint64_t)len * charNs;
+    __atomic_store_n(&line->rxHead, head, __ATOMIC_RELEASE);
+
+    // a short read means the far end is empty for now
+    if ((uint64_t)len < count)
+    {
+        line->rxIdle = true;
+        *readable = true;
+        return 0;
+    }
+    return line->rxLastAt + charNs;
+}
+
+/**
+  * @brief  the wire of an attached line
+  * @note   not a FreeRTOS thread, it runs with every signal blocked and only
+  *         touches its own ends of the rings
+  * @param arg line
+  * @retval never returns
+  */
+static void *Host_UartThread(void *arg)
+{
+    HostUart_t *line = (HostUart_t *)arg;
+
+    for (;;)
+    {
+        uint64_t now = Host_Now();
+        uint64_t wait = now + HOST_UART_IDLE_NS;
+        bool held = false;
+        uint64_t txNext = Host_UartTxRelease(line, now, &held);
+        bool readable = false;
+        uint64_t rxNext = Host_UartRxTake(line, now, &readable);
+        struct pollfd pfd[2] = {
+            { line->wake[0], POLLIN, 0 },
+            { line->fd, (short)((readable ? POLLIN : 0) | (held ? POLLOUT : 0)), 0 },
+        };
+        struct timespec ts;
+        uint8_t drain[64];
+
+        if ((0 != txNext) && (txNext < wait))
+        {
+            wait = txNext;
+        }
+        if ((0 != rxNext) && (rxNext < wait))
+        {
+            wait = rxNext;
+        }
+        wait = (wait > now) ? (wait - now) : 0;
+        ts.tv_sec = (time_t)(wait / 1000000000u);
+        ts.tv_nsec = (long)(wait % 1000000000u);
+
+        if ((ppoll(pfd, 2, &ts, NULL) > 0) && (0 != (pfd[0].revents & POLLIN)))
+        {
+            while (read(line->wake[0], drain, sizeof(drain)) > 0)
+            {
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @brief  connect the far end of a UART line to a descriptor
+  * @param huart UART handle
+  * @param fd descriptor, non-blocking
+  * @retval None
+  */
+void Host_UartAttach(UART_HandleTypeDef *huart, int fd)
+{
+    HostUart_t *line = Host_UartLine(huart);
+    pthread_t thread;
+    sigset_t all;
+    sigset_t old;
+
+    if ((NULL == line) || (line->fd >= 0) || (fd < 0))
+    {
+        return;
+    }
+    if (0 != pipe2(line->wake, O_NONBLOCK | O_CLOEXEC))
+    {
+        return;
+    }
+    line->fd = fd;
+
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    if (0 != pthread_create(&thread, NULL, Host_UartThread, line))
+    {
+        line->fd = -1;
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+}
+
+/**
+  * @brief  frame time of a UART
+  * @param huart UART handle
+  * @retval nanoseconds per byte
+  */
+uint32_t Host_UartCharTime(UART_HandleTypeDef *huart)
+{
+    HostUart_t *line = Host_UartLine(huart);
+
+    return (NULL != line) ? (uint32_t)line->charNs : 0;
+}
+
+/**
+  * @brief  queue bytes on the line, as a DMA transfer would feed the transmitter
+  * @note   returns at once; the bytes leave one frame time apart
+  * @param huart UART handle
+  * @param data bytes to send
+  * @param len number of bytes
+  * @param done set to the time the stop bit of the last byte ends
+  * @retval bytes queued, less than len only while earlier output is still on the wire
+  */
+size_t Host_UartSend(UART_HandleTypeDef *huart, const uint8_t *data, size_t len, uint64_t *done)
+{
+    HostUart_t *line = Host_UartLine(huart);
+    uint64_t now = Host_Now();
+    size_t sent = 0;
+    uint32_t head;
+    uint32_t room;
+
+    if (NULL == line)
+    {
+        *done = now;
+        return len;
+    }
+
+    taskENTER_CRITICAL();
+    if (line->txFreeAt < now)
+    {
+        line->txFreeAt = now;
+    }
+
+    if (line->fd < 0)
+    {
+        // nothing connected: the bytes still take their time on the pin
+        line->txFreeAt += (uint64_t)len * line->charNs;
+        line->stats.txBytes += len;
+        line->stats.txLost += len;
+        sent = len;
+    }
+    else
+    {
+        head = line->txHead;
+        room = HOST_UART_RING - (head - __atomic_load_n(&line->txTail, __ATOMIC_ACQUIRE));
+        while ((sent < len) && (0 != room))
+        {
+            line->txFreeAt += line->charNs;
+            line->txData[head & (HOST_UART_RING - 1)] = data[sent];
+            line->txDue[head & (HOST_UART_RING - 1)] = line->txFreeAt;
+            head++;
+            room--;
+            sent++;
+        }
+        __atomic_store_n(&line->txHead, head, __ATOMIC_RELEASE);
+    }
+    *done = line->txFreeAt;
+    taskEXIT_CRITICAL();
+
+    if ((line->fd >= 0) && (0 != sent))
+    {
+        (void)write(line->wake[1], "", 1);
+    }
+    return sent;
+}
+
+/**
+  * @brief  take received bytes, as a DMA transfer would empty the receiver
+  * @param huart UART handle
+  * @param data destination
+  * @param len maximum number of bytes
+  * @retval bytes taken
+  */
+size_t Host_UartRecv(UART_HandleTypeDef *huart, uint8_t *data, size_t len)
+{
+    HostUart_t *line = Host_UartLine(huart);
+    uint32_t tail;
+    size_t count = 0;
+
+    if (NULL == line)
+    {
+        return 0;
+    }
+
+    taskENTER_CRITICAL();
+    tail = line->rxTail;
+    while ((count < len) && (tail != __atomic_load_n(&line->rxHead, __ATOMIC_ACQUIRE)))
+    {
+        data[count++] = line->rxData[tail & (HOST_UART_RING - 1)];
+        tail++;
+    }
+    __atomic_store_n(&line->rxTail, tail, __ATOMIC_RELEASE);
+    line->stats.rxBytes += count;
+    taskEXIT_CRITICAL();
+
+    return count;
+}
+
+/**
+  * @brief  move what landed since the last look through the holding register
+  * @note   the first byte fills RDR if it was empty, every later one overruns
+  * @param line line
+  * @retval None
+  */
+static void Host_UartRxLatch(HostUart_t *line)
+{
+    uint32_t tail = line->rxTail;
+
+    while (tail != __atomic_load_n(&line->rxHead, __ATOMIC_ACQUIRE))
+    {
+        if (line->rxne)
+        {
+            if (!line->ore)
+            {
+                line->stats.rxOverruns++;
+            }
+            line->ore = true;
+            line->stats.rxLost++;
+        }
+        else
+        {
+            line->rdr = line->rxData[tail & (HOST_UART_RING - 1)];
+            line->rxne = true;
+        }
+        tail++;
+    }
+    __atomic_store_n(&line->rxTail, tail, __ATOMIC_RELEASE);
+}
+
+/**
+  * @brief  copy a simulated counter snapshot
+  * @param huart UART handle
+  * @param stats destination, zeroed for an unknown instance
+  * @retval None
+  */
+void Host_UartStats(UART_HandleTypeDef *huart, HostUartStats_t *stats)
+{
+    HostUart_t *line = Host_UartLine(huart);
+
+    memset(stats, 0, sizeof(*stats));
+    if (NULL != line)
+    {
+        taskENTER_CRITICAL();
+        *stats = line->stats;
+        taskEXIT_CRITICAL();
+    }
+}
+
+/* HAL -----------------------------------------------------------------------*/
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+    HostUart_t *line = Host_UartLine(huart);
+    uint32_t bits = 1u + ((UART_WORDLENGTH_9B == huart->Init.WordLength) ? 9u : 8u) + ((UART_STOPBITS_2 == huart->Init.StopBits) ? 2u : 1u);
+
+    if ((NULL == line) || (0 == huart->Init.BaudRate))
+    {
+        return HAL_ERROR;
+    }
+
+    taskENTER_CRITICAL();
+    line->charNs = ((uint64_t)bits * 1000000000u + huart->Init.BaudRate / 2u) / huart->Init.BaudRate;
+    line->cts = (0u != (huart->Init.HwFlowCtl & UART_HWCONTROL_CTS));
+    line->rxne = false;
+    line->ore = false;
+    taskEXIT_CRITICAL();
+
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef *huart)
+{
+    huart->gState = HAL_UART_STATE_RESET;
+    huart->RxState = HAL_UART_STATE_RESET;
+    return HAL_OK;
+}
+
+/**
+  * @brief  polled transmission: every byte waits for TXE, the call waits for TC
+  * @param huart UART handle
+  * @param pData bytes to send
+  * @param Size number of bytes
+  * @param Timeout ms, HAL_MAX_DELAY for none
+  * @retval HAL_OK, HAL_TIMEOUT or HAL_BUSY
+  */
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    HostUart_t *line = Host_UartLine(huart);
+    uint64_t deadline = Host_Now() + (uint64_t)Timeout * 1000000u;
+    uint64_t done = 0;
+
+    if ((NULL == line) || (HAL_UART_STATE_READY != huart->gState))
+    {
+        return HAL_BUSY;
+    }
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+
+    for (uint16_t i = 0; i < Size; i++)
+    {
+        // TXE: the transmitter holds the byte being shifted out and at most one more
+        for (;;)
+        {
+            uint64_t now = Host_Now();
+            uint64_t freeAt = line->txFreeAt;
+
+            if ((freeAt <= now + line->charNs) && (1 == Host_UartSend(huart, &pData[i], 1, &done)))
+            {
+                break;
+            }
+            if ((HAL_MAX_DELAY != Timeout) && (now >= deadline))
+            {
+                huart->TxXferCount = Size - i;
+                huart->gState = HAL_UART_STATE_READY;
+                return HAL_TIMEOUT;
+            }
+            Host_UartSleep((freeAt > now + line->charNs) ? (freeAt - now - line->charNs) : line->charNs);
+        }
+    }
+
+    // TC: the last stop bit has ended
+    for (uint64_t now = Host_Now(); now < done; now = Host_Now())
+    {
+        Host_UartSleep(done - now);
+    }
+
+    huart->gState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+/**
+  * @brief  polled reception through the holding register
+  * @note   the caller spins on RXNE while inside, so nothing overruns then;
+  *         bytes that landed before the call went through the holding
+  *         register unread, the first is waiting and the rest overran
+  * @param huart UART handle
+  * @param pData destination
+  * @param Size number of bytes
+  * @param Timeout ms, HAL_MAX_DELAY for none
+  * @retval HAL_OK, HAL_TIMEOUT or HAL_BUSY
+  */
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    HostUart_t *line = Host_UartLine(huart);
+    uint64_t deadline = Host_Now() + (uint64_t)Timeout * 1000000u;
+
+    if ((NULL == line) || (HAL_UART_STATE_READY != huart->RxState))
+    {
+        return HAL_BUSY;
+    }
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+
+    taskENTER_CRITICAL();
+    Host_UartRxLatch(line);
+    taskEXIT_CRITICAL();
+
+    for (uint16_t i = 0; i < Size; i++)
+    {
+        for (;;)
+        {
+            bool taken = false;
+
+            taskENTER_CRITICAL();
+            if (line->rxne)
+            {
+                // reading SR then DR clears RXNE and ORE
+                pData[i] = line->rdr;
+                line->rxne = false;
+                line->ore = false;
+                taken = true;
+            }
+            else if (line->rxTail != __atomic_load_n(&line->rxHead, __ATOMIC_ACQUIRE))
+            {
+                pData[i] = line->rxData[line->rxTail & (HOST_UART_RING - 1)];
+                __atomic_store_n(&line->rxTail, line->rxTail + 1u, __ATOMIC_RELEASE);
+                taken = true;
+            }
+            line->stats.rxBytes += taken ? 1u : 0u;
+            taskEXIT_CRITICAL();
+
+            if (taken)
+            {
+                break;
+            }
+            if ((HAL_MAX_DELAY != Timeout) && (Host_Now() >= deadline))
+            {
+                huart->RxState = HAL_UART_STATE_READY;
+                return HAL_TIMEOUT;
+            }
+            Host_UartSleep(line->charNs);
+        }
+    }
+
+    huart->RxState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+/**
+  * @brief  show the simulated UART lines
+  * @param handle shell handle
+  * @param argc argument count
+  * @param argv argument vector
+  * @retval None
+  */
+void shell_cmd_link(Shell_Handle_t *handle, int argc, char *argv[])
+{
+    char buf[160];
+
+    for (uint32_t i = 0; i < HOST_UART_LINES; i++)
+    {
+        HostUart_t *line = &hostUarts[i];
+        HostUartStats_t stats;
+
+        if (0 == line->charNs)
+        {
+            continue;
+        }
+
+        taskENTER_CRITICAL();
+        stats = line->stats;
+        taskEXIT_CRITICAL();
+
+        snprintf(buf, sizeof(buf), "%-6s %s, %lu.%lu us/byte, tx %lu (lost %lu), rx %lu, overruns %lu (lost %lu)\r\n",
+                 line->name, (line->fd >= 0) ? "attached" : "open",
+                 (unsigned long)(line->charNs / 1000u), (unsigned long)((line->charNs % 1000u) / 100u),
+                 (unsigned long)stats.txBytes, (unsigned long)stats.txLost, (unsigned long)stats.rxBytes,
+                 (unsigned long)stats.rxOverruns, (unsigned long)stats.rxLost);
+        sh_print(handle, buf);
+    }
+}
+SHELL_COMMAND(link, "Show the simulated UART lines of the host build", "link", shell_cmd_link);
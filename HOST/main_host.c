@@ -0,0 +1,122 @@
+/*
+ * Host entry point, the counterpart of Core/Src/main.c.
+ *
+ *   destroshell_host [-t dma|poll] [link [aux-link]]
+ *
+ * prints the pseudo-terminal the shell listens on; with link, also points
+ * that symlink at it so scripts have a fixed path, e.g.
+ *
+ *   ./destroshell_host /tmp/destroshell &
+ *   picocom /tmp/destroshell
+ *
+ * With aux-link a second session runs on the simulated USART6, as the
+ * automation channel does on the board.
+ *
+ * -t picks the shell transport on the simulated UARTs: dma (the default,
+ * shellUartDma) or poll (shellUartPoll).
+ */
+#include <destroshell.h>
+#include <shell_uart.h>
+#include <shell_top.h>
+#include <host.h>
+#include <unistd.h>
+
+/* Private variables ---------------------------------------------------------*/
+UART_HandleTypeDef shellUSART;
+UART_HandleTypeDef auxUSART;
+Shell_Handle_t shellHandle;
+Shell_Handle_t auxHandle;
+static ShellUartLink_t shellLink = { .huart = &shellUSART };
+static ShellUartLink_t auxLink = { .huart = &auxUSART };
+static ShellUartPollLink_t shellPollLink = { .huart = &shellUSART };
+static ShellUartPollLink_t auxPollLink = { .huart = &auxUSART };
+static bool hostPolled = false;
+
+/**
+  * @brief  bring up a UART line on a pseudo-terminal and a shell session on it
+  * @param handle session
+  * @param huart UART handle
+  * @param instance USART the line simulates
+  * @param path symlink to the pseudo-terminal, NULL for none
+  * @param dmaLink link for shellUartDma
+  * @param pollLink link for shellUartPoll
+  * @retval false if the pseudo-terminal could not be opened
+  */
+static bool Host_Session(Shell_Handle_t *handle, UART_HandleTypeDef *huart, USART_TypeDef *instance,
+                         const char *path, ShellUartLink_t *dmaLink, ShellUartPollLink_t *pollLink)
+{
+    const ShellTransport_t *transport = hostPolled ? &shellUartPoll : &shellUartDma;
+    const char *name;
+
+    // same settings as MX_USART2_UART_Init, they give the simulated line its timing
+    huart->Instance = instance;
+    huart->Init.BaudRate = 115200;
+    huart->Init.WordLength = UART_WORDLENGTH_8B;
+    huart->Init.StopBits = UART_STOPBITS_1;
+    huart->Init.Parity = UART_PARITY_NONE;
+    huart->Init.Mode = UART_MODE_TX_RX;
+    huart->Init.HwFlowCtl = UART_HWCONTROL_NONE;
+    huart->Init.OverSampling = UART_OVERSAMPLING_16;
+    (void)HAL_UART_Init(huart);
+
+    name = Shell_PtyOpen(huart, path);
+    if (NULL == name)
+    {
+        perror("destroshell: pseudo-terminal");
+        return false;
+    }
+    printf("destroshell on %s, %s\n", name, transport->name);
+    fflush(stdout);
+
+    /* Initialize shell */
+    Shell_Init(handle, transport, hostPolled ? (void *)pollLink : (void *)dmaLink);
+
+    /* Create shell task */
+    xTaskCreate(Shell_Task, "Shell", configMINIMAL_STACK_SIZE, handle, 1, NULL);
+    xTaskCreate(vUartTask, "UART", configMINIMAL_STACK_SIZE, handle, 1, NULL);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+
+    Host_Init(argc, argv);
+
+    while (-1 != (opt = getopt(argc, argv, "t:")))
+    {
+        if (('t' == opt) && (0 == strcmp(optarg, "poll")))
+        {
+            hostPolled = true;
+        }
+        else if (('t' != opt) || (0 != strcmp(optarg, "dma")))
+        {
+            fprintf(stderr, "usage: %s [-t dma|poll] [link [aux-link]]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (!Host_Session(&shellHandle, &shellUSART, USART2, (optind < argc) ? argv[optind] : NULL,
+                      &shellLink, &shellPollLink))
+    {
+        return 1;
+    }
+    if ((optind + 1 < argc) &&
+        !Host_Session(&auxHandle, &auxUSART, USART6, argv[optind + 1], &auxLink, &auxPollLink))
+    {
+        return 1;
+    }
+
+    vTaskStartScheduler();
+    return 0;
+}
+
+/**
+  * @brief  FreeRTOS tick hook
+  * @note   reads the run time counter every tick so its CYCCNT extension never misses a wrap
+  * @retval None
+  */
+void vApplicationTickHook(void)
+{
+    (void)Shell_TopCounter();
+}
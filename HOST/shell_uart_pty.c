@@ -0,0 +1,293 @@
+/*
+ * Shell UARTs on pseudo-terminals, replaces PROJECT/destroshell/shell_uart.c
+ * in the host build; shellUartDma runs on top of it unchanged.
+ *
+ * Each pseudo-terminal is the far end of a simulated UART line
+ * (host_uart.c), so bytes move at the baud rate its init sets. The polled
+ * transport (shellUartPoll) uses the same line through
+ * HAL_UART_Transmit/Receive and needs none of this file but Shell_PtyOpen.
+ * A PTY task per line stands in for the UART interrupts and DMA: every tick it
+ * pushes what the receiver took into rxStream, and once the line has sent
+ * a TX block it retires it, chains the next one and gives txDone like the
+ * TX complete interrupt. Interrupt latency is therefore up to one tick.
+ */
+#include <shell_uart.h>
+#include <host.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* Configuration constants */
+#define PTY_FD_ENV "DESTROSHELL_PTY_FD%lu"  /* Master descriptors handed over a reset, in open order */
+#define PTY_TASK_PRIORITY (configMAX_PRIORITIES - 1)  /* Above every task, as an interrupt */
+
+typedef struct {
+    UART_HandleTypeDef *huart;          /* Line the pseudo-terminal is the far end of */
+    int fd;                             /* Master side */
+    int slaveFd;                        /* Held open, see Shell_PtyOpen */
+    ShellUartLink_t *link;              /* Shell link on the line, set by Shell_UartInit */
+    TaskHandle_t task;
+    uint64_t txDone;                    /* When the block in flight has left the line */
+} ShellPty_t;
+
+/* Private variables ----------------------------------------------------------*/
+static ShellPty_t ptys[SHELL_UART_LINKS];
+static uint32_t ptyCount;
+
+/**
+  * @brief  find the pseudo-terminal on a UART
+  * @param huart UART handle
+  * @retval pseudo-terminal or NULL if Shell_PtyOpen was not called for it
+  */
+static ShellPty_t *Shell_Pty(UART_HandleTypeDef *huart)
+{
+    for (uint32_t i = 0; i < ptyCount; i++)
+    {
+        if (huart == ptys[i].huart)
+        {
+            return &ptys[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @brief  open a pseudo-terminal, or take over the one from before a reset,
+  *         and make it the far end of a UART line
+  * @param huart UART handle, initialized
+  * @param link path of a symlink to the slave side, NULL for none
+  * @retval slave device name, NULL on failure
+  */
+const char *Shell_PtyOpen(UART_HandleTypeDef *huart, const char *link)
+{
+    ShellPty_t *pty;
+    const char *inherited;
+    struct termios tio;
+    char env[32];
+    char fd[16];
+    char *name;
+
+    if (ptyCount >= SHELL_UART_LINKS)
+    {
+        return NULL;
+    }
+    pty = &ptys[ptyCount];
+
+    snprintf(env, sizeof(env), PTY_FD_ENV, (unsigned long)ptyCount);
+    inherited = getenv(env);
+    if (NULL != inherited)
+    {
+        pty->fd = atoi(inherited);
+    }
+    else
+    {
+        // no O_CLOEXEC: the descriptor survives the exec of a reset
+        pty->fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if ((pty->fd < 0) || (0 != grantpt(pty->fd)) || (0 != unlockpt(pty->fd)))
+        {
+            return NULL;
+        }
+        snprintf(fd, sizeof(fd), "%d", pty->fd);
+        setenv(env, fd, 1);
+    }
+
+    name = ptsname(pty->fd);
+    if (NULL == name)
+    {
+        return NULL;
+    }
+
+    // a slave that stays open keeps the master from failing while no client is attached
+    pty->slaveFd = open(name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (pty->slaveFd < 0)
+    {
+        return NULL;
+    }
+    if (0 == tcgetattr(pty->slaveFd, &tio))
+    {
+        cfmakeraw(&tio);
+        (void)tcsetattr(pty->slaveFd, TCSANOW, &tio);
+    }
+    (void)fcntl(pty->fd, F_SETFL, fcntl(pty->fd, F_GETFL) | O_NONBLOCK);
+
+    if (NULL != link)
+    {
+        (void)unlink(link);
+        if (0 != symlink(name, link))
+        {
+            perror("destroshell: symlink");
+        }
+    }
+    Host_UartAttach(huart, pty->fd);
+    pty->huart = huart;
+    ptyCount++;
+    return name;
+}
+
+/**
+  * @brief  start a DMA-like transfer of the next contiguous block of the TX ring
+  * @note   caller must guarantee no block is in flight, in a critical section
+  * @param link UART link
+  * @retval None
+  */
+static void Shell_PtyTxStart(ShellUartLink_t *link)
+{
+    ShellPty_t *pty = Shell_Pty(link->huart);
+    uint32_t pending = link->txHead - link->txTail;
+    uint32_t start = link->txTail & (SHELL_TX_BUFFER_SIZE - 1);
+    uint32_t len = SHELL_TX_BUFFER_SIZE - start;
+
+    if (len > pending)
+    {
+        len = pending;
+    }
+
+    link->txDmaLen = (uint16_t)Host_UartSend(link->huart, &link->txBuffer[start], len, &pty->txDone);
+}
+
+/**
+  * @brief  PTY task, does the work of the UART interrupts and DMA
+  * @param pvParameters pseudo-terminal
+  * @retval None
+  */
+static void Shell_PtyTask(void *pvParameters)
+{
+    ShellPty_t *pty = (ShellPty_t *)pvParameters;
+    ShellUartLink_t *link = pty->link;
+    uint8_t burst[SHELL_RX_DMA_SIZE];
+
+    for (;;)
+    {
+        size_t len = Host_UartRecv(link->huart, burst, sizeof(burst));
+        bool retired = false;
+
+        if (0 != len)
+        {
+            size_t sent = xStreamBufferSend(link->rxStream, burst, len, 0);
+            link->stats.rxDropped += (uint32_t)(len - sent);
+        }
+
+        // TX complete: retire the block
+        taskENTER_CRITICAL();
+        if ((0 != link->txDmaLen) && (Host_Now() >= pty->txDone))
+        {
+            link->txTail += link->txDmaLen;
+            link->txDmaLen = 0;
+            retired = true;
+        }
+        taskEXIT_CRITICAL();
+
+        // everything written meanwhile goes out as one block
+        Shell_UartTxKick(link);
+
+        if (retired && (NULL != link->txDone))
+        {
+            xSemaphoreGive(link->txDone);
+        }
+
+        // a full burst means more is waiting
+        if (len < sizeof(burst))
+        {
+            vTaskDelay(1);
+        }
+    }
+}
+
+/**
+  * @brief  bind the link to the pseudo-terminal of its UART and reset the RX/TX state
+  * @param link UART link, its line attached by Shell_PtyOpen
+  * @retval true, false when the UART has no pseudo-terminal
+  */
+bool Shell_UartInit(ShellUartLink_t *link)
+{
+    ShellPty_t *pty = Shell_Pty(link->huart);
+
+    if (NULL == pty)
+    {
+        return false;
+    }
+    pty->link = link;
+
+    link->rxDmaPos = 0;
+    memset(&link->stats, 0, sizeof(link->stats));
+    link->txHead = 0;
+    link->txTail = 0;
+    link->txDmaLen = 0;
+    return true;
+}
+
+/**
+  * @brief  start reception: create the PTY task
+  * @param link UART link
+  * @retval None
+  */
+void Shell_UartStartRx(ShellUartLink_t *link)
+{
+    ShellPty_t *pty = Shell_Pty(link->huart);
+
+    if ((NULL != pty) && (NULL == pty->task))
+    {
+        xTaskCreate(Shell_PtyTask, "PTY", configMINIMAL_STACK_SIZE, pty, PTY_TASK_PRIORITY, &pty->task);
+    }
+}
+
+/**
+  * @brief  reprogram the line, the PTY task carries on at the new frame time
+  * @param link UART link
+  * @param init new settings
+  * @retval true if the line accepted them
+  */
+bool Shell_UartConfigure(ShellUartLink_t *link, const UART_InitTypeDef *init)
+{
+    link->huart->Init = *init;
+    return (HAL_OK == HAL_UART_Init(link->huart));
+}
+
+/**
+  * @brief  start draining the TX ring unless a transfer is already in flight
+  * @param link UART link
+  * @retval None
+  */
+void Shell_UartTxKick(ShellUartLink_t *link)
+{
+    // the PTY task kicks without the TX lock: a writer dropping the oldest
+    // output must never see a claimed but unstarted block, so the block
+    // starts in the critical section (Host_UartSend nests)
+    taskENTER_CRITICAL();
+    if ((0 == link->txDmaLen) && (link->txHead != link->txTail))
+    {
+        Shell_PtyTxStart(link);
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+  * @brief  push everything left in the TX ring out by polling, without the scheduler
+  * @param link UART link
+  * @retval None
+  */
+void Shell_UartTxDrain(ShellUartLink_t *link)
+{
+    UART_HandleTypeDef *huart = link->huart;
+
+    // the block in flight is already on the line
+    link->txTail += link->txDmaLen;
+    link->txDmaLen = 0;
+    huart->gState = HAL_UART_STATE_READY;
+
+    while (link->txHead != link->txTail)
+    {
+        uint32_t pending = link->txHead - link->txTail;
+        uint32_t start = link->txTail & (SHELL_TX_BUFFER_SIZE - 1);
+        uint32_t len = SHELL_TX_BUFFER_SIZE - start;
+
+        if (len > pending)
+        {
+            len = pending;
+        }
+
+        (void)HAL_UART_Transmit(huart, &link->txBuffer[start], (uint16_t)len, HAL_MAX_DELAY);
+        link->txTail += len;
+    }
+}
@@ -45,16 +45,23 @@
 #if defined( __ICCARM__) || defined(__GNUC__) || defined(__CC_ARM)
 	#include <stdint.h>
 	extern uint32_t SystemCoreClock;
+	extern void Shell_TopTimerInit( void );
+	extern uint32_t Shell_TopCounter( void );
+	extern void *pvShellTopLastTask;
+	extern volatile uint32_t ulShellHeapTraceOn;
+	extern void Shell_HeapTraceMalloc( void *pvAddress, void *pvCaller );
+	extern void Shell_HeapTraceFree( void *pvAddress, uint32_t ulSize );
 #endif
 
 #define configUSE_PREEMPTION			1
 #define configUSE_IDLE_HOOK				0
-#define configUSE_TICK_HOOK				0
+#define configUSE_TICK_HOOK				1
 #define configCPU_CLOCK_HZ				( SystemCoreClock )
 #define configTICK_RATE_HZ				( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES			( 5 )
 #define configMINIMAL_STACK_SIZE		( ( unsigned short ) 130 )
 #define configTOTAL_HEAP_SIZE			( ( size_t ) ( 100  * 1024 ) )
+#define configAPPLICATION_ALLOCATED_HEAP	1	/* ucHeap is in shell_heap.c so heap frag can walk it */
 #define configMAX_TASK_NAME_LEN			( 10 )
 #define configUSE_TRACE_FACILITY		1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    1
@@ -65,9 +72,9 @@
 #define configCHECK_FOR_STACK_OVERFLOW	0
 #define configUSE_RECURSIVE_MUTEXES		1
 #define configUSE_MALLOC_FAILED_HOOK	0
-#define configUSE_APPLICATION_TASK_TAG	0
+#define configUSE_APPLICATION_TASK_TAG	1
 #define configUSE_COUNTING_SEMAPHORES	1
-#define configGENERATE_RUN_TIME_STATS	0
+#define configGENERATE_RUN_TIME_STATS	1
 #define configSUPPORT_DYNAMIC_ALLOCATION    1
 
 
@@ -92,6 +99,7 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelay				1
 
 #define INCLUDE_xTaskGetIdleTaskHandle  1
+#define INCLUDE_xTaskGetSchedulerState  1
 #define INCLUDE_pxTaskGetStackStart		1
 
 /* Cortex-M specific definitions. */
@@ -129,7 +137,106 @@ standard names. */
 #define xPortPendSVHandler PendSV_Handler
 #define xPortSysTickHandler SysTick_Handler
 
+/* Run time stats are clocked from the DWT cycle counter, extended past its
+32-bit wrap and scaled down by 16 so the counters wrap every ~400 s at
+168 MHz instead of every 25 s (see shell_top.c). The tick hook keeps the
+extension ahead of CYCCNT. */
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()	Shell_TopTimerInit()
+#define portGET_RUN_TIME_COUNTER_VALUE()			Shell_TopCounter()
+
 #include "SEGGER_SYSVIEW_FreeRTOS.h"
 
+/* Built-in trace recorder, see shell_trace.h. It takes over queue
+send/receive from SystemView, which keeps every other event; set
+configUSE_SHELL_TRACE to 0 to hand them back when a J-Link is attached.
+Task switch-in is shared with SystemView, see below. */
+#ifndef configUSE_SHELL_TRACE
+	#define configUSE_SHELL_TRACE		1
+#endif
+
+#if defined( __ICCARM__) || defined(__GNUC__) || defined(__CC_ARM)
+	#include "shell_trace.h"
+#endif
+
+/* MPU stack guard, see shell_guard.c. One MPU region is a 32-byte read-only
+window over the bottom of the running task's stack, so a push past the end
+faults into MemManage_Handler instead of corrupting the heap. Moving it costs
+one MPU_RBAR store per context switch (RBAR with VALID set selects the region
+too). Tasks start with the guard at the first 32-byte boundary of pxStack. */
+#ifndef configUSE_SHELL_STACK_GUARD
+	#define configUSE_SHELL_STACK_GUARD		1
+#endif
+#define configSHELL_STACK_GUARD_REGION		7
+#define configSHELL_STACK_GUARD_SIZE		32
+
+/* Shell over SEGGER RTT, see shell_rtt.h. When a debugger is attached at
+boot the shell talks on RTT channel 0 instead of USART2, which is then free
+for "init usart". Set configUSE_SHELL_RTT to 1 to build it in. */
+#ifndef configUSE_SHELL_RTT
+	#define configUSE_SHELL_RTT		0
+#endif
+
+#if ( configUSE_SHELL_STACK_GUARD == 1 )
+	#define shellSTACK_GUARD( pxStack )		( *( ( volatile uint32_t * ) 0xE000ED9CUL ) = ( ( ( uint32_t ) ( pxStack ) + ( configSHELL_STACK_GUARD_SIZE - 1UL ) ) & ~( configSHELL_STACK_GUARD_SIZE - 1UL ) ) | 0x10UL | configSHELL_STACK_GUARD_REGION )
+#else
+	#define shellSTACK_GUARD( pxStack )
+#endif
+
+/* Task switch-in is shared by the trace recorder, the stack guard and
+SystemView. The hook is redefined when either shell feature is on and ends
+with Shell_TraceSysviewTaskIn (shell_trace.c), which reports the switch
+through SystemView's API, so a J-Link session still sees every switch. */
+#if ( configUSE_SHELL_TRACE == 1 ) || ( configUSE_SHELL_STACK_GUARD == 1 )
+	#undef traceTASK_SWITCHED_IN
+	#define traceTASK_SWITCHED_IN()				shellSTACK_GUARD( pxCurrentTCB->pxStack ); SHELL_TRACE( SHELL_TRACE_TASK_IN, 0, pxCurrentTCB->uxTCBNumber ); Shell_TraceSysviewTaskIn()
+#endif
+
+#if ( configUSE_SHELL_TRACE == 1 )
+	#undef traceQUEUE_SEND
+	#undef traceQUEUE_SEND_FROM_ISR
+	#undef traceQUEUE_RECEIVE
+	#undef traceQUEUE_RECEIVE_FROM_ISR
+	#define traceQUEUE_SEND( pxQueue )			SHELL_TRACE( SHELL_TRACE_QUEUE_SEND, ( pxQueue )->uxMessagesWaiting, SHELL_TRACE_QUEUE_ID( pxQueue ) )
+	#define traceQUEUE_SEND_FROM_ISR( pxQueue )	SHELL_TRACE( SHELL_TRACE_QUEUE_SEND_ISR, ( pxQueue )->uxMessagesWaiting, SHELL_TRACE_QUEUE_ID( pxQueue ) )
+	#define traceQUEUE_RECEIVE( pxQueue )		SHELL_TRACE( SHELL_TRACE_QUEUE_RECEIVE, ( pxQueue )->uxMessagesWaiting, SHELL_TRACE_QUEUE_ID( pxQueue ) )
+	#define traceQUEUE_RECEIVE_FROM_ISR( pxQueue )	SHELL_TRACE( SHELL_TRACE_QUEUE_RECEIVE_ISR, ( pxQueue )->uxMessagesWaiting, SHELL_TRACE_QUEUE_ID( pxQueue ) )
+#endif
+
+/* Allocation tracing, see shell_heap.c. heap_4 expands traceMALLOC inside
+pvPortMalloc with the scheduler suspended, so the return address is the
+call site and the trace tables need no lock of their own. Set
+configUSE_SHELL_HEAP_TRACE to 0 to compile the hooks and heap trace out. */
+#ifndef configUSE_SHELL_HEAP_TRACE
+	#define configUSE_SHELL_HEAP_TRACE	1
+#endif
+
+#if ( configUSE_SHELL_HEAP_TRACE == 1 )
+	#undef traceMALLOC
+	#undef traceFREE
+	#define traceMALLOC( pvAddress, uiSize )															\
+		if( 0 != ulShellHeapTraceOn )																	\
+		{																								\
+			Shell_HeapTraceMalloc( ( pvAddress ), __builtin_return_address( 0 ) );						\
+		}
+	#define traceFREE( pvAddress, uiSize )																\
+		if( 0 != ulShellHeapTraceOn )																	\
+		{																								\
+			Shell_HeapTraceFree( ( pvAddress ), ( uint32_t ) ( uiSize ) );								\
+		}
+#endif
+
+/* Context switches into each task are counted in its application task tag,
+so tasks must not set a tag of their own. The hook runs when a task is
+switched out; a task other than the one seen last time was switched in.
+pvShellTopLastTask is only compared, never dereferenced, so a deleted task
+is harmless. The trace recorder logs every switch out. */
+#define traceTASK_SWITCHED_OUT()																\
+	if( pvShellTopLastTask != ( void * ) pxCurrentTCB )											\
+	{																							\
+		pxCurrentTCB->pxTaskTag = ( TaskHookFunction_t ) ( ( portPOINTER_SIZE_TYPE ) pxCurrentTCB->pxTaskTag + 1 );	\
+		pvShellTopLastTask = ( void * ) pxCurrentTCB;											\
+	}																							\
+	SHELL_TRACE( SHELL_TRACE_TASK_OUT, 0, pxCurrentTCB->uxTCBNumber )
+
 #endif /* FREERTOS_CONFIG_H */
 
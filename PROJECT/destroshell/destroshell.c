@@ -1,9 +1,14 @@
 #include <destroshell.h>
+#include <shell_complete.h>
+#include <shell_perf.h>
+#include <shell_prof.h>
+#include <shell_guard.h>
+#include <shell_rpc.h>
 
 /* Private variables ----------------------------------------------------------*/
-static Shell_Handle_t *globalShellHandle = NULL;
-ShellCommand_t shellCommands[SHELL_MAX_COMMANDS];
-uint8_t commandCount = 0;
+static uint16_t commandIndex[1u << SHELL_CMD_HASH_BITS];   /* Name hash -> table entry + 1 */
+static bool commandIndexReady = false;
+static SemaphoreHandle_t sharedLocks[SHELL_LOCK_COUNT];     /* See ShellLock_t */
 
 /**
   * @brief  reset timer callback
@@ -15,23 +20,90 @@ static void vResetTimerCallback(TimerHandle_t xTimer)
     Shell_Handle_t *handle = (Shell_Handle_t *)pvTimerGetTimerID(xTimer);
     if (SET == handle->resetPending) 
     {
+        sh_print(handle, "\r\nResetting...\r\n");
+        sh_flush(handle, pdMS_TO_TICKS(SHELL_TX_FLUSH_TIMEOUT));
         NVIC_SystemReset();
     }
 }
 
 /**
-  * @brief  shell initialization
+  * @brief  state shared by all sessions, set up by the first Shell_Init
+  * @param handle session to report problems on
+  * @retval None
+  */
+static void Shell_CoreInit(Shell_Handle_t *handle) 
+{
+    for (uint32_t i = 0; i < SHELL_LOCK_COUNT; i++) 
+    {
+        sharedLocks[i] = xSemaphoreCreateMutex();
+        if (NULL == sharedLocks[i]) 
+        {
+            sh_print(handle, "Shell lock creation failed.\r\n");
+        }
+    }
+
+    // Shell_FindCommand relies on the linker sorting; catches duplicate names too
+    for (const ShellCommand_t *cmd = SHELL_COMMANDS_BEGIN + 1; cmd < SHELL_COMMANDS_END; cmd++) 
+    {
+        if (strcmp((cmd - 1)->commandName, cmd->commandName) >= 0) 
+        {
+            sh_print(handle, "Command table is not sorted or has duplicates: ");
+            sh_print(handle, cmd->commandName);
+            sh_print(handle, "\r\n");
+        }
+
+        const char *word = Shell_WordsCheck(cmd->args);
+        if (NULL != word) 
+        {
+            sh_print(handle, "Argument words are not sorted: ");
+            sh_print(handle, cmd->commandName);
+            sh_print(handle, " ");
+            sh_print(handle, word);
+            sh_print(handle, "\r\n");
+        }
+    }
+
+    // the table only exists after linking, so its hash index is built here once
+    if (0 == Shell_HashIndexBuild(commandIndex, SHELL_CMD_HASH_BITS, &SHELL_COMMANDS_BEGIN->nameHash,
+                                  sizeof(ShellCommand_t), SHELL_COMMANDS_END - SHELL_COMMANDS_BEGIN)) 
+    {
+        commandIndexReady = true;
+    }
+    else 
+    {
+        sh_print(handle, "Command hash index too small, raise SHELL_CMD_HASH_BITS\r\n");
+    }
+
+    Shell_PerfInit();
+    Shell_ProfInit();
+    Shell_StackGuardInit();
+    Shell_RpcInit();
+}
+
+/**
+  * @brief  shell initialization, once per session
+  * @note   call before the scheduler starts; the first call also sets up
+  *         what the sessions share
   * @param handle shell handle
-  * @param huart UART handle
+  * @param transport channel the shell talks over, e.g. &shellUartDma
+  * @param link state of that transport, e.g. a ShellUartLink_t
   * @retval None
   */
-void Shell_Init(Shell_Handle_t *handle, UART_HandleTypeDef *huart) 
+void Shell_Init(Shell_Handle_t *handle, const ShellTransport_t *transport, void *link) 
 {
-    handle->huart = huart;
-    handle->queue = xQueueCreate(SHELL_QUEUE_LENGTH, SHELL_QUEUE_ITEM_SIZE);
+    static bool coreReady = false;
+
+    handle->transport = transport;
+    handle->link = link;
+    handle->txLock = xSemaphoreCreateMutex();
+    handle->txPolicy = SHELL_TX_BLOCK;
+    handle->txTimeout = SHELL_TX_TIMEOUT;
+    handle->cmdMessages = xMessageBufferCreate(SHELL_CMD_BUFFER_SIZE);
     handle->bufferIndex = 0;
     handle->resetPending = false;
-    globalShellHandle = handle;
+    handle->rpcMode = false;
+    handle->rpcEscape = 0;
+    handle->rpcOut = NULL;
 
     // Create reset timer
     handle->resetTimer = xTimerCreate("ResetTimer", 
@@ -40,34 +112,96 @@ void Shell_Init(Shell_Handle_t *handle, UART_HandleTypeDef *huart)
                                     (void*)handle,        // Timer ID
                                     vResetTimerCallback);
 
-    if (NULL == handle->queue) 
+    if (NULL == handle->cmdMessages) 
     {
-        sh_print(handle, "Shell queue creation failed.\r\n");
+        sh_print(handle, "Shell command buffer creation failed.\r\n");
         return;
     }
-    
+
+    if (!transport->init(handle)) 
+    {
+        sh_print(handle, "Shell transport ");
+        sh_print(handle, transport->name);
+        sh_print(handle, " failed to start.\r\n");
+        return;
+    }
+
+    if (!coreReady) 
+    {
+        Shell_CoreInit(handle);
+        coreReady = true;
+    }
+
     sh_print(handle, "\r\n➩ ➩ ➩ destroshell v1.0 🢤 🢤 🢤\r\n");
     sh_print(handle, "Type 'help' to see available commands\r\n");
 }
 
 /**
-  * @brief  helper function to parse user input arguments
-  * @param cmd command string with arguments
+  * @brief  split a command line into arguments in place
+  * @note   reentrant; argv entries point into cmd. Arguments are separated by blanks,
+  *         "double" or 'single' quotes group blanks into one argument and a backslash
+  *         takes the next character literally. Escapes do not apply inside single quotes.
+  * @param cmd command string with arguments, modified in place
   * @param argc argument count
-  * @param argv argument vector
+  * @param argv argument vector (SHELL_MAX_ARGS entries)
   * @retval None
   */
 void Shell_ParseArgs(char *cmd, int *argc, char *argv[]) 
 {
+    char *src = cmd;
+    char *dst = cmd;
     *argc = 0;
-    char *token = strtok(cmd, " ");
-    
-    while (token != NULL && *argc < SHELL_MAX_ARGS) 
+
+    // dst never overtakes src, every character read yields at most one written
+    while (*argc < SHELL_MAX_ARGS) 
     {
-        strncpy(argv[*argc], token, SHELL_MAX_ARG_LEN - 1);
-        argv[*argc][SHELL_MAX_ARG_LEN - 1] = '\0';
-        (*argc)++;
-        token = strtok(NULL, " ");
+        while (' ' == *src || '\t' == *src) 
+        {
+            src++;
+        }
+
+        if ('\0' == *src) 
+        {
+            break;
+        }
+
+        argv[(*argc)++] = dst;
+        char quote = '\0';
+
+        while ('\0' != *src) 
+        {
+            char ch = *src++;
+
+            if ('\\' == ch && '\'' != quote && '\0' != *src) 
+            {
+                *dst++ = *src++;
+            }
+            else if ('\0' != quote) 
+            {
+                if (ch == quote) 
+                {
+                    quote = '\0';
+                }
+                else 
+                {
+                    *dst++ = ch;
+                }
+            }
+            else if ('"' == ch || '\'' == ch) 
+            {
+                quote = ch;
+            }
+            else if (' ' == ch || '\t' == ch) 
+            {
+                break;
+            }
+            else 
+            {
+                *dst++ = ch;
+            }
+        }
+
+        *dst++ = '\0';
     }
 }
 
@@ -79,32 +213,203 @@ void Shell_ParseArgs(char *cmd, int *argc, char *argv[])
   */
 void sh_print(Shell_Handle_t *handle, const char *str) 
 {
-    if ((NULL != handle) && (NULL != handle->huart) && (0 != str)) 
+    if (0 != str) 
     {
-        HAL_UART_Transmit(handle->huart, (uint8_t*)str, strlen(str), HAL_MAX_DELAY);
+        sh_write(handle, (const uint8_t*)str, strlen(str));
     }
 }
 
 /**
-  * @brief  register a new command in the shell
-  * @param name command name
-  * @param description command description character array
-  * @param handler command handler function
+  * @brief  hand raw bytes to the transport, returns as soon as it has taken them
+  * @note   blocks only while the transport is full; one writer at a time, so
+  *         the bytes of one call are never interleaved with another's
+  * @param handle shell handle
+  * @param data bytes to send
+  * @param len number of bytes
   * @retval None
   */
-void Shell_RegisterCommand(const char *name, const char *description, const char *usage, void (*handler)(Shell_Handle_t*, int argc, char *argv[])) 
+void sh_write(Shell_Handle_t *handle, const uint8_t *data, size_t len) 
 {
-    if (commandCount < SHELL_MAX_COMMANDS) 
+    if ((NULL == handle) || (NULL == handle->transport) || (NULL == data) || (0 == len)) 
+    {
+        return;
+    }
+
+    bool running = (taskSCHEDULER_RUNNING == xTaskGetSchedulerState());
+    if (running && (NULL != handle->txLock)) 
     {
-        shellCommands[commandCount].commandName = name;
-        shellCommands[commandCount].description = description;
-        shellCommands[commandCount].usage = usage;
-        shellCommands[commandCount].commandHandler = handler;
-        commandCount++;
-    } 
+        xSemaphoreTake(handle->txLock, portMAX_DELAY);
+    }
+
+    // during an RPC call printed text becomes part of the response
+    if (NULL != handle->rpcOut) 
+    {
+        Shell_RpcText(handle, data, len);
+    }
     else 
     {
-        sh_print(globalShellHandle, "Cannot register more commands. Limit reached.\r\n");
+        handle->transport->write(handle, data, len);
+    }
+
+    if (running && (NULL != handle->txLock)) 
+    {
+        xSemaphoreGive(handle->txLock);
+    }
+}
+
+/**
+  * @brief  wait until all written output has left the transport
+  * @param handle shell handle
+  * @param timeout maximum time to wait in ticks
+  * @retval true if nothing is left
+  */
+bool sh_flush(Shell_Handle_t *handle, TickType_t timeout) 
+{
+    if ((NULL == handle) || (NULL == handle->transport)) 
+    {
+        return false;
+    }
+
+    if (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()) 
+    {
+        sh_drain(handle);
+        return true;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    if (pdPASS != xSemaphoreTake(handle->txLock, timeout)) 
+    {
+        return false;
+    }
+
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    bool empty = handle->transport->flush(handle, (elapsed < timeout) ? (timeout - elapsed) : 0);
+    xSemaphoreGive(handle->txLock);
+    return empty;
+}
+
+/**
+  * @brief  push pending output by polling, no RTOS calls; meant for fault and reset paths
+  * @param handle shell handle
+  * @retval None
+  */
+void sh_drain(Shell_Handle_t *handle) 
+{
+    if ((NULL != handle) && (NULL != handle->transport)) 
+    {
+        handle->transport->drain(handle, NULL, 0);
+    }
+}
+
+/**
+  * @brief  change the settings of the UART under the session, e.g. its baud rate
+  * @note   pending output leaves at the old settings first; writers wait meanwhile
+  * @param handle shell handle
+  * @param init new settings of the UART
+  * @retval false if the transport has no UART, output did not drain or the HAL refused
+  */
+bool sh_configure(Shell_Handle_t *handle, const UART_InitTypeDef *init) 
+{
+    bool done = false;
+
+    if ((NULL == handle) || (NULL == handle->transport) || (NULL == handle->transport->configure)) 
+    {
+        return false;
+    }
+
+    if (pdPASS != xSemaphoreTake(handle->txLock, portMAX_DELAY)) 
+    {
+        return false;
+    }
+
+    if (handle->transport->flush(handle, pdMS_TO_TICKS(SHELL_TX_FLUSH_TIMEOUT))) 
+    {
+        done = handle->transport->configure(handle, init);
+    }
+    xSemaphoreGive(handle->txLock);
+    return done;
+}
+
+/**
+  * @brief  look up a command in the link-time command table
+  * @param name command name
+  * @retval command descriptor or NULL if not found
+  */
+const ShellCommand_t *Shell_FindCommand(const char *name) 
+{
+    const ShellCommand_t *low = SHELL_COMMANDS_BEGIN;
+    const ShellCommand_t *high = SHELL_COMMANDS_END;
+
+    if (commandIndexReady) 
+    {
+        int i = Shell_HashIndexFind(commandIndex, SHELL_CMD_HASH_BITS, &SHELL_COMMANDS_BEGIN->nameHash,
+                                    &SHELL_COMMANDS_BEGIN->commandName, sizeof(ShellCommand_t), name);
+        return (i < 0) ? NULL : &SHELL_COMMANDS_BEGIN[i];
+    }
+
+    // binary search until the index exists, the linker keeps the table sorted by name
+    while (low < high) 
+    {
+        const ShellCommand_t *mid = low + (high - low) / 2;
+        int cmp = strcmp(name, mid->commandName);
+
+        if (0 == cmp) 
+        {
+            return mid;
+        }
+        if (cmp < 0) 
+        {
+            high = mid;
+        }
+        else 
+        {
+            low = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @brief  run a command handler, shared by the line editor and RPC calls
+  * @note   handlers of other sessions may run at the same time; what they
+  *         share is guarded by Shell_Lock
+  * @param handle shell handle
+  * @param command command to run
+  * @param argc argument count
+  * @param argv argument vector
+  * @retval None
+  */
+void Shell_RunCommand(Shell_Handle_t *handle, const ShellCommand_t *command, int argc, char *argv[]) 
+{
+    SHELL_PERF_BEGIN(perfStart);
+    command->commandHandler(handle, argc, argv);
+    SHELL_PERF_END(command, perfStart);
+}
+
+/**
+  * @brief  take the lock of state the sessions share
+  * @note   waits as long as the other session needs it; not for interrupts
+  * @param lock state to lock
+  * @retval None
+  */
+void Shell_Lock(ShellLock_t lock) 
+{
+    if (NULL != sharedLocks[lock]) 
+    {
+        xSemaphoreTake(sharedLocks[lock], portMAX_DELAY);
+    }
+}
+
+/**
+  * @brief  release a lock taken with Shell_Lock
+  * @param lock state to unlock
+  * @retval None
+  */
+void Shell_Unlock(ShellLock_t lock) 
+{
+    if (NULL != sharedLocks[lock]) 
+    {
+        xSemaphoreGive(sharedLocks[lock]);
     }
 }
 
@@ -118,55 +423,109 @@ void Shell_RegisterCommand(const char *name, const char *description, const char
 void Shell_Task(void *pvParameters) 
 {
     Shell_Handle_t *handle = (Shell_Handle_t *)pvParameters;
-    char receivedCommand[SHELL_QUEUE_ITEM_SIZE];
+    char receivedCommand[SHELL_MAX_LINE_LEN];
+    size_t receivedLength;
     int argc;
-    char argv[SHELL_MAX_ARGS][SHELL_MAX_ARG_LEN];
-    char *argvPtr[SHELL_MAX_ARGS];
-
-    for (int i = 0; i < SHELL_MAX_ARGS; i++) 
-    {
-        argvPtr[i] = argv[i];
-    }
+    char *argv[SHELL_MAX_ARGS];
 
-    if ((NULL == handle) || (NULL == handle->queue)) 
+    if ((NULL == handle) || (NULL == handle->cmdMessages)) 
     {
         return;
     }
 
     while (1) 
     {
-        if (pdPASS == xQueueReceive(handle->queue, receivedCommand, portMAX_DELAY)) 
+        receivedLength = xMessageBufferReceive(handle->cmdMessages, receivedCommand, sizeof(receivedCommand), portMAX_DELAY);
+        if ((0 != receivedLength) && (SHELL_RPC_TAG == (uint8_t)receivedCommand[0])) 
+        {
+            Shell_RpcFrame(handle, (uint8_t *)&receivedCommand[1], receivedLength - 1);
+        }
+        else if (0 != receivedLength) 
         {
-            if (0 == strlen(receivedCommand)) 
+            receivedCommand[receivedLength - 1] = '\0';
+            Shell_ParseArgs(receivedCommand, &argc, argv);
+
+            if (0 == argc) 
             {
-                sh_print(handle, (const char*)prompt);
+                sh_print(handle, SHELL_PROMPT);
                 continue;
             }
 
-            Shell_ParseArgs(receivedCommand, &argc, argvPtr);
-            bool commandFound = false;
-
-            for (uint8_t i = 0; i < commandCount; i++) 
+            if (!Shell_ExpandArgs(handle, argc, argv)) 
             {
-                if (0 == strcmp(argvPtr[0], shellCommands[i].commandName)) 
-                {
-                    shellCommands[i].commandHandler(handle, argc, argvPtr);
-                    commandFound = true;
-                    break;
-                }
+                sh_print(handle, SHELL_PROMPT);
+                continue;
             }
 
-            if (RESET == commandFound) 
+            const ShellCommand_t *command = Shell_FindCommand(argv[0]);
+
+            if (NULL != command) 
+            {
+                Shell_RunCommand(handle, command, argc, argv);
+            }
+            else 
             {
                 char str[256];
-                sprintf(str, "➩ Unknown command: %s\r\n", receivedCommand);
+                snprintf(str, sizeof(str), "➩ Unknown command: %s\r\n", argv[0]);
                 sh_print(handle, str);
             }
-            sh_print(handle, (const char*)prompt);
+            sh_print(handle, SHELL_PROMPT);
         }
     }
 }
 
+/**
+  * @brief  line editor, handles a single received character
+  * @param handle shell handle
+  * @param ch received character
+  * @retval None
+  */
+static void Shell_ProcessChar(Shell_Handle_t *handle, uint8_t ch) 
+{
+    if (Shell_RpcFeed(handle, ch)) 
+    {
+        return;
+    }
+
+    if ('\t' == ch) 
+    {
+        Shell_CompleteLine(handle);
+        return;
+    }
+
+    sh_write(handle, &ch, 1);
+    
+    if (ch == '\b' || ch == 0x7F) 
+    {
+        if (handle->bufferIndex > 0) 
+        {
+            handle->bufferIndex--;
+            sh_print(handle, "\b \b");
+        }
+        return;
+    }
+    
+    if ('\r' == ch) 
+    {
+        sh_print(handle, "\n");
+        // The terminator travels with the line, so an empty line is a 1 byte message
+        handle->cmdBuffer[handle->bufferIndex] = '\0';
+        xMessageBufferSend(handle->cmdMessages, handle->cmdBuffer, handle->bufferIndex + 1, portMAX_DELAY);
+        handle->bufferIndex = 0;
+        return;
+    }
+    
+    if ('\n' == ch) 
+    {
+        return;
+    }
+    
+    if (handle->bufferIndex < SHELL_MAX_LINE_LEN - 1 && ch >= 32 && ch <= 126) 
+    {
+        handle->cmdBuffer[handle->bufferIndex++] = ch;
+    }
+}
+
 /**
   * @brief  main UART task
   * @param pvParameters A value that is passed as the paramater to the created task.
@@ -177,51 +536,18 @@ void Shell_Task(void *pvParameters)
 void vUartTask(void *pvParameters) 
 {
     Shell_Handle_t *handle = (Shell_Handle_t *)pvParameters;
-    uint8_t ch;
+    uint8_t burst[SHELL_RX_BURST_SIZE];
+    size_t count;
     
-    sh_print(handle, (const char*)prompt);
+    sh_print(handle, SHELL_PROMPT);
 
     while (1) 
     {
-        if (HAL_OK == HAL_UART_Receive(handle->huart, &ch, 1, HAL_MAX_DELAY)) 
+        count = handle->transport->read(handle, burst, sizeof(burst));
+
+        for (size_t i = 0; i < count; i++) 
         {
-            HAL_UART_Transmit(handle->huart, &ch, 1, HAL_MAX_DELAY);
-            
-            if (ch == '\b' || ch == 0x7F) 
-            {
-                if (handle->bufferIndex > 0) 
-                {
-                    handle->bufferIndex--;
-                    sh_print(handle, "\b \b");
-                }
-                continue;
-            }
-            
-            if ('\r' == ch) 
-            {
-                sh_print(handle, "\n");
-                if (handle->bufferIndex > 0) 
-                {
-                    handle->cmdBuffer[handle->bufferIndex] = '\0';
-                    xQueueSend(handle->queue, handle->cmdBuffer, portMAX_DELAY);
-                    handle->bufferIndex = 0;
-                } 
-                else 
-                {
-                    xQueueSend(handle->queue, "", portMAX_DELAY);
-                }
-                continue;
-            }
-            
-            if ('\n' == ch) 
-            {
-                continue;
-            }
-            
-            if (handle->bufferIndex < SHELL_QUEUE_LENGTH - 1 && ch >= 32 && ch <= 126) 
-            {
-                handle->cmdBuffer[handle->bufferIndex++] = ch;
-            }
+            Shell_ProcessChar(handle, burst[i]);
         }
     }
 }
\ No newline at end of file
@@ -8,35 +8,125 @@ extern "C"
 
 #include <FreeRTOS.h>
 #include <queue.h>
+#include <message_buffer.h>
+#include <semphr.h>
 #include <task.h>
 #include <timers.h>
+#include <stream_buffer.h>
 #include <stm32f4xx_hal.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdbool.h>
+#include <shell_hash.h>
 
 /* Configuration constants */
-#define SHELL_MAX_COMMANDS 100
-#define SHELL_QUEUE_LENGTH 256
-#define SHELL_QUEUE_ITEM_SIZE 256
+#define SHELL_MAX_LINE_LEN 256
+#define SHELL_CMD_BUFFER_SIZE 4096      /* Bytes, a line costs strlen + 1 plus a 4 byte length header:
+                                           256 lines of up to 11 chars, 15 full length ones */
 #define SHELL_MAX_ARGS 10
-#define SHELL_MAX_ARG_LEN 32
+#define SHELL_RX_BURST_SIZE 64          /* Bytes the line editor pulls from the transport at once */
+#define SHELL_TX_FLUSH_TIMEOUT 100      /* ms allowed for pending output before a reset */
+#define SHELL_TX_TIMEOUT 500            /* ms a write waits for room under SHELL_TX_BLOCK, default */
+#define SHELL_CMD_HASH_BITS 8           /* Dispatch index has 2^bits slots, keep it at least 2x the command count */
+#define SHELL_PROMPT "[root@root ~]# "
 
-/* Some character string definitions*/
-static const char *prompt = "[root@root ~]# ";
+typedef struct ShellHandle Shell_Handle_t;
+struct ShellRpcOut;
 
 /*
- * Configuration structure for Shell
+ * Byte channel under the shell. The core only moves bursts through these
+ * calls; everything about the channel (UART with or without DMA, RTT, a
+ * pseudo-terminal) lives in the transport and its link, the state the
+ * transport keeps per shell. Writes are serialized by the core, reads come
+ * from vUartTask alone.
  */
 typedef struct {
-    UART_HandleTypeDef *huart;          /* UART handle */
-    QueueHandle_t queue;                /* Queue for received commands */
-    char cmdBuffer[SHELL_QUEUE_LENGTH];
+    uint32_t rxBytes;
+    uint32_t rxOverruns;                /* Receiver overruns (ORE) */
+    uint32_t rxDropped;                 /* Bytes lost because the shell fell behind */
+    uint32_t txBytes;
+    uint32_t txDropped;                 /* Bytes discarded, e.g. nobody reading */
+    uint32_t txStalls;                  /* Writes that found the channel full */
+} ShellTransportStats_t;
+
+/*
+ * What a write does when the channel is full, e.g. the host holds CTS off
+ * or reads slower than a log flood comes in. Writers hold the TX lock, so
+ * a write that never returns stalls every task printing to the session,
+ * the command task included. Dropped bytes count in txDropped.
+ */
+typedef enum {
+    SHELL_TX_BLOCK = 0,                 /* Wait up to txTimeout for room, then drop the rest */
+    SHELL_TX_DROP_NEWEST,               /* Drop what does not fit */
+    SHELL_TX_DROP_OLDEST                /* Make room by dropping the oldest output not yet sent */
+} ShellTxPolicy_t;
+
+typedef struct {
+    const char *name;
+    bool (*init)(Shell_Handle_t *handle);                                   /* Reset the link and start reception */
+    size_t (*read)(Shell_Handle_t *handle, uint8_t *data, size_t len);      /* Blocks until at least one byte */
+    void (*write)(Shell_Handle_t *handle, const uint8_t *data, size_t len); /* Channel full: see handle->txPolicy */
+    bool (*flush)(Shell_Handle_t *handle, TickType_t timeout);              /* Wait until written bytes are out */
+    void (*drain)(Shell_Handle_t *handle, const uint8_t *data, size_t len); /* Pending output then data, polled, no RTOS calls */
+    void (*stats)(Shell_Handle_t *handle, ShellTransportStats_t *stats);
+    UART_HandleTypeDef *(*uart)(Shell_Handle_t *handle);                     /* UART under the channel, NULL for none */
+    bool (*configure)(Shell_Handle_t *handle, const UART_InitTypeDef *init);  /* Reprogram that UART, output already flushed */
+} ShellTransport_t;
+
+/*
+ * One shell session. Any number can run side by side, each on its own
+ * transport with its own line buffer, command queue and Shell_Task/vUartTask
+ * pair; they share the command table. Command handlers of different sessions
+ * run side by side and lock only the state they share (ShellLock_t). A
+ * session costs this struct, its link, the command message buffer
+ * (SHELL_CMD_BUFFER_SIZE) and the two task stacks.
+ */
+struct ShellHandle {
+    const ShellTransport_t *transport;  /* Channel the shell talks over */
+    void *link;                         /* Transport state, e.g. ShellUartLink_t */
+    MessageBufferHandle_t cmdMessages;  /* Received command lines, variable length */
+    char cmdBuffer[SHELL_MAX_LINE_LEN];
     uint16_t bufferIndex;
     TimerHandle_t resetTimer;           /* Timer for delayed reset */
     bool resetPending;                  /* Flag to track if reset is pending */
-} Shell_Handle_t;
+    SemaphoreHandle_t txLock;           /* Serializes writers */
+    ShellTxPolicy_t txPolicy;           /* Full channel, see ShellTxPolicy_t */
+    uint32_t txTimeout;                 /* ms SHELL_TX_BLOCK waits for room */
+    volatile bool rpcMode;              /* Framed binary mode, see shell_rpc.h */
+    uint8_t rpcEscape;                  /* Bytes of SHELL_RPC_ESCAPE matched so far */
+    struct ShellRpcOut *rpcOut;         /* Response of the CALL being run, output is captured into it */
+};
+
+/*
+ * Argument word trie. Every level is a const array sorted by word, so all
+ * words sharing a prefix form one contiguous range found by binary search.
+ * Levels live in flash next to the command that owns them; nothing is
+ * built at run time.
+ */
+typedef struct ShellWords ShellWords_t;
+struct ShellOpt;
+
+typedef struct {
+    const char *word;                   /* Subcommand, peripheral name or option value */
+    const ShellWords_t *next;           /* Level of the following word, NULL for free text */
+    uint32_t value;                     /* What an option value word stands for (see shell_opt.h) */
+} ShellWord_t;
+
+struct ShellWords {
+    const ShellWord_t *words;           /* Sorted by word */
+    const struct ShellOpt *opts;        /* SHELL_WORDS_OPTIONS: option schema sorted by flag, instead of words */
+    uint16_t count;
+    uint16_t flags;
+};
+
+#define SHELL_WORDS_COMMANDS  0x0001    /* Level is the command table itself */
+#define SHELL_WORDS_OPTIONS   0x0002    /* -flags in any order, each followed by its value */
+
+#define SHELL_WORDS(list, flags)  { list, NULL, sizeof(list) / sizeof((list)[0]), flags }
+
+/* Level listing every registered command */
+extern const ShellWords_t shellCommandWords;
 
 /*
  * Shell command structure
@@ -46,15 +136,70 @@ typedef struct {
     const char *description;
     const char *usage;
     void (*commandHandler)(Shell_Handle_t*, int argc, char *argv[]);
+    uint32_t nameHash;                  /* SHELL_NAME_HASH(commandName), computed at build time */
+    const ShellWords_t *args;           /* Words accepted after the command name, NULL for free text */
 } ShellCommand_t;
 
+#ifdef __cplusplus
+#define SHELL_STATIC_ASSERT static_assert
+#else
+#define SHELL_STATIC_ASSERT _Static_assert
+#endif
+
+/*
+ * Command registration. The descriptor is placed in flash in its own
+ * .shell_cmds.<name> section; the linker script collects them between
+ * __shell_cmds_start and __shell_cmds_end sorted by section name, so the
+ * table is ordered by command name at build time. name must be a plain
+ * identifier of at most SHELL_CMD_NAME_MAX characters, it is also the
+ * command string. SHELL_COMMAND_ARGS also attaches the word trie used for
+ * TAB completion and prefix expansion of the arguments.
+ */
+#define SHELL_COMMAND_ARGS(name, description, usage, handler, args)                        \
+    SHELL_STATIC_ASSERT(sizeof(#name) <= SHELL_CMD_NAME_MAX + 1, "command name too long: " #name); \
+    static const ShellCommand_t shell_command_##name                                       \
+    __attribute__((used, aligned(4), section(".shell_cmds." #name))) =                      \
+    { #name, description, usage, handler, SHELL_NAME_HASH(#name), args }
+
+#define SHELL_COMMAND(name, description, usage, handler)                                   \
+    SHELL_COMMAND_ARGS(name, description, usage, handler, NULL)
+
+/* Command table boundaries, defined by the linker script */
+extern const ShellCommand_t __shell_cmds_start[];
+extern const ShellCommand_t __shell_cmds_end[];
+
+#define SHELL_COMMANDS_BEGIN  (__shell_cmds_start)
+#define SHELL_COMMANDS_END    (__shell_cmds_end)
+
+/*
+ * State the sessions share, one lock each. A handler holds a lock only
+ * while it uses that state and never while it waits on its own session's
+ * input, so a long command on one session leaves the others running. The
+ * RPC response buffer has its own lock in shell_rpc.c.
+ */
+typedef enum {
+    SHELL_LOCK_BUS = 0,                 /* Bus slots, pin routing and clocks set up by the shell */
+    SHELL_LOCK_TRACE,                   /* Trace ring and its mode */
+    SHELL_LOCK_HEAP_TRACE,              /* Heap trace report buffer */
+    SHELL_LOCK_PROF,                    /* PC sampler, TIM7 and its table */
+    SHELL_LOCK_BENCH,                   /* Benchmark buffers; runs on two sessions would skew each other */
+    SHELL_LOCK_COUNT
+} ShellLock_t;
+
 /* API prototypes */
-void Shell_Init(Shell_Handle_t *handle, UART_HandleTypeDef *huart);
+void Shell_Init(Shell_Handle_t *handle, const ShellTransport_t *transport, void *link);
 void Shell_Task(void *pvParameters);
 void vUartTask(void *pvParameters);
 void Shell_ParseArgs(char *cmd, int *argc, char *argv[]);
 void sh_print(Shell_Handle_t *handle, const char *str);
-void Shell_RegisterCommand(const char *name, const char *description, const char *usage, void (*handler)(Shell_Handle_t*, int argc, char *argv[]));
+void sh_write(Shell_Handle_t *handle, const uint8_t *data, size_t len);
+bool sh_flush(Shell_Handle_t *handle, TickType_t timeout);
+void sh_drain(Shell_Handle_t *handle);
+bool sh_configure(Shell_Handle_t *handle, const UART_InitTypeDef *init);
+const ShellCommand_t *Shell_FindCommand(const char *name);
+void Shell_RunCommand(Shell_Handle_t *handle, const ShellCommand_t *command, int argc, char *argv[]);
+void Shell_Lock(ShellLock_t lock);
+void Shell_Unlock(ShellLock_t lock);
 
 #ifdef __cplusplus
 }
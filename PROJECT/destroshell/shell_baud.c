@@ -0,0 +1,304 @@
+#include <shell_baud.h>
+#include <shell_opt.h>
+#include <shell_periph.h>
+#include <shell_rpc.h>
+
+typedef struct {
+    uint32_t timeout;
+} BaudOptions_t;
+
+/* Private variables ----------------------------------------------------------*/
+static const ShellOpt_t baudOptionTable[] = {
+    SHELL_OPTION_INT("-timeout", BaudOptions_t, timeout, 100, 60000, SHELL_BAUD_TIMEOUT),
+};
+static const ShellWords_t baudOptions = SHELL_OPTIONS(baudOptionTable);
+
+/* Rates "baud list" tries, besides the fastest one of each oversampling */
+static const uint32_t baudRates[] = {
+    9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600,
+    1000000, 1500000, 2000000, 3000000, 4000000,
+};
+
+/**
+  * @brief  kernel clock of a UART, APB2 for USART1 and USART6, APB1 for the others
+  * @param huart UART handle
+  * @retval clock in Hz
+  */
+uint32_t Shell_BaudClock(const UART_HandleTypeDef *huart)
+{
+    if ((USART1 == huart->Instance) || (USART6 == huart->Instance))
+    {
+        return HAL_RCC_GetPCLK2Freq();
+    }
+    return HAL_RCC_GetPCLK1Freq();
+}
+
+/**
+  * @brief  divider and actual rate the HAL gets for a requested rate
+  * @param pclk UART kernel clock in Hz
+  * @param requested baud rate asked for
+  * @param overSampling UART_OVERSAMPLING_16 or UART_OVERSAMPLING_8
+  * @param baud receives the divider, rate and error
+  * @retval false if the rate is out of reach of the divider
+  */
+bool Shell_BaudCompute(uint32_t pclk, uint32_t requested, uint32_t overSampling, ShellBaud_t *baud)
+{
+    uint32_t div;
+
+    if (0 == requested)
+    {
+        return false;
+    }
+
+    // the HAL rounds the fraction and lets it carry into the mantissa
+    if (UART_OVERSAMPLING_8 == overSampling)
+    {
+        baud->brr = UART_BRR_SAMPLING8(pclk, requested);
+        div = ((baud->brr >> 4) << 3) + (baud->brr & 0x7u);
+    }
+    else
+    {
+        baud->brr = UART_BRR_SAMPLING16(pclk, requested);
+        div = baud->brr;
+    }
+
+    // 12 bit mantissa, 0 is not allowed
+    if ((0 == (baud->brr >> 4)) || ((baud->brr >> 4) > 0xFFFu))
+    {
+        return false;
+    }
+
+    uint64_t nominal = (uint64_t)requested * div;
+    uint64_t diff = (pclk > nominal) ? (pclk - nominal) : (nominal - pclk);
+
+    baud->overSampling = overSampling;
+    baud->rate = (pclk + div / 2u) / div;
+    baud->error = (uint32_t)((diff * 1000000u + nominal / 2u) / nominal);
+    return true;
+}
+
+/**
+  * @brief  oversampling with the smaller rate error, 16 on a tie as it tolerates more noise
+  * @param pclk UART kernel clock in Hz
+  * @param requested baud rate asked for
+  * @param baud receives the divider, rate and error
+  * @retval false if neither oversampling reaches the rate
+  */
+bool Shell_BaudBest(uint32_t pclk, uint32_t requested, ShellBaud_t *baud)
+{
+    ShellBaud_t over8;
+    bool ok16 = Shell_BaudCompute(pclk, requested, UART_OVERSAMPLING_16, baud);
+    bool ok8 = Shell_BaudCompute(pclk, requested, UART_OVERSAMPLING_8, &over8);
+
+    if (ok8 && (!ok16 || (over8.error < baud->error)))
+    {
+        *baud = over8;
+    }
+    return ok16 || ok8;
+}
+
+/**
+  * @brief  format one rate for a table column
+  * @param buf destination
+  * @param size destination size
+  * @param ok false when the rate is out of reach
+  * @param baud divider, rate and error
+  * @retval None
+  */
+static void Shell_BaudFormat(char *buf, size_t size, bool ok, const ShellBaud_t *baud)
+{
+    if (!ok)
+    {
+        snprintf(buf, size, "%-24s", "-");
+        return;
+    }
+    snprintf(buf, size, "%8lu %2lu.%03lu%% %-5s", (unsigned long)baud->rate,
+             (unsigned long)(baud->error / 10000u), (unsigned long)((baud->error % 10000u) / 10u),
+             (baud->error > SHELL_BAUD_MAX_ERROR) ? "(bad)" : "");
+}
+
+/**
+  * @brief  print the rate the UART runs at and what it can run at
+  * @param handle shell handle
+  * @param huart UART of the session
+  * @retval None
+  */
+static void Shell_BaudShow(Shell_Handle_t *handle, UART_HandleTypeDef *huart)
+{
+    const ShellPeriph_t *periph = Shell_PeriphFromBase((uintptr_t)huart->Instance);
+    uint32_t pclk = Shell_BaudClock(huart);
+    ShellBaud_t baud;
+    char buf[192];
+
+    if (!Shell_BaudCompute(pclk, huart->Init.BaudRate, huart->Init.OverSampling, &baud))
+    {
+        baud.brr = 0;
+        baud.rate = 0;
+        baud.error = 0;
+    }
+
+    snprintf(buf, sizeof(buf), "%s: %lu baud, OVER%u, BRR 0x%04lX, actual %lu, error %lu.%03lu%%, clock %lu Hz\r\n"
+             "Fastest: %lu baud with OVER16, %lu with OVER8\r\n",
+             (NULL != periph) ? periph->name : "uart", (unsigned long)huart->Init.BaudRate,
+             (UART_OVERSAMPLING_8 == huart->Init.OverSampling) ? 8u : 16u, (unsigned long)baud.brr,
+             (unsigned long)baud.rate, (unsigned long)(baud.error / 10000u),
+             (unsigned long)((baud.error % 10000u) / 10u), (unsigned long)pclk,
+             (unsigned long)(pclk / 16u), (unsigned long)(pclk / 8u));
+    sh_print(handle, buf);
+}
+
+/**
+  * @brief  print standard rates with the rate and error of both oversamplings
+  * @param handle shell handle
+  * @param pclk UART kernel clock in Hz
+  * @retval None
+  */
+static void Shell_BaudList(Shell_Handle_t *handle, uint32_t pclk)
+{
+    const size_t count = sizeof(baudRates) / sizeof(baudRates[0]);
+    char over16[32];
+    char over8[32];
+    char buf[96];
+
+    sh_print(handle, "Requested  OVER16 rate  error        OVER8 rate   error\r\n");
+    for (size_t i = 0; i < count + 2; i++)
+    {
+        uint32_t rate = (i < count) ? baudRates[i] : (pclk / ((i == count) ? 16u : 8u));
+        ShellBaud_t baud;
+
+        Shell_BaudFormat(over16, sizeof(over16), Shell_BaudCompute(pclk, rate, UART_OVERSAMPLING_16, &baud), &baud);
+        Shell_BaudFormat(over8, sizeof(over8), Shell_BaudCompute(pclk, rate, UART_OVERSAMPLING_8, &baud), &baud);
+        snprintf(buf, sizeof(buf), "%9lu  %s  %s\r\n", (unsigned long)rate, over16, over8);
+        sh_print(handle, buf);
+    }
+}
+
+/**
+  * @brief  wait for the ack line of the host, other lines are dropped
+  * @param handle shell handle
+  * @param timeout maximum time to wait in ticks
+  * @retval true if the ack arrived
+  */
+static bool Shell_BaudWaitAck(Shell_Handle_t *handle, TickType_t timeout)
+{
+    char line[SHELL_MAX_LINE_LEN];
+    TickType_t start = xTaskGetTickCount();
+    TickType_t elapsed;
+
+    while ((elapsed = xTaskGetTickCount() - start) < timeout)
+    {
+        size_t len = xMessageBufferReceive(handle->cmdMessages, line, sizeof(line), timeout - elapsed);
+
+        // lines carry their terminator; noise from a rate mismatch never matches
+        if ((sizeof(SHELL_BAUD_ACK) == len) && (0 == memcmp(line, SHELL_BAUD_ACK, len)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+  * @brief  show or negotiate the baud rate of the shell UART
+  * @param handle shell handle
+  * @param argc argument count
+  * @param argv argument vector
+  * @retval None
+  */
+void shell_cmd_baud(Shell_Handle_t *handle, int argc, char *argv[])
+{
+    UART_HandleTypeDef *huart = (NULL != handle->transport->uart) ? handle->transport->uart(handle) : NULL;
+    BaudOptions_t opt;
+    ShellBaud_t baud;
+    uint32_t rate;
+    char buf[160];
+
+    if (NULL == huart)
+    {
+        sh_print(handle, "This shell does not run on a UART\r\n");
+        return;
+    }
+
+    if (1 == argc)
+    {
+        Shell_BaudShow(handle, huart);
+        return;
+    }
+
+    if (0 == strcmp(argv[1], "list"))
+    {
+        Shell_BaudList(handle, Shell_BaudClock(huart));
+        return;
+    }
+
+    if (!Shell_OptParseInt(argv[1], &rate))
+    {
+        sh_print(handle, "Usage: baud [list] | baud <rate> [-timeout <ms>]\r\n");
+        return;
+    }
+
+    // the ack is a typed line, a frame cannot carry it
+    if (Shell_RpcActive(handle))
+    {
+        sh_print(handle, "Leave RPC mode to change the baud rate\r\n");
+        return;
+    }
+
+    if (!Shell_ParseOptions(handle, &baudOptions, argc - 2, &argv[2], &opt))
+    {
+        return;
+    }
+
+    if (!Shell_BaudBest(Shell_BaudClock(huart), rate, &baud))
+    {
+        snprintf(buf, sizeof(buf), "%lu baud is out of reach, see 'baud list'\r\n", (unsigned long)rate);
+        sh_print(handle, buf);
+        return;
+    }
+
+    if (baud.error > SHELL_BAUD_MAX_ERROR)
+    {
+        snprintf(buf, sizeof(buf), "%lu baud would run at %lu, %lu.%03lu%% off, more than %lu%%\r\n",
+                 (unsigned long)rate, (unsigned long)baud.rate, (unsigned long)(baud.error / 10000u),
+                 (unsigned long)((baud.error % 10000u) / 10u), (unsigned long)(SHELL_BAUD_MAX_ERROR / 10000u));
+        sh_print(handle, buf);
+        return;
+    }
+
+    UART_InitTypeDef previous = huart->Init;
+    UART_InitTypeDef init = huart->Init;
+    init.BaudRate = rate;
+    init.OverSampling = baud.overSampling;
+
+    snprintf(buf, sizeof(buf), "Switching to %lu baud, OVER%u, actual %lu, error %lu.%03lu%%\r\n"
+             "Send '" SHELL_BAUD_ACK "' at the new rate within %lu ms\r\n",
+             (unsigned long)rate, (UART_OVERSAMPLING_8 == baud.overSampling) ? 8u : 16u,
+             (unsigned long)baud.rate, (unsigned long)(baud.error / 10000u),
+             (unsigned long)((baud.error % 10000u) / 10u), (unsigned long)opt.timeout);
+    sh_print(handle, buf);
+
+    if (!sh_configure(handle, &init))
+    {
+        (void)sh_configure(handle, &previous);
+        sh_print(handle, "Could not reprogram the UART, rate unchanged\r\n");
+        return;
+    }
+
+    if (Shell_BaudWaitAck(handle, pdMS_TO_TICKS(opt.timeout)))
+    {
+        snprintf(buf, sizeof(buf), "Link at %lu baud\r\n", (unsigned long)rate);
+    }
+    else
+    {
+        (void)sh_configure(handle, &previous);
+        snprintf(buf, sizeof(buf), "No ack within %lu ms, back to %lu baud\r\n",
+                 (unsigned long)opt.timeout, (unsigned long)previous.BaudRate);
+    }
+    sh_print(handle, buf);
+}
+
+static const ShellWord_t baudWords[] = {
+    { "list", NULL, 0 },
+};
+static const ShellWords_t baudArgs = SHELL_WORDS(baudWords, 0);
+SHELL_COMMAND_ARGS(baud, "Show or negotiate the shell UART baud rate", "baud [list] | baud <rate> [-timeout <ms>]", shell_cmd_baud, &baudArgs);
@@ -0,0 +1,39 @@
+#ifndef __SHELL_BAUD_H__
+#define __SHELL_BAUD_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <destroshell.h>
+
+/*
+ * Baud rate of the shell UART at run time. The divider is what the HAL
+ * programs for a rate (UART_BRR_SAMPLING16/8), so the rate reported is the
+ * one on the wire. A switch is negotiated: the shell announces the rate,
+ * reprograms the UART once its output is out and waits for SHELL_BAUD_ACK
+ * typed at the new rate; without it the old settings come back.
+ */
+
+/* Configuration constants */
+#define SHELL_BAUD_MAX_ERROR 20000      /* ppm, larger rate errors are refused */
+#define SHELL_BAUD_ACK "ok"             /* Line the host sends once it runs at the new rate */
+#define SHELL_BAUD_TIMEOUT 3000         /* ms allowed for the ack, default of -timeout */
+
+typedef struct {
+    uint32_t overSampling;              /* UART_OVERSAMPLING_16 or UART_OVERSAMPLING_8 */
+    uint32_t brr;                       /* BRR as the HAL programs it */
+    uint32_t rate;                      /* Rate the divider gives, rounded */
+    uint32_t error;                     /* |rate - requested| / requested, ppm */
+} ShellBaud_t;
+
+/* API prototypes */
+uint32_t Shell_BaudClock(const UART_HandleTypeDef *huart);
+bool Shell_BaudCompute(uint32_t pclk, uint32_t requested, uint32_t overSampling, ShellBaud_t *baud);
+bool Shell_BaudBest(uint32_t pclk, uint32_t requested, ShellBaud_t *baud);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_BAUD_H__ */
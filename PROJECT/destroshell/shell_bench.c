@@ -0,0 +1,235 @@
+#include <shell_bench.h>
+#include <shell_opt.h>
+#include <stdlib.h>
+
+typedef struct {
+    uint32_t iterations;
+    uint32_t mask;
+} BenchOptions_t;
+
+/* Private variables ----------------------------------------------------------*/
+static const ShellOpt_t benchOptionTable[] = {
+    SHELL_OPTION_BOOL("-mask", BenchOptions_t, mask, 0),
+    SHELL_OPTION_INT("-n", BenchOptions_t, iterations, 1, SHELL_BENCH_MAX_ITERATIONS, SHELL_BENCH_ITERATIONS),
+};
+static const ShellWords_t benchOptions = SHELL_OPTIONS(benchOptionTable);
+
+static const ShellWord_t benchWords[] = {
+    { "list", NULL, 0 },
+    { "run",  NULL, 0 },
+};
+static const ShellWords_t benchArgs = SHELL_WORDS(benchWords, 0);
+
+/**
+  * @brief  empty iteration, timed to find the measurement overhead
+  * @param context unused
+  * @retval None
+  */
+static void Shell_BenchEmpty(void *context)
+{
+    (void)context;
+}
+
+/**
+  * @brief  time one iteration
+  * @note   not inlined, so a benchmark and the empty iteration are timed by
+  *         the same instructions and the overhead cancels out
+  * @param run iteration to time
+  * @param context benchmark context
+  * @param mask true to mask interrupts around the iteration
+  * @retval CYCCNT delta
+  */
+static __attribute__((noinline)) uint32_t Shell_BenchSample(void (*run)(void *), void *context, bool mask)
+{
+    uint32_t start;
+    uint32_t end;
+
+    if (mask)
+    {
+        __disable_irq();
+    }
+    start = DWT->CYCCNT;
+    run(context);
+    end = DWT->CYCCNT;
+    if (mask)
+    {
+        __enable_irq();
+    }
+
+    return end - start;
+}
+
+/**
+  * @brief  qsort comparison of two samples
+  * @param a first sample
+  * @param b second sample
+  * @retval <0, 0 or >0
+  */
+static int Shell_BenchCompare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+  * @brief  cost of timing an empty iteration
+  * @param samples sample buffer
+  * @param iterations samples to take
+  * @param mask true to mask interrupts around each sample
+  * @retval smallest delta seen
+  */
+static uint32_t Shell_BenchOverhead(uint32_t *samples, uint32_t iterations, bool mask)
+{
+    uint32_t overhead = UINT32_MAX;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        samples[i] = Shell_BenchSample(Shell_BenchEmpty, NULL, mask);
+        overhead = (samples[i] < overhead) ? samples[i] : overhead;
+    }
+    return overhead;
+}
+
+/**
+  * @brief  run one benchmark and print its line
+  * @param handle shell handle
+  * @param bench benchmark
+  * @param samples sample buffer
+  * @param opt iterations and masking
+  * @param overhead cycles to subtract from every sample
+  * @retval None
+  */
+static void Shell_BenchRun(Shell_Handle_t *handle, const ShellBench_t *bench, uint32_t *samples,
+                           const BenchOptions_t *opt, uint32_t overhead)
+{
+    // an iteration that needs the scheduler would stall or skip its wait with interrupts masked
+    bool mask = (0 != opt->mask) && (0 == (bench->flags & SHELL_BENCH_SCHEDULER));
+    void *context = NULL;
+    char buf[96];
+
+    if (NULL != bench->setup)
+    {
+        context = bench->setup();
+        if (NULL == context)
+        {
+            snprintf(buf, sizeof(buf), "%-18s setup failed\r\n", bench->name);
+            sh_print(handle, buf);
+            return;
+        }
+    }
+
+    // keep TX DMA interrupts out of the measurement
+    sh_flush(handle, pdMS_TO_TICKS(1000));
+
+    // the first iteration warms the flash cache and any lazy state
+    (void)Shell_BenchSample(bench->run, context, mask);
+    for (uint32_t i = 0; i < opt->iterations; i++)
+    {
+        samples[i] = Shell_BenchSample(bench->run, context, mask);
+    }
+
+    if (NULL != bench->teardown)
+    {
+        bench->teardown(context);
+    }
+
+    qsort(samples, opt->iterations, sizeof(uint32_t), Shell_BenchCompare);
+    for (uint32_t i = 0; i < opt->iterations; i++)
+    {
+        samples[i] = (samples[i] > overhead) ? (samples[i] - overhead) : 0u;
+    }
+
+    snprintf(buf, sizeof(buf), "%-18s %8lu %8lu %8lu%s\r\n", bench->name, (unsigned long)samples[0],
+             (unsigned long)samples[opt->iterations / 2u], (unsigned long)samples[opt->iterations - 1u],
+             ((0 != opt->mask) && !mask) ? "  (interrupts on)" : "");
+    sh_print(handle, buf);
+}
+
+/**
+  * @brief  list the registered benchmarks
+  * @param handle shell handle
+  * @retval None
+  */
+static void Shell_BenchList(Shell_Handle_t *handle)
+{
+    char buf[96];
+
+    for (const ShellBench_t *bench = SHELL_BENCH_BEGIN; bench < SHELL_BENCH_END; bench++)
+    {
+        snprintf(buf, sizeof(buf), "%-18s %s\r\n", bench->name, bench->description);
+        sh_print(handle, buf);
+    }
+}
+
+/**
+  * @brief  run micro-benchmarks
+  * @param handle shell handle
+  * @param argc argument count
+  * @param argv argument vector
+  * @retval None
+  */
+void shell_cmd_bench(Shell_Handle_t *handle, int argc, char *argv[])
+{
+    BenchOptions_t opt;
+    uint32_t *samples;
+    uint32_t overhead;
+    bool all;
+    const ShellBench_t *bench = SHELL_BENCH_BEGIN;
+    char buf[96];
+
+    if ((1 == argc) || ((2 == argc) && (0 == strcmp(argv[1], "list"))))
+    {
+        Shell_BenchList(handle);
+        return;
+    }
+
+    if ((argc < 3) || (0 != strcmp(argv[1], "run")))
+    {
+        sh_print(handle, "Usage: bench [list] | bench run <name|all> [-n <iterations>] [-mask]\r\n");
+        return;
+    }
+
+    all = (0 == strcmp(argv[2], "all"));
+    while ((!all) && (bench < SHELL_BENCH_END) && (0 != strcmp(argv[2], bench->name)))
+    {
+        bench++;
+    }
+    if (bench == SHELL_BENCH_END)
+    {
+        snprintf(buf, sizeof(buf), "Unknown benchmark: %s\r\n", argv[2]);
+        sh_print(handle, buf);
+        return;
+    }
+
+    if (!Shell_ParseOptions(handle, &benchOptions, argc - 3, &argv[3], &opt))
+    {
+        return;
+    }
+
+    samples = pvPortMalloc(opt.iterations * sizeof(uint32_t));
+    if (NULL == samples)
+    {
+        sh_print(handle, "Not enough heap for the samples\r\n");
+        return;
+    }
+
+    // the copy buffers are shared, and two runs at once would time each other
+    Shell_Lock(SHELL_LOCK_BENCH);
+    overhead = Shell_BenchOverhead(samples, opt.iterations, 0 != opt.mask);
+    snprintf(buf, sizeof(buf), "%lu iterations, interrupts %s, %lu cycles of timing overhead subtracted\r\n",
+             (unsigned long)opt.iterations, opt.mask ? "masked" : "on", (unsigned long)overhead);
+    sh_print(handle, buf);
+    sh_print(handle, "Benchmark               Min   Median      Max  (cycles/iteration)\r\n");
+
+    do
+    {
+        Shell_BenchRun(handle, bench, samples, &opt, overhead);
+        bench++;
+    } while (all && (bench < SHELL_BENCH_END));
+    Shell_Unlock(SHELL_LOCK_BENCH);
+
+    vPortFree(samples);
+}
+SHELL_COMMAND_ARGS(bench, "Run micro-benchmarks", "bench [list] | bench run <name|all> [-n <iterations>] [-mask]", shell_cmd_bench, &benchArgs);
@@ -0,0 +1,54 @@
+#ifndef __SHELL_BENCH_H__
+#define __SHELL_BENCH_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <destroshell.h>
+
+/*
+ * Micro-benchmarks. A benchmark is one iteration of the code to measure,
+ * with optional setup and teardown around the whole run; it registers like
+ * a shell command, in a .shell_bench.<name> section the linker script
+ * collects between __shell_bench_start and __shell_bench_end. "bench run"
+ * times every iteration on its own with the DWT cycle counter, subtracts
+ * the cost of timing an empty iteration and reports min, median and max.
+ */
+
+/* Configuration constants */
+#define SHELL_BENCH_ITERATIONS 1000     /* Default iterations per benchmark */
+#define SHELL_BENCH_MAX_ITERATIONS 4096 /* One uint32_t of heap per iteration while running */
+
+/* Flags */
+#define SHELL_BENCH_SCHEDULER 0x0001    /* Iteration blocks or switches tasks, never run with interrupts masked */
+
+typedef struct {
+    const char *name;
+    const char *description;
+    void *(*setup)(void);               /* Optional, returns the context handed to run; NULL is a failure */
+    void (*run)(void *context);         /* One iteration */
+    void (*teardown)(void *context);    /* Optional, undoes setup */
+    uint32_t flags;
+} ShellBench_t;
+
+#define SHELL_BENCH_FLAGS(name, description, setup, run, teardown, flags)                  \
+    static const ShellBench_t shell_bench_##name                                           \
+    __attribute__((used, aligned(4), section(".shell_bench." #name))) =                     \
+    { #name, description, setup, run, teardown, flags }
+
+#define SHELL_BENCH(name, description, setup, run, teardown)                               \
+    SHELL_BENCH_FLAGS(name, description, setup, run, teardown, 0)
+
+/* Benchmark table boundaries, defined by the linker script */
+extern const ShellBench_t __shell_bench_start[];
+extern const ShellBench_t __shell_bench_end[];
+
+#define SHELL_BENCH_BEGIN  (__shell_bench_start)
+#define SHELL_BENCH_END    (__shell_bench_end)
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_BENCH_H__ */
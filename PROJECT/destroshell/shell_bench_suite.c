@@ -0,0 +1,190 @@
+#include <shell_bench.h>
+
+/*
+ * Starter benchmarks: copies between SRAM and CCMRAM, the GPIO write paths
+ * from HAL down to BSRR, and the cost of a queue and a task notification.
+ */
+
+/* Configuration constants */
+#define BENCH_COPY_SIZE 1024            /* Bytes per memcpy/memset iteration */
+#define BENCH_GPIO_PORT GPIOD           /* Blue LED of the Discovery board, an output after MX_GPIO_Init */
+#define BENCH_GPIO_PIN GPIO_PIN_15
+
+typedef struct {
+    uint8_t *src;
+    uint8_t *dst;
+} BenchCopy_t;
+
+/* Private variables ----------------------------------------------------------*/
+static uint8_t benchCcm[2][BENCH_COPY_SIZE] __attribute__((section(".ccmbss")));
+static uint8_t *benchSram;              /* Two blocks, allocated for the run only */
+static BenchCopy_t benchCopy;
+
+/* memcpy / memset ------------------------------------------------------------*/
+
+/**
+  * @brief  pick the source and destination of a copy benchmark
+  * @param srcCcm true to copy from CCMRAM, false from SRAM
+  * @param dstCcm true to copy to CCMRAM, false to SRAM
+  * @retval copy context, NULL if the SRAM blocks could not be allocated
+  */
+static void *Bench_CopySetup(bool srcCcm, bool dstCcm)
+{
+    benchSram = pvPortMalloc(2u * BENCH_COPY_SIZE);
+    if (NULL == benchSram)
+    {
+        return NULL;
+    }
+
+    benchCopy.src = srcCcm ? benchCcm[0] : benchSram;
+    benchCopy.dst = dstCcm ? benchCcm[1] : &benchSram[BENCH_COPY_SIZE];
+    return &benchCopy;
+}
+
+static void *Bench_SramToSram(void) { return Bench_CopySetup(false, false); }
+static void *Bench_CcmToCcm(void)   { return Bench_CopySetup(true, true); }
+static void *Bench_SramToCcm(void)  { return Bench_CopySetup(false, true); }
+static void *Bench_CcmToSram(void)  { return Bench_CopySetup(true, false); }
+
+/**
+  * @brief  release the SRAM blocks of a copy benchmark
+  * @param context copy context
+  * @retval None
+  */
+static void Bench_CopyTeardown(void *context)
+{
+    (void)context;
+    vPortFree(benchSram);
+    benchSram = NULL;
+}
+
+static void Bench_Memcpy(void *context)
+{
+    BenchCopy_t *copy = context;
+
+    memcpy(copy->dst, copy->src, BENCH_COPY_SIZE);
+}
+
+static void Bench_Memset(void *context)
+{
+    BenchCopy_t *copy = context;
+
+    memset(copy->dst, 0x55, BENCH_COPY_SIZE);
+}
+
+SHELL_BENCH(memcpy_ccm_ccm,   "memcpy 1 KB CCMRAM to CCMRAM", Bench_CcmToCcm, Bench_Memcpy, Bench_CopyTeardown);
+SHELL_BENCH(memcpy_ccm_sram,  "memcpy 1 KB CCMRAM to SRAM",   Bench_CcmToSram, Bench_Memcpy, Bench_CopyTeardown);
+SHELL_BENCH(memcpy_sram_ccm,  "memcpy 1 KB SRAM to CCMRAM",   Bench_SramToCcm, Bench_Memcpy, Bench_CopyTeardown);
+SHELL_BENCH(memcpy_sram_sram, "memcpy 1 KB SRAM to SRAM",     Bench_SramToSram, Bench_Memcpy, Bench_CopyTeardown);
+SHELL_BENCH(memset_ccm,       "memset 1 KB of CCMRAM",        Bench_SramToCcm, Bench_Memset, Bench_CopyTeardown);
+SHELL_BENCH(memset_sram,      "memset 1 KB of SRAM",          Bench_CcmToSram, Bench_Memset, Bench_CopyTeardown);
+
+/* GPIO: one pulse, set then clear, per iteration ---------------------------*/
+
+static void Bench_GpioHalWrite(void *context)
+{
+    (void)context;
+    HAL_GPIO_WritePin(BENCH_GPIO_PORT, BENCH_GPIO_PIN, GPIO_PIN_SET);
+    HAL_GPIO_WritePin(BENCH_GPIO_PORT, BENCH_GPIO_PIN, GPIO_PIN_RESET);
+}
+
+static void Bench_GpioHalToggle(void *context)
+{
+    (void)context;
+    HAL_GPIO_TogglePin(BENCH_GPIO_PORT, BENCH_GPIO_PIN);
+    HAL_GPIO_TogglePin(BENCH_GPIO_PORT, BENCH_GPIO_PIN);
+}
+
+static void Bench_GpioBsrr(void *context)
+{
+    (void)context;
+    BENCH_GPIO_PORT->BSRR = BENCH_GPIO_PIN;
+    BENCH_GPIO_PORT->BSRR = (uint32_t)BENCH_GPIO_PIN << 16u;
+}
+
+static void Bench_GpioOdr(void *context)
+{
+    (void)context;
+    BENCH_GPIO_PORT->ODR ^= BENCH_GPIO_PIN;
+    BENCH_GPIO_PORT->ODR ^= BENCH_GPIO_PIN;
+}
+
+SHELL_BENCH(gpio_bsrr,       "GPIO pulse, two BSRR stores",          NULL, Bench_GpioBsrr, NULL);
+SHELL_BENCH(gpio_hal_toggle, "GPIO pulse, two HAL_GPIO_TogglePin",   NULL, Bench_GpioHalToggle, NULL);
+SHELL_BENCH(gpio_hal_write,  "GPIO pulse, two HAL_GPIO_WritePin",    NULL, Bench_GpioHalWrite, NULL);
+SHELL_BENCH(gpio_odr,        "GPIO pulse, two ODR read-modify-write", NULL, Bench_GpioOdr, NULL);
+
+/* Queue and task notification ------------------------------------------------*/
+
+static void *Bench_QueueSetup(void)
+{
+    return xQueueCreate(1, sizeof(uint32_t));
+}
+
+static void Bench_QueueTeardown(void *context)
+{
+    vQueueDelete((QueueHandle_t)context);
+}
+
+static void Bench_QueueRoundTrip(void *context)
+{
+    uint32_t item = 0;
+
+    (void)xQueueSend((QueueHandle_t)context, &item, 0);
+    (void)xQueueReceive((QueueHandle_t)context, &item, 0);
+}
+
+/**
+  * @brief  peer of the notification benchmark, answers every notification
+  * @param pvParameters task to answer
+  * @retval None
+  */
+static void Bench_NotifyPeer(void *pvParameters)
+{
+    TaskHandle_t caller = pvParameters;
+
+    for (;;)
+    {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        xTaskNotifyGive(caller);
+    }
+}
+
+/**
+  * @brief  start the peer one priority above the caller, so each notify switches to it
+  * @retval peer task, NULL if it could not be created
+  */
+static void *Bench_NotifySetup(void)
+{
+    UBaseType_t priority = uxTaskPriorityGet(NULL) + 1u;
+    TaskHandle_t peer;
+
+    if (priority >= configMAX_PRIORITIES)
+    {
+        priority = configMAX_PRIORITIES - 1u;
+    }
+
+    // drop a stale notification so the first take waits for the peer
+    (void)ulTaskNotifyTake(pdTRUE, 0);
+    if (pdPASS != xTaskCreate(Bench_NotifyPeer, "Bench", configMINIMAL_STACK_SIZE, xTaskGetCurrentTaskHandle(),
+                              priority, &peer))
+    {
+        return NULL;
+    }
+    return peer;
+}
+
+static void Bench_NotifyTeardown(void *context)
+{
+    vTaskDelete((TaskHandle_t)context);
+}
+
+static void Bench_NotifyRoundTrip(void *context)
+{
+    xTaskNotifyGive((TaskHandle_t)context);
+    (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+SHELL_BENCH(queue_roundtrip, "xQueueSend then xQueueReceive, same task", Bench_QueueSetup, Bench_QueueRoundTrip, Bench_QueueTeardown);
+SHELL_BENCH_FLAGS(notify_roundtrip, "Task notification to a peer and back, two switches", Bench_NotifySetup,
+                  Bench_NotifyRoundTrip, Bench_NotifyTeardown, SHELL_BENCH_SCHEDULER);
@@ -0,0 +1,180 @@
+#include <shell_bus.h>
+
+/* Private variables ----------------------------------------------------------*/
+static UART_Config_t uartSlots[SHELL_PERIPH_USART_COUNT];
+static I2C_Config_t i2cSlots[SHELL_PERIPH_I2C_COUNT];
+static SPI_Config_t spiSlots[SHELL_PERIPH_SPI_COUNT];
+static TIM_Config_t timSlots[SHELL_PERIPH_TIM_COUNT];
+static RTC_Config_t rtcSlot;
+
+/**
+  * @brief  registry slot of a UART instance
+  * @param periph UART descriptor
+  * @retval slot, NULL if periph is not a UART
+  */
+UART_Config_t *Shell_BusUart(const ShellPeriph_t *periph)
+{
+    UART_Config_t *slot;
+
+    if ((NULL == periph) || (SHELL_PERIPH_USART != periph->type))
+    {
+        return NULL;
+    }
+
+    slot = &uartSlots[Shell_PeriphUnit(periph)];
+    slot->periph = periph;
+    return slot;
+}
+
+/**
+  * @brief  registry slot of an I2C instance
+  * @param periph I2C descriptor
+  * @retval slot, NULL if periph is not an I2C
+  */
+I2C_Config_t *Shell_BusI2c(const ShellPeriph_t *periph)
+{
+    I2C_Config_t *slot;
+
+    if ((NULL == periph) || (SHELL_PERIPH_I2C != periph->type))
+    {
+        return NULL;
+    }
+
+    slot = &i2cSlots[Shell_PeriphUnit(periph)];
+    slot->periph = periph;
+    return slot;
+}
+
+/**
+  * @brief  registry slot of an SPI instance
+  * @param periph SPI descriptor
+  * @retval slot, NULL if periph is not an SPI
+  */
+SPI_Config_t *Shell_BusSpi(const ShellPeriph_t *periph)
+{
+    SPI_Config_t *slot;
+
+    if ((NULL == periph) || (SHELL_PERIPH_SPI != periph->type))
+    {
+        return NULL;
+    }
+
+    slot = &spiSlots[Shell_PeriphUnit(periph)];
+    slot->periph = periph;
+    return slot;
+}
+
+/**
+  * @brief  registry slot of a timer instance
+  * @param periph timer descriptor
+  * @retval slot, NULL if periph is not a timer
+  */
+TIM_Config_t *Shell_BusTim(const ShellPeriph_t *periph)
+{
+    TIM_Config_t *slot;
+
+    if ((NULL == periph) || (SHELL_PERIPH_TIM != periph->type))
+    {
+        return NULL;
+    }
+
+    slot = &timSlots[Shell_PeriphUnit(periph)];
+    slot->periph = periph;
+    return slot;
+}
+
+/**
+  * @brief  registry slot of the RTC
+  * @retval slot
+  */
+RTC_Config_t *Shell_BusRtc(void)
+{
+    return &rtcSlot;
+}
+
+/**
+  * @brief  live HAL handle of an initialized peripheral
+  * @note   for commands that transfer over a bus set up with init
+  * @param type peripheral type
+  * @param name instance name, ignored for the RTC
+  * @retval UART/I2C/SPI/TIM/RTC_HandleTypeDef pointer, NULL unless the slot is ready
+  */
+void *Shell_BusHandle(ShellPeriphType_t type, const char *name)
+{
+    const ShellPeriph_t *periph;
+
+    if (SHELL_PERIPH_RTC == type)
+    {
+        return (SHELL_BUS_READY == rtcSlot.state) ? &rtcSlot.handle : NULL;
+    }
+
+    periph = Shell_PeriphFind(type, name);
+    if (NULL == periph)
+    {
+        return NULL;
+    }
+
+    if (SHELL_PERIPH_USART == type)
+    {
+        UART_Config_t *slot = Shell_BusUart(periph);
+        return (SHELL_BUS_READY == slot->state) ? &slot->handle : NULL;
+    }
+    else if (SHELL_PERIPH_I2C == type)
+    {
+        I2C_Config_t *slot = Shell_BusI2c(periph);
+        return (SHELL_BUS_READY == slot->state) ? &slot->handle : NULL;
+    }
+    else if (SHELL_PERIPH_SPI == type)
+    {
+        SPI_Config_t *slot = Shell_BusSpi(periph);
+        return (SHELL_BUS_READY == slot->state) ? &slot->handle : NULL;
+    }
+    else if (SHELL_PERIPH_TIM == type)
+    {
+        TIM_Config_t *slot = Shell_BusTim(periph);
+        return (SHELL_BUS_READY == slot->state) ? &slot->handle : NULL;
+    }
+    return NULL;
+}
+
+/**
+  * @brief  mark a UART as owned by the firmware so init refuses to touch it
+  * @param huart handle initialized outside the shell, e.g. the shell port
+  * @retval None
+  */
+void Shell_BusReserveUart(UART_HandleTypeDef *huart)
+{
+    UART_Config_t *slot = Shell_BusUart(Shell_PeriphFromBase((uintptr_t)huart->Instance));
+
+    if (NULL != slot)
+    {
+        slot->state = SHELL_BUS_RESERVED;
+    }
+}
+
+/**
+  * @brief  mark a timer as owned by the firmware so init refuses to touch it
+  * @param htim handle of a timer driven outside the shell, e.g. the HAL timebase
+  * @retval None
+  */
+void Shell_BusReserveTim(TIM_HandleTypeDef *htim)
+{
+    TIM_Config_t *slot = Shell_BusTim(Shell_PeriphFromBase((uintptr_t)htim->Instance));
+
+    if (NULL != slot)
+    {
+        slot->state = SHELL_BUS_RESERVED;
+    }
+}
+
+/**
+  * @brief  printable name of a slot state
+  * @param state slot state
+  * @retval state name
+  */
+const char *Shell_BusStateName(ShellBusState_t state)
+{
+    static const char *const names[] = { "free", "ready", "error", "reserved" };
+
+    return (state < sizeof(names) / sizeof(names[0])) ? names[state] : "?";
+}
@@ -0,0 +1,130 @@
+#ifndef __SHELL_BUS_H__
+#define __SHELL_BUS_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <destroshell.h>
+#include <shell_periph.h>
+
+/*
+ * Registry of peripherals brought up from the shell. Every instance in the
+ * descriptor table owns one slot holding its HAL handle, the options it was
+ * initialized with and its state, so the handle outlives the init command
+ * and later commands can use the live peripheral. Slots are only touched
+ * from command handlers, under Shell_Lock(SHELL_LOCK_BUS) once the shell
+ * sessions run.
+ */
+typedef enum {
+    SHELL_BUS_FREE = 0,                 /* Never initialized from the shell */
+    SHELL_BUS_READY,                    /* HAL init succeeded, handle is live */
+    SHELL_BUS_ERROR,                    /* Last init failed, handle is not usable */
+    SHELL_BUS_RESERVED                  /* Owned by the firmware, e.g. the shell port */
+} ShellBusState_t;
+
+/*
+ * init options. Each peripheral type parses its flags into one of these
+ * structs through its schema (see shell_cmd.c); a slot keeps the struct it
+ * was initialized with.
+ */
+typedef struct {
+    uint32_t baudRate;
+    uint32_t flowControl;
+    uint32_t mode;
+    uint32_t parity;
+    uint32_t stopBits;
+    uint32_t wordLength;
+} UartOptions_t;
+
+typedef struct {
+    uint32_t addressingMode;
+    uint32_t clockSpeed;
+    uint32_t dutyCycle;
+    uint32_t dualAddress;
+    uint32_t generalCall;
+    uint32_t noStretch;
+    uint32_t ownAddress1;
+    uint32_t ownAddress2;
+} I2cOptions_t;
+
+typedef struct {
+    uint32_t baudRatePrescaler;
+    uint32_t clkPhase;
+    uint32_t crcCalculation;
+    uint32_t crcPolynomial;
+    uint32_t dataSize;
+    uint32_t direction;
+    uint32_t firstBit;
+    uint32_t mode;
+    uint32_t nss;
+    uint32_t clkPolarity;
+    uint32_t tiMode;
+} SpiOptions_t;
+
+typedef struct {
+    uint32_t autoReload;
+    uint32_t clockDivision;
+    uint32_t counterMode;
+    uint32_t period;
+    uint32_t prescaler;
+    uint32_t repetitionCounter;
+} TimOptions_t;
+
+typedef struct {
+    uint32_t asynchPrediv;
+    uint32_t clockSource;
+    uint32_t hourFormat;
+    uint32_t synchPrediv;
+} RtcOptions_t;
+
+typedef struct {
+    UART_HandleTypeDef handle;
+    UartOptions_t options;
+    const ShellPeriph_t *periph;
+    ShellBusState_t state;
+} UART_Config_t;
+
+typedef struct {
+    I2C_HandleTypeDef handle;
+    I2cOptions_t options;
+    const ShellPeriph_t *periph;
+    ShellBusState_t state;
+} I2C_Config_t;
+
+typedef struct {
+    SPI_HandleTypeDef handle;
+    SpiOptions_t options;
+    const ShellPeriph_t *periph;
+    ShellBusState_t state;
+} SPI_Config_t;
+
+typedef struct {
+    TIM_HandleTypeDef handle;
+    TimOptions_t options;
+    const ShellPeriph_t *periph;
+    ShellBusState_t state;
+} TIM_Config_t;
+
+typedef struct {
+    RTC_HandleTypeDef handle;
+    RtcOptions_t options;
+    ShellBusState_t state;
+} RTC_Config_t;
+
+/* API prototypes */
+UART_Config_t *Shell_BusUart(const ShellPeriph_t *periph);
+I2C_Config_t *Shell_BusI2c(const ShellPeriph_t *periph);
+SPI_Config_t *Shell_BusSpi(const ShellPeriph_t *periph);
+TIM_Config_t *Shell_BusTim(const ShellPeriph_t *periph);
+RTC_Config_t *Shell_BusRtc(void);
+void *Shell_BusHandle(ShellPeriphType_t type, const char *name);
+void Shell_BusReserveUart(UART_HandleTypeDef *huart);
+void Shell_BusReserveTim(TIM_HandleTypeDef *htim);
+const char *Shell_BusStateName(ShellBusState_t state);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_BUS_H__ */
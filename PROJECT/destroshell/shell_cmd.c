@@ -1,21 +1,14 @@
 #include <shell_cmd.h>
 
-static Shell_Handle_t *globalShellHandle;
-static TimerHandle_t resetTimer = NULL;
-
 /* Helper functions */
 static GPIO_TypeDef* get_gpio_port(const char *port_str);
-static int parse_args(int argc, char *argv[], int start_idx, ShellArg_t *args, int max_args);
-static const char* get_arg_value(ShellArg_t *args, int arg_count, const char *flag, const char *default_value);
-static USART_TypeDef* get_usart_base(const char* uart_name);
-static I2C_TypeDef* get_i2c_base(const char* i2c_name) ;
-static SPI_TypeDef* get_spi_base(const char* spi_name); 
-static TIM_TypeDef* get_timer_base(const char* timer_name);
-static void init_uart(Shell_Handle_t *handle, const char* peripheral_name, ShellArg_t *args, int arg_count);
-static void init_spi(Shell_Handle_t *handle, const char* peripheral_name, ShellArg_t *args, int arg_count);
-static void init_i2c(Shell_Handle_t *handle, const char* peripheral_name, ShellArg_t *args, int arg_count);
-static void init_timer(Shell_Handle_t *handle, const char* peripheral_name, ShellArg_t *args, int arg_count);
-static void init_rtc(Shell_Handle_t *handle, ShellArg_t *args, int arg_count);
+static void init_uart(Shell_Handle_t *handle, const char* peripheral_name, int argc, char *argv[]);
+static void init_spi(Shell_Handle_t *handle, const char* peripheral_name, int argc, char *argv[]);
+static void init_i2c(Shell_Handle_t *handle, const char* peripheral_name, int argc, char *argv[]);
+static void init_timer(Shell_Handle_t *handle, const char* peripheral_name, int argc, char *argv[]);
+static void init_rtc(Shell_Handle_t *handle, int argc, char *argv[]);
+static void init_report(Shell_Handle_t *handle, const char *name, const char *state, const ShellWords_t *schema, const void *options);
+static void init_list(Shell_Handle_t *handle);
 
 /**
   * @brief  clear screen command
@@ -28,6 +21,7 @@ void shell_cmd_clear(Shell_Handle_t *handle, int argc, char *argv[])
 {
     sh_print(handle, "\033[2J\033[H");  
 }
+SHELL_COMMAND(clear, "Clear the terminal screen", "clear", shell_cmd_clear);
 
 /**
   * @brief  command that prints information about available commands
@@ -41,17 +35,15 @@ void shell_cmd_help(Shell_Handle_t *handle, int argc, char *argv[])
     if (argc > 1) 
     {
         // Show specific command help
-        for (uint8_t i = 0; i < commandCount; i++) 
+        const ShellCommand_t *command = Shell_FindCommand(argv[1]);
+        if (NULL != command) 
         {
-            if (0 == strcmp(argv[1], shellCommands[i].commandName)) 
-            {
-                sh_print(handle, "\r\nCommand: ");
-                sh_print(handle, shellCommands[i].commandName);
-                sh_print(handle, "\r\nDescription: ");
-                sh_print(handle, shellCommands[i].description);
-                sh_print(handle, "\r\n");
-                return;
-            }
+            sh_print(handle, "\r\nCommand: ");
+            sh_print(handle, command->commandName);
+            sh_print(handle, "\r\nDescription: ");
+            sh_print(handle, command->description);
+            sh_print(handle, "\r\n");
+            return;
         }
         sh_print(handle, "Command not found\r\n");
     } 
@@ -59,15 +51,16 @@ void shell_cmd_help(Shell_Handle_t *handle, int argc, char *argv[])
     {
         // Show all commands
         sh_print(handle, "\r\nAvailable commands:\r\n");
-        for (uint8_t i = 0; i < commandCount; i++) 
+        for (const ShellCommand_t *command = SHELL_COMMANDS_BEGIN; command < SHELL_COMMANDS_END; command++) 
         {
-            sh_print(handle, shellCommands[i].commandName);
+            sh_print(handle, command->commandName);
             sh_print(handle, " : ");
-            sh_print(handle, shellCommands[i].description);
+            sh_print(handle, command->description);
             sh_print(handle, "\r\n");
         }
     }
 }
+SHELL_COMMAND_ARGS(help, "Display help information for commands", "help [command]", shell_cmd_help, &shellCommandWords);
 
 /**
   * @brief  prints system status
@@ -78,8 +71,23 @@ void shell_cmd_help(Shell_Handle_t *handle, int argc, char *argv[])
   */
 void shell_cmd_status(Shell_Handle_t *handle, int argc, char *argv[]) 
 {
+   char buf[160];
+   ShellTransportStats_t stats;
+
+   handle->transport->stats(handle, &stats);
+
    sh_print(handle, "⟹ System is running.\r\n");
+   sprintf(buf, "Transport %s: RX %lu bytes, overruns %lu, dropped %lu; TX %lu bytes, dropped %lu, stalls %lu\r\n",
+           handle->transport->name,
+           (unsigned long)stats.rxBytes,
+           (unsigned long)stats.rxOverruns,
+           (unsigned long)stats.rxDropped,
+           (unsigned long)stats.txBytes,
+           (unsigned long)stats.txDropped,
+           (unsigned long)stats.txStalls);
+   sh_print(handle, buf);
 }
+SHELL_COMMAND(status, "Show system status information", "status", shell_cmd_status);
 
 /**
   * @brief  system reset command
@@ -106,6 +114,7 @@ void shell_cmd_reset(Shell_Handle_t *handle, int argc, char *argv[])
         handle->resetPending = false;
     }
 }
+SHELL_COMMAND(reset, "Reset the system", "reset", shell_cmd_reset);
 
 /**
   * @brief  system reset command
@@ -131,6 +140,27 @@ void shell_cmd_reset_cancel(Shell_Handle_t *handle, int argc, char *argv[])
     handle->resetPending = false;
     sh_print(handle, "Reset cancelled.\r\n");
 }
+static const ShellWord_t cancelWords[] = {
+    { "reset", NULL, 0 },
+};
+static const ShellWords_t cancelArgs = SHELL_WORDS(cancelWords, 0);
+SHELL_COMMAND_ARGS(cancel, "Cancel pending reset", "cancel reset", shell_cmd_reset_cancel, &cancelArgs);
+
+/**
+  * @brief  emit one task as an RPC list: name, state, priority, stack high water mark, number
+  * @param handle shell handle
+  * @param status task status from uxTaskGetSystemState
+  * @retval None
+  */
+static void shell_rpc_task(Shell_Handle_t *handle, const TaskStatus_t *status) 
+{
+    Shell_RpcList(handle, 5);
+    Shell_RpcStr(handle, status->pcTaskName);
+    Shell_RpcU8(handle, (uint8_t)status->eCurrentState);
+    Shell_RpcU8(handle, (uint8_t)status->uxCurrentPriority);
+    Shell_RpcU32(handle, status->usStackHighWaterMark);
+    Shell_RpcU32(handle, status->xTaskNumber);
+}
 
 /**
   * @brief  print current task information
@@ -141,7 +171,26 @@ void shell_cmd_reset_cancel(Shell_Handle_t *handle, int argc, char *argv[])
   */
 void shell_cmd_tasks(Shell_Handle_t *handle, int argc, char *argv[]) 
 {
-    if (argc > 1 && 0 == strcmp(argv[1], "list")) 
+    if (argc > 1 && 0 == strcmp(argv[1], "list") && Shell_RpcActive(handle)) 
+    {
+        UBaseType_t uxArraySize = uxTaskGetNumberOfTasks();
+        TaskStatus_t *pxTaskStatusArray = pvPortMalloc(uxArraySize * sizeof(TaskStatus_t));
+
+        if (NULL == pxTaskStatusArray) 
+        {
+            sh_print(handle, "Failed to allocate memory for task information\r\n");
+            return;
+        }
+
+        uxArraySize = uxTaskGetSystemState(pxTaskStatusArray, uxArraySize, NULL);
+        Shell_RpcList(handle, (uint16_t)uxArraySize);
+        for (UBaseType_t i = 0; i < uxArraySize; i++) 
+        {
+            shell_rpc_task(handle, &pxTaskStatusArray[i]);
+        }
+        vPortFree(pxTaskStatusArray);
+    } 
+    else if (argc > 1 && 0 == strcmp(argv[1], "list")) 
     {
         char buf[512];
         vTaskList(buf); 
@@ -174,7 +223,11 @@ void shell_cmd_tasks(Shell_Handle_t *handle, int argc, char *argv[])
             
             vPortFree(pxTaskStatusArray);
             
-            if (NULL != xHandle) 
+            if ((NULL != xHandle) && Shell_RpcActive(handle)) 
+            {
+                shell_rpc_task(handle, &xTaskDetails);
+            } 
+            else if (NULL != xHandle) 
             {
                 char buf[256];
                 sprintf(buf, "\r\nTask: %s\r\nState: %lu\r\nPriority: %lu\r\nStack High Water Mark: %lu\r\n",
@@ -199,6 +252,12 @@ void shell_cmd_tasks(Shell_Handle_t *handle, int argc, char *argv[])
         sh_print(handle, "Usage: tasks list | tasks info <task_name>\r\n");
     }
 }
+static const ShellWord_t tasksWords[] = {
+    { "info", NULL, 0 },
+    { "list", NULL, 0 },
+};
+static const ShellWords_t tasksArgs = SHELL_WORDS(tasksWords, 0);
+SHELL_COMMAND_ARGS(tasks, "Manage system tasks", "tasks list | tasks info <task_name>", shell_cmd_tasks, &tasksArgs);
 
 /**
   * @brief  print current heap information
@@ -209,8 +268,37 @@ void shell_cmd_tasks(Shell_Handle_t *handle, int argc, char *argv[])
   */
 void shell_cmd_heap(Shell_Handle_t *handle, int argc, char *argv[]) 
 {
+    if ((2 == argc) && (0 == strcmp(argv[1], "frag")))
+    {
+        Shell_HeapFrag(handle);
+        return;
+    }
+#if ( configUSE_SHELL_HEAP_TRACE == 1 )
+    if ((argc >= 2) && (0 == strcmp(argv[1], "trace")))
+    {
+        Shell_Lock(SHELL_LOCK_HEAP_TRACE);
+        Shell_HeapTrace(handle, argc - 1, &argv[1]);
+        Shell_Unlock(SHELL_LOCK_HEAP_TRACE);
+        return;
+    }
+#endif
+
     HeapStats_t heapStats;
     vPortGetHeapStats(&heapStats);
+
+    if (Shell_RpcActive(handle)) 
+    {
+        // total, free, minimum ever free, largest free block, allocations, frees
+        Shell_RpcList(handle, 6);
+        Shell_RpcU32(handle, configTOTAL_HEAP_SIZE);
+        Shell_RpcU32(handle, heapStats.xAvailableHeapSpaceInBytes);
+        Shell_RpcU32(handle, heapStats.xMinimumEverFreeBytesRemaining);
+        Shell_RpcU32(handle, heapStats.xSizeOfLargestFreeBlockInBytes);
+        Shell_RpcU32(handle, heapStats.xNumberOfSuccessfulAllocations);
+        Shell_RpcU32(handle, heapStats.xNumberOfSuccessfulFrees);
+        return;
+    }
+
     char buf[256];
     sprintf(buf, "\r\nHeap Information:\r\n"
                  "Total Heap: %d bytes\r\n"
@@ -223,6 +311,18 @@ void shell_cmd_heap(Shell_Handle_t *handle, int argc, char *argv[])
             heapStats.xMinimumEverFreeBytesRemaining);
     sh_print(handle, buf);
 }
+static const ShellWord_t heapWords[] = {
+    { "frag", NULL, 0 },
+#if ( configUSE_SHELL_HEAP_TRACE == 1 )
+    { "trace", &shellHeapTraceArgs, 0 },
+#endif
+};
+static const ShellWords_t heapArgs = SHELL_WORDS(heapWords, 0);
+#if ( configUSE_SHELL_HEAP_TRACE == 1 )
+SHELL_COMMAND_ARGS(heap, "Show heap memory information", "heap | heap frag | heap trace [start|stop|clear]", shell_cmd_heap, &heapArgs);
+#else
+SHELL_COMMAND_ARGS(heap, "Show heap memory information", "heap | heap frag", shell_cmd_heap, &heapArgs);
+#endif
 
 /**
   * @brief  print current stack information
@@ -259,6 +359,7 @@ void shell_cmd_heap(Shell_Handle_t *handle, int argc, char *argv[])
         sh_print(handle, "Failed to allocate memory for task information\r\n");
     }
 }
+SHELL_COMMAND(stack, "Show stack usage for all tasks", "stack", shell_cmd_stack);
 
 /**
   * @brief  configure selected pin 
@@ -302,6 +403,11 @@ void shell_cmd_pin(Shell_Handle_t *handle, int argc, char *argv[])
     else if (0 == strcmp(argv[1], "read")) 
     {
         GPIO_PinState state = HAL_GPIO_ReadPin(port, pin);
+        if (Shell_RpcActive(handle)) 
+        {
+            Shell_RpcU8(handle, (uint8_t)state);
+            return;
+        }
         char buf[32];
         sprintf(buf, "Pin state: %d\r\n", state);
         sh_print(handle, buf);
@@ -315,6 +421,245 @@ void shell_cmd_pin(Shell_Handle_t *handle, int argc, char *argv[])
         sh_print(handle, "Invalid command\r\n");
     }
 }
+static const ShellWord_t pinPortWords[] = {
+    { "gpioa", NULL, 0 },
+    { "gpiob", NULL, 0 },
+    { "gpioc", NULL, 0 },
+    { "gpiod", NULL, 0 },
+    { "gpioe", NULL, 0 },
+};
+static const ShellWords_t pinPorts = SHELL_WORDS(pinPortWords, 0);
+
+static const ShellWord_t pinWords[] = {
+    { "read",   &pinPorts, 0 },
+    { "reset",  &pinPorts, 0 },
+    { "set",    &pinPorts, 0 },
+    { "toggle", &pinPorts, 0 },
+};
+static const ShellWords_t pinArgs = SHELL_WORDS(pinWords, 0);
+SHELL_COMMAND_ARGS(pin, "Control GPIO pins", "pin <set/reset/read/toggle> <port: A, B, etc.> <pin_number>", shell_cmd_pin, &pinArgs);
+
+/*
+ * init option schemas. Each peripheral type parses its flags through its
+ * schema into the options struct kept in its registry slot (shell_bus.h);
+ * the schemas double as the options level of the argument word trie.
+ * Schemas and value lists are sorted by word.
+ */
+static const ShellWord_t uartFlowWords[] = {
+    { "cts",    NULL, UART_HWCONTROL_CTS },
+    { "none",   NULL, UART_HWCONTROL_NONE },
+    { "rts",    NULL, UART_HWCONTROL_RTS },
+    { "rtscts", NULL, UART_HWCONTROL_RTS_CTS },
+};
+static const ShellWord_t uartModeWords[] = {
+    { "rx",    NULL, UART_MODE_RX },
+    { "tx",    NULL, UART_MODE_TX },
+    { "tx_rx", NULL, UART_MODE_TX_RX },
+};
+static const ShellWord_t uartParityWords[] = {
+    { "even", NULL, UART_PARITY_EVEN },
+    { "none", NULL, UART_PARITY_NONE },
+    { "odd",  NULL, UART_PARITY_ODD },
+};
+static const ShellWord_t uartStopWords[] = {
+    { "1", NULL, UART_STOPBITS_1 },
+    { "2", NULL, UART_STOPBITS_2 },
+};
+static const ShellWord_t uartLengthWords[] = {
+    { "8", NULL, UART_WORDLENGTH_8B },
+    { "9", NULL, UART_WORDLENGTH_9B },
+};
+static const ShellWords_t uartFlowValues = SHELL_WORDS(uartFlowWords, 0);
+static const ShellWords_t uartModeValues = SHELL_WORDS(uartModeWords, 0);
+static const ShellWords_t uartParityValues = SHELL_WORDS(uartParityWords, 0);
+static const ShellWords_t uartStopValues = SHELL_WORDS(uartStopWords, 0);
+static const ShellWords_t uartLengthValues = SHELL_WORDS(uartLengthWords, 0);
+
+static const ShellOpt_t uartOptionTable[] = {
+    SHELL_OPTION_INT("-baud", UartOptions_t, baudRate, 1200, 10500000, 115200),
+    SHELL_OPTION_ENUM("-fc", UartOptions_t, flowControl, uartFlowValues, UART_HWCONTROL_NONE),
+    SHELL_OPTION_ENUM("-m", UartOptions_t, mode, uartModeValues, UART_MODE_TX_RX),
+    SHELL_OPTION_ENUM("-p", UartOptions_t, parity, uartParityValues, UART_PARITY_NONE),
+    SHELL_OPTION_ENUM("-sb", UartOptions_t, stopBits, uartStopValues, UART_STOPBITS_1),
+    SHELL_OPTION_ENUM("-wl", UartOptions_t, wordLength, uartLengthValues, UART_WORDLENGTH_8B),
+};
+static const ShellWords_t uartOptions = SHELL_OPTIONS(uartOptionTable);
+
+static const ShellWord_t uartNameWords[] = {
+    { "uart4",  &uartOptions, 0 },
+    { "uart5",  &uartOptions, 0 },
+    { "usart1", &uartOptions, 0 },
+    { "usart2", &uartOptions, 0 },
+    { "usart3", &uartOptions, 0 },
+    { "usart6", &uartOptions, 0 },
+};
+static const ShellWords_t uartNames = SHELL_WORDS(uartNameWords, 0);
+
+static const ShellWord_t i2cAddrModeWords[] = {
+    { "10", NULL, I2C_ADDRESSINGMODE_10BIT },
+    { "7",  NULL, I2C_ADDRESSINGMODE_7BIT },
+};
+static const ShellWord_t i2cDutyWords[] = {
+    { "16_9", NULL, I2C_DUTYCYCLE_16_9 },
+    { "2",    NULL, I2C_DUTYCYCLE_2 },
+};
+static const ShellWords_t i2cAddrModeValues = SHELL_WORDS(i2cAddrModeWords, 0);
+static const ShellWords_t i2cDutyValues = SHELL_WORDS(i2cDutyWords, 0);
+
+static const ShellOpt_t i2cOptionTable[] = {
+    SHELL_OPTION_ENUM("-addrmode", I2cOptions_t, addressingMode, i2cAddrModeValues, I2C_ADDRESSINGMODE_7BIT),
+    SHELL_OPTION_INT("-clkspeed", I2cOptions_t, clockSpeed, 1, 400000, 100000),
+    SHELL_OPTION_ENUM("-dc", I2cOptions_t, dutyCycle, i2cDutyValues, I2C_DUTYCYCLE_2),
+    SHELL_OPTION_BOOL("-dual", I2cOptions_t, dualAddress, 0),
+    SHELL_OPTION_BOOL("-engc", I2cOptions_t, generalCall, 0),
+    SHELL_OPTION_BOOL("-nostrech", I2cOptions_t, noStretch, 0),
+    SHELL_OPTION_INT("-ownaddr1", I2cOptions_t, ownAddress1, 0, 0x3FF, 0),
+    SHELL_OPTION_INT("-ownaddr2", I2cOptions_t, ownAddress2, 0, 0xFF, 0),
+};
+static const ShellWords_t i2cOptions = SHELL_OPTIONS(i2cOptionTable);
+
+static const ShellWord_t i2cNameWords[] = {
+    { "i2c1", &i2cOptions, 0 },
+    { "i2c2", &i2cOptions, 0 },
+    { "i2c3", &i2cOptions, 0 },
+};
+static const ShellWords_t i2cNames = SHELL_WORDS(i2cNameWords, 0);
+
+static const ShellWord_t spiPrescalerWords[] = {
+    { "128", NULL, SPI_BAUDRATEPRESCALER_128 },
+    { "16",  NULL, SPI_BAUDRATEPRESCALER_16 },
+    { "2",   NULL, SPI_BAUDRATEPRESCALER_2 },
+    { "256", NULL, SPI_BAUDRATEPRESCALER_256 },
+    { "32",  NULL, SPI_BAUDRATEPRESCALER_32 },
+    { "4",   NULL, SPI_BAUDRATEPRESCALER_4 },
+    { "64",  NULL, SPI_BAUDRATEPRESCALER_64 },
+    { "8",   NULL, SPI_BAUDRATEPRESCALER_8 },
+};
+static const ShellWord_t spiPhaseWords[] = {
+    { "1edge", NULL, SPI_PHASE_1EDGE },
+    { "2edge", NULL, SPI_PHASE_2EDGE },
+};
+static const ShellWord_t spiDataSizeWords[] = {
+    { "16", NULL, SPI_DATASIZE_16BIT },
+    { "8",  NULL, SPI_DATASIZE_8BIT },
+};
+static const ShellWord_t spiDirWords[] = {
+    { "1line",         NULL, SPI_DIRECTION_1LINE },
+    { "2lines",        NULL, SPI_DIRECTION_2LINES },
+    { "2lines_rxonly", NULL, SPI_DIRECTION_2LINES_RXONLY },
+};
+static const ShellWord_t spiFirstBitWords[] = {
+    { "lsb", NULL, SPI_FIRSTBIT_LSB },
+    { "msb", NULL, SPI_FIRSTBIT_MSB },
+};
+static const ShellWord_t spiModeWords[] = {
+    { "master", NULL, SPI_MODE_MASTER },
+    { "slave",  NULL, SPI_MODE_SLAVE },
+};
+static const ShellWord_t spiNssWords[] = {
+    { "hard_input",  NULL, SPI_NSS_HARD_INPUT },
+    { "hard_output", NULL, SPI_NSS_HARD_OUTPUT },
+    { "soft",        NULL, SPI_NSS_SOFT },
+};
+static const ShellWord_t spiPolarityWords[] = {
+    { "high", NULL, SPI_POLARITY_HIGH },
+    { "low",  NULL, SPI_POLARITY_LOW },
+};
+static const ShellWords_t spiPrescalerValues = SHELL_WORDS(spiPrescalerWords, 0);
+static const ShellWords_t spiPhaseValues = SHELL_WORDS(spiPhaseWords, 0);
+static const ShellWords_t spiDataSizeValues = SHELL_WORDS(spiDataSizeWords, 0);
+static const ShellWords_t spiDirValues = SHELL_WORDS(spiDirWords, 0);
+static const ShellWords_t spiFirstBitValues = SHELL_WORDS(spiFirstBitWords, 0);
+static const ShellWords_t spiModeValues = SHELL_WORDS(spiModeWords, 0);
+static const ShellWords_t spiNssValues = SHELL_WORDS(spiNssWords, 0);
+static const ShellWords_t spiPolarityValues = SHELL_WORDS(spiPolarityWords, 0);
+
+static const ShellOpt_t spiOptionTable[] = {
+    SHELL_OPTION_ENUM("-baudr_psc", SpiOptions_t, baudRatePrescaler, spiPrescalerValues, SPI_BAUDRATEPRESCALER_2),
+    SHELL_OPTION_ENUM("-clkphase", SpiOptions_t, clkPhase, spiPhaseValues, SPI_PHASE_1EDGE),
+    SHELL_OPTION_BOOL("-crccalc", SpiOptions_t, crcCalculation, 0),
+    SHELL_OPTION_INT("-crcpoly", SpiOptions_t, crcPolynomial, 1, 0xFFFF, 10),
+    SHELL_OPTION_ENUM("-datasize", SpiOptions_t, dataSize, spiDataSizeValues, SPI_DATASIZE_8BIT),
+    SHELL_OPTION_ENUM("-dir", SpiOptions_t, direction, spiDirValues, SPI_DIRECTION_2LINES),
+    SHELL_OPTION_ENUM("-firstbit", SpiOptions_t, firstBit, spiFirstBitValues, SPI_FIRSTBIT_MSB),
+    SHELL_OPTION_ENUM("-m", SpiOptions_t, mode, spiModeValues, SPI_MODE_MASTER),
+    SHELL_OPTION_ENUM("-nss", SpiOptions_t, nss, spiNssValues, SPI_NSS_SOFT),
+    SHELL_OPTION_ENUM("-pol", SpiOptions_t, clkPolarity, spiPolarityValues, SPI_POLARITY_LOW),
+    SHELL_OPTION_BOOL("-timode", SpiOptions_t, tiMode, 0),
+};
+static const ShellWords_t spiOptions = SHELL_OPTIONS(spiOptionTable);
+
+static const ShellWord_t spiNameWords[] = {
+    { "spi1", &spiOptions, 0 },
+    { "spi2", &spiOptions, 0 },
+    { "spi3", &spiOptions, 0 },
+};
+static const ShellWords_t spiNames = SHELL_WORDS(spiNameWords, 0);
+
+static const ShellWord_t timClockDivWords[] = {
+    { "1", NULL, TIM_CLOCKDIVISION_DIV1 },
+    { "2", NULL, TIM_CLOCKDIVISION_DIV2 },
+    { "4", NULL, TIM_CLOCKDIVISION_DIV4 },
+};
+static const ShellWord_t timCountModeWords[] = {
+    { "center1", NULL, TIM_COUNTERMODE_CENTERALIGNED1 },
+    { "center2", NULL, TIM_COUNTERMODE_CENTERALIGNED2 },
+    { "center3", NULL, TIM_COUNTERMODE_CENTERALIGNED3 },
+    { "down",    NULL, TIM_COUNTERMODE_DOWN },
+    { "up",      NULL, TIM_COUNTERMODE_UP },
+};
+static const ShellWords_t timClockDivValues = SHELL_WORDS(timClockDivWords, 0);
+static const ShellWords_t timCountModeValues = SHELL_WORDS(timCountModeWords, 0);
+
+static const ShellOpt_t timOptionTable[] = {
+    SHELL_OPTION_BOOL("-autoreload", TimOptions_t, autoReload, 1),
+    SHELL_OPTION_ENUM("-clockdiv", TimOptions_t, clockDivision, timClockDivValues, TIM_CLOCKDIVISION_DIV1),
+    SHELL_OPTION_ENUM("-countmode", TimOptions_t, counterMode, timCountModeValues, TIM_COUNTERMODE_UP),
+    SHELL_OPTION_INT("-period", TimOptions_t, period, 0, UINT32_MAX, 1000),
+    SHELL_OPTION_INT("-prescaler", TimOptions_t, prescaler, 0, 0xFFFF, 8400),
+    SHELL_OPTION_INT("-repcounter", TimOptions_t, repetitionCounter, 0, 0xFF, 0),
+};
+static const ShellWords_t timOptions = SHELL_OPTIONS(timOptionTable);
+
+static const ShellWord_t timNameWords[] = {
+    { "tim1",  &timOptions, 0 }, { "tim10", &timOptions, 0 }, { "tim11", &timOptions, 0 },
+    { "tim12", &timOptions, 0 }, { "tim13", &timOptions, 0 }, { "tim14", &timOptions, 0 },
+    { "tim2",  &timOptions, 0 }, { "tim3",  &timOptions, 0 }, { "tim4",  &timOptions, 0 },
+    { "tim5",  &timOptions, 0 }, { "tim6",  &timOptions, 0 }, { "tim7",  &timOptions, 0 },
+    { "tim8",  &timOptions, 0 }, { "tim9",  &timOptions, 0 },
+};
+static const ShellWords_t timNames = SHELL_WORDS(timNameWords, 0);
+
+static const ShellWord_t rtcClockWords[] = {
+    { "hse", NULL, RCC_RTCCLKSOURCE_HSE_DIV8 },
+    { "lse", NULL, RCC_RTCCLKSOURCE_LSE },
+    { "lsi", NULL, RCC_RTCCLKSOURCE_LSI },
+};
+static const ShellWord_t rtcFormatWords[] = {
+    { "12", NULL, RTC_HOURFORMAT_12 },
+    { "24", NULL, RTC_HOURFORMAT_24 },
+};
+static const ShellWords_t rtcClockValues = SHELL_WORDS(rtcClockWords, 0);
+static const ShellWords_t rtcFormatValues = SHELL_WORDS(rtcFormatWords, 0);
+
+// defaults give 1 Hz from a 32.768 kHz LSE
+static const ShellOpt_t rtcOptionTable[] = {
+    SHELL_OPTION_INT("-asyncpre", RtcOptions_t, asynchPrediv, 0, 0x7F, 127),
+    SHELL_OPTION_ENUM("-clock", RtcOptions_t, clockSource, rtcClockValues, RCC_RTCCLKSOURCE_LSE),
+    SHELL_OPTION_ENUM("-format", RtcOptions_t, hourFormat, rtcFormatValues, RTC_HOURFORMAT_24),
+    SHELL_OPTION_INT("-syncpre", RtcOptions_t, synchPrediv, 0, 0x7FFF, 255),
+};
+static const ShellWords_t rtcOptions = SHELL_OPTIONS(rtcOptionTable);
+
+static const ShellWord_t initWords[] = {
+    { "i2c",   &i2cNames, 0 },
+    { "list",  NULL, 0 },
+    { "rtc",   &rtcOptions, 0 },
+    { "spi",   &spiNames, 0 },
+    { "tim",   &timNames, 0 },
+    { "usart", &uartNames, 0 },
+};
+static const ShellWords_t initArgs = SHELL_WORDS(initWords, 0);
 
 /**
   * @brief  initialize selected peripheral
@@ -325,27 +670,38 @@ void shell_cmd_pin(Shell_Handle_t *handle, int argc, char *argv[])
   */
 void shell_cmd_init(Shell_Handle_t *handle, int argc, char *argv[]) 
 {
-    static UART_Config_t uart_configs[6] = {0};
-    static I2C_Config_t i2c_configs[3] = {0};
-    static SPI_Config_t spi_configs[6] = {0};
-    static TIM_Config_t tim_configs[14] = {0};
-    static RTC_Config_t rtc_config = {0};
-    
-    if (argc < 3) 
+    // rtc has a single instance, its options follow the type directly
+    ShellPeriphType_t type = (argc > 1) ? Shell_PeriphTypeFind(argv[1]) : SHELL_PERIPH_NONE;
+    bool is_rtc = (SHELL_PERIPH_RTC == type);
+
+    if ((2 == argc) && (0 == strcmp(argv[1], "list"))) 
+    {
+        Shell_Lock(SHELL_LOCK_BUS);
+        init_list(handle);
+        Shell_Unlock(SHELL_LOCK_BUS);
+        return;
+    }
+
+    if ((argc < 2) || ((argc < 3) && !is_rtc)) 
     {
         sh_print(handle, "Usage: init <peripheral_type> <peripheral_name> [options]\r\n");
+        sh_print(handle, "       init list\r\n");
         sh_print(handle, "\r\nAvailable peripherals and options:\r\n");
         sh_print(handle, "1. USART/UART:\r\n");
-        sh_print(handle, "   init usart <usart1/uart4/etc> [-baud <rate>] [-wl <7/8/9>] [-sb <0.5/1/1.5/2>]\r\n");
-        sh_print(handle, "   [-p <none/odd/even>] [-m <tx/rx/tx_rx>] [-os <8/16>]\r\n\n");
+        sh_print(handle, "   init usart <usart1/uart4/etc>\r\n");
+        Shell_PrintOptions(handle, &uartOptions);
         sh_print(handle, "2. I2C:\r\n");
-        sh_print(handle, "   init i2c <i2c1/i2c2/i2c3> [-speed <std/fast/high>] [-addr <7/10>]\r\n\n");
+        sh_print(handle, "   init i2c <i2c1/i2c2/i2c3>\r\n");
+        Shell_PrintOptions(handle, &i2cOptions);
         sh_print(handle, "3. SPI:\r\n");
-        sh_print(handle, "   init spi <spi1/spi2/etc> [-mode <0/1/2/3>] [-df <8/16>] [-br <2/4/.../256>]\r\n\n");
+        sh_print(handle, "   init spi <spi1/spi2/spi3>\r\n");
+        Shell_PrintOptions(handle, &spiOptions);
         sh_print(handle, "4. TIMER:\r\n");
-        sh_print(handle, "   init tim <tim1/tim2/etc> [-period <ms>] [-prescaler <value>]\r\n\n");
+        sh_print(handle, "   init tim <tim1/tim2/etc>\r\n");
+        Shell_PrintOptions(handle, &timOptions);
         sh_print(handle, "5. RTC:\r\n");
-        sh_print(handle, "   init rtc [-clock <lse/lsi/hse>] [-format <12/24>]\r\n");
+        sh_print(handle, "   init rtc\r\n");
+        Shell_PrintOptions(handle, &rtcOptions);
         return;
     }
 
@@ -353,458 +709,358 @@ void shell_cmd_init(Shell_Handle_t *handle, int argc, char *argv[])
     const char* peripheral_name = argv[2];
     char buf[256];
 
-    // Parse arguments
-    ShellArg_t args[10];
-    int arg_count = parse_args(argc, argv, 3, args, 10);
-
-    if (0 == strcmp(peripheral_type, "UART") || 0 == strcmp(peripheral_type, "USART") || 0 == strcmp(peripheral_type, "usart") || 0 == strcmp(peripheral_type, "uart")) 
+    // slots, pins and clocks are shared with the other sessions
+    Shell_Lock(SHELL_LOCK_BUS);
+    if (SHELL_PERIPH_USART == type) 
     {
-        init_uart(handle, peripheral_name, args, arg_count);
+        init_uart(handle, peripheral_name, argc - 3, &argv[3]);
     }
-    else if (0 == strcmp(peripheral_type, "I2C") || 0 == strcmp(peripheral_type, "i2c")) 
+    else if (SHELL_PERIPH_I2C == type) 
     {
-        init_i2c(handle, peripheral_name, args, arg_count);
+        init_i2c(handle, peripheral_name, argc - 3, &argv[3]);
     }
-    else if (0 == strcmp(peripheral_type, "SPI") || 0 == strcmp(peripheral_type, "spi")) 
+    else if (SHELL_PERIPH_SPI == type) 
     {
-        init_spi(handle, peripheral_name, args, arg_count);
+        init_spi(handle, peripheral_name, argc - 3, &argv[3]);
     }
-    else if (0 == strcmp(peripheral_type, "TIM") || 0 == strcmp(peripheral_type, "tim")) 
+    else if (SHELL_PERIPH_TIM == type) 
     {
-        init_timer(handle, peripheral_name, args, arg_count);
+        init_timer(handle, peripheral_name, argc - 3, &argv[3]);
     }
-    else if (0 == strcmp(peripheral_type, "RTC") || 0 == strcmp(peripheral_type, "rtc")) 
+    else if (is_rtc) 
     {
-        init_rtc(handle, args, arg_count);
+        init_rtc(handle, argc - 2, &argv[2]);
     }
     else 
     {
         sprintf(buf, "Unknown peripheral type: %s\r\n", peripheral_type);
         sh_print(handle, buf);
     }
+    Shell_Unlock(SHELL_LOCK_BUS);
 }
+SHELL_COMMAND_ARGS(init, "Initialize peripheral", "init <type> <name> [options] | init list", shell_cmd_init, &initArgs);
 
 /**
   * @brief  initialize selected UART peripheral
+  * @note   an instance already running with the same options is left alone;
+  *         the oversampling is the one with the smaller rate error
   * @param handle shell handle
   * @param argc argument count
   * @param argv argument vector
   * @retval None
   */
-static void init_uart(Shell_Handle_t *handle, const char* peripheral_name, ShellArg_t *args, int arg_count) 
+static void init_uart(Shell_Handle_t *handle, const char* peripheral_name, int argc, char *argv[]) 
 {
     char buf[256];
-    USART_TypeDef* usart_base = get_usart_base(peripheral_name);
-    if (NULL == usart_base) 
+    UartOptions_t opt;
+    UART_Config_t *slot = Shell_BusUart(Shell_PeriphFind(SHELL_PERIPH_USART, peripheral_name));
+    if (NULL == slot) 
     {
         sprintf(buf, "Invalid UART instance: %s\r\n", peripheral_name);
         sh_print(handle, buf);
         return;
     }
 
-    // Enable GPIO and UART clocks
-    if (usart_base == USART1) 
-    {
-        __HAL_RCC_USART1_CLK_ENABLE();
-        __HAL_RCC_GPIOA_CLK_ENABLE(); // PA9/PA10
-    } 
-    else if (usart_base == USART2) 
-    {
-        __HAL_RCC_USART2_CLK_ENABLE();
-        __HAL_RCC_GPIOA_CLK_ENABLE(); // PA2/PA3
-    }
-    else if (usart_base == USART3) 
-    {
-        __HAL_RCC_USART3_CLK_ENABLE();
-        __HAL_RCC_GPIOB_CLK_ENABLE(); // PB10/PB11
-    }
-    else if (usart_base == UART4) 
-    {
-        __HAL_RCC_UART4_CLK_ENABLE();
-        __HAL_RCC_GPIOA_CLK_ENABLE(); // PA0/PA1
-    }
-    else if (usart_base == UART5) 
-    {
-        __HAL_RCC_UART5_CLK_ENABLE();
-        __HAL_RCC_GPIOD_CLK_ENABLE(); // PD2
-        __HAL_RCC_GPIOC_CLK_ENABLE(); // PC12
-    }
-    else if (usart_base == USART6) 
-    {
-        __HAL_RCC_USART6_CLK_ENABLE();
-        __HAL_RCC_GPIOC_CLK_ENABLE(); // PC6/PC7
-    }
-    
-    // Get parameters with defaults
-    const char* baud_str = get_arg_value(args, arg_count, "baud", "115200");
-    const char* wordlen_str = get_arg_value(args, arg_count, "wl", "8");
-    const char* stopbits_str = get_arg_value(args, arg_count, "sb", "1");
-    const char* parity_str = get_arg_value(args, arg_count, "p", "none");
-    const char* mode_str = get_arg_value(args, arg_count, "m", "tx_rx");
-
-    // Configure GPIO
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
-    GPIO_InitStruct.Pull = GPIO_PULLUP;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
-    
-    if (usart_base == USART1) 
-    {
-        GPIO_InitStruct.Alternate = GPIO_AF7_USART1;
-        GPIO_InitStruct.Pin = GPIO_PIN_9|GPIO_PIN_10;
-        HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
-    }
-    else if (usart_base == USART2) 
+    if (SHELL_BUS_RESERVED == slot->state) 
     {
-        GPIO_InitStruct.Alternate = GPIO_AF7_USART2;
-        GPIO_InitStruct.Pin = GPIO_PIN_2|GPIO_PIN_3;
-        HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+        sprintf(buf, "%s is in use by the firmware\r\n", slot->periph->name);
+        sh_print(handle, buf);
+        return;
     }
-    else if (usart_base == USART3) 
+
+    if (!Shell_ParseOptions(handle, &uartOptions, argc, argv, &opt)) 
     {
-        GPIO_InitStruct.Alternate = GPIO_AF7_USART3;
-        GPIO_InitStruct.Pin = GPIO_PIN_10|GPIO_PIN_11;
-        HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+        return;
     }
-    else if (usart_base == UART4) 
+
+    // -baud spans both oversamplings, take the one that gets closest
+    UART_HandleTypeDef probe = { .Instance = (USART_TypeDef *)slot->periph->base };
+    ShellBaud_t baud;
+    if (!Shell_BaudBest(Shell_BaudClock(&probe), opt.baudRate, &baud) || (baud.error > SHELL_BAUD_MAX_ERROR)) 
     {
-        GPIO_InitStruct.Alternate = GPIO_AF8_UART4;
-        GPIO_InitStruct.Pin = GPIO_PIN_0|GPIO_PIN_1;
-        HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+        sprintf(buf, "%lu baud is out of reach of %s\r\n", (unsigned long)opt.baudRate, slot->periph->name);
+        sh_print(handle, buf);
+        return;
     }
-    else if (usart_base == UART5) 
+
+    // RTS/CTS pins first, a UART without them is left as it is
+    if (!Shell_PeriphEnableFlow(slot->periph, opt.flowControl)) 
     {
-        GPIO_InitStruct.Alternate = GPIO_AF8_UART5;
-        GPIO_InitStruct.Pin = GPIO_PIN_2;
-        HAL_GPIO_Init(GPIOD, &GPIO_InitStruct);
-        GPIO_InitStruct.Pin = GPIO_PIN_12;
-        HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
+        sprintf(buf, "%s has no RTS/CTS pins\r\n", slot->periph->name);
+        sh_print(handle, buf);
+        return;
     }
-    else if (usart_base == USART6) 
+
+    if (SHELL_BUS_READY == slot->state) 
     {
-        GPIO_InitStruct.Alternate = GPIO_AF8_USART6;
-        GPIO_InitStruct.Pin = GPIO_PIN_6|GPIO_PIN_7;
-        HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
+        if (0 == memcmp(&opt, &slot->options, sizeof(opt))) 
+        {
+            init_report(handle, slot->periph->name, "already initialized", &uartOptions, &slot->options);
+            return;
+        }
+        HAL_UART_DeInit(&slot->handle);
     }
 
+    // Enable clocks and route the pins
+    Shell_PeriphEnable(slot->periph);
+
     // Initialize UART
-    UART_HandleTypeDef huart = {0};
-    huart.Instance = usart_base;
-    huart.Init.BaudRate = atoi(baud_str);
-    huart.Init.WordLength = (strcmp(wordlen_str, "9") == 0) ? UART_WORDLENGTH_9B : UART_WORDLENGTH_8B;
-    huart.Init.StopBits = (strcmp(stopbits_str, "2") == 0) ? UART_STOPBITS_2 : UART_STOPBITS_1;
-    huart.Init.Parity = (strcmp(parity_str, "none") == 0) ? UART_PARITY_NONE : 
-                        (strcmp(parity_str, "odd") == 0) ? UART_PARITY_ODD : UART_PARITY_EVEN;
-    huart.Init.Mode = (strcmp(mode_str, "tx") == 0) ? UART_MODE_TX :
-                      (strcmp(mode_str, "rx") == 0) ? UART_MODE_RX : UART_MODE_TX_RX;
-    huart.Init.HwFlowCtl = UART_HWCONTROL_NONE;
-    huart.Init.OverSampling = UART_OVERSAMPLING_16;
-
-    if (HAL_OK != HAL_UART_Init(&huart)) 
-    {
-        sprintf(buf, "Failed to initialize %s\r\n", peripheral_name);
+    memset(&slot->handle, 0, sizeof(slot->handle));
+    slot->options = opt;
+    slot->handle.Instance = (USART_TypeDef *)slot->periph->base;
+    slot->handle.Init.BaudRate = opt.baudRate;
+    slot->handle.Init.WordLength = opt.wordLength;
+    slot->handle.Init.StopBits = opt.stopBits;
+    slot->handle.Init.Parity = opt.parity;
+    slot->handle.Init.Mode = opt.mode;
+    slot->handle.Init.HwFlowCtl = opt.flowControl;
+    slot->handle.Init.OverSampling = baud.overSampling;
+
+    if (HAL_OK != HAL_UART_Init(&slot->handle)) 
+    {
+        slot->state = SHELL_BUS_ERROR;
+        sprintf(buf, "Failed to initialize %s\r\n", slot->periph->name);
         sh_print(handle, buf);
         return;
     }
 
-    sprintf(buf, "%s initialized successfully\r\n", peripheral_name);
-    sh_print(handle, buf);
+    slot->state = SHELL_BUS_READY;
+    init_report(handle, slot->periph->name, "initialized", &uartOptions, &slot->options);
 }
 
 /**
   * @brief  initialize selected SPI peripheral
+  * @note   an instance already running with the same options is left alone
   * @param handle shell handle
   * @param argc argument count
   * @param argv argument vector
   * @retval None
   */
-static void init_spi(Shell_Handle_t *handle, const char* peripheral_name, ShellArg_t *args, int arg_count) 
+static void init_spi(Shell_Handle_t *handle, const char* peripheral_name, int argc, char *argv[]) 
 {
     char buf[256];
-    SPI_TypeDef* spi_base = get_spi_base(peripheral_name);
-    if (NULL == spi_base) 
+    SpiOptions_t opt;
+    SPI_Config_t *slot = Shell_BusSpi(Shell_PeriphFind(SHELL_PERIPH_SPI, peripheral_name));
+    if (NULL == slot) 
     {
         sprintf(buf, "Invalid SPI instance: %s\r\n", peripheral_name);
         sh_print(handle, buf);
         return;
     }
 
-    // Enable GPIO and SPI clocks
-    if (spi_base == SPI1) 
-    {
-        __HAL_RCC_SPI1_CLK_ENABLE();
-        __HAL_RCC_GPIOA_CLK_ENABLE(); // PA5 - PA7
-    } 
-    else if (spi_base == SPI2) 
-    {
-        __HAL_RCC_SPI2_CLK_ENABLE();
-        __HAL_RCC_GPIOC_CLK_ENABLE(); 
-        __HAL_RCC_GPIOB_CLK_ENABLE();
-    }
-    else if (spi_base == SPI3) 
-    {
-        __HAL_RCC_SPI3_CLK_ENABLE();  
-        __HAL_RCC_GPIOC_CLK_ENABLE(); // PC10 - PC12
-    }
-
-    // Get parameters with defaults
-    const char* mode_str = get_arg_value(args, arg_count, "m", "master");
-    const char* dir_str = get_arg_value(args, arg_count, "dir", "2lines");
-    const char* datasize_str = get_arg_value(args, arg_count, "datasize", "8");
-    const char* pol_str = get_arg_value(args, arg_count, "pol", "low");
-    const char* clkphase_str = get_arg_value(args, arg_count, "clkphase", "1edge");
-    const char* nss_str = get_arg_value(args, arg_count, "nss", "soft");
-    const char* baudr_psc_str = get_arg_value(args, arg_count, "baudr_psc", "2");
-    const char* firstbit_str = get_arg_value(args, arg_count, "firstbit", "msb");
-    const char* timode_str = get_arg_value(args, arg_count, "timode", "disable");
-    const char* crccalc_str = get_arg_value(args, arg_count, "crccalc", "disable");
-    const char* crcpoly_str = get_arg_value(args, arg_count, "crcpoly", "10");
-    
-
-    // Configure GPIO
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
-    GPIO_InitStruct.Pull = GPIO_NOPULL;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
-    
-    if (spi_base == SPI1) 
+    if (!Shell_ParseOptions(handle, &spiOptions, argc, argv, &opt)) 
     {
-        GPIO_InitStruct.Alternate = GPIO_AF5_SPI1;
-        GPIO_InitStruct.Pin = GPIO_PIN_5|GPIO_PIN_6|GPIO_PIN_7;
-        HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+        return;
     }
-    else if (spi_base == SPI2) 
-    {
-        GPIO_InitStruct.Alternate = GPIO_AF5_SPI2;
-        GPIO_InitStruct.Pin = GPIO_PIN_2|GPIO_PIN_3;
-        HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
 
-        GPIO_InitStruct.Alternate = GPIO_AF5_SPI2;
-        GPIO_InitStruct.Pin = GPIO_PIN_10;
-        HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
-    }
-    else if (spi_base == SPI3) 
+    if (SHELL_BUS_READY == slot->state) 
     {
-        GPIO_InitStruct.Alternate = GPIO_AF6_SPI3;
-        GPIO_InitStruct.Pin = GPIO_PIN_10|GPIO_PIN_11|GPIO_PIN_12;
-        HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
+        if (0 == memcmp(&opt, &slot->options, sizeof(opt))) 
+        {
+            init_report(handle, slot->periph->name, "already initialized", &spiOptions, &slot->options);
+            return;
+        }
+        HAL_SPI_DeInit(&slot->handle);
     }
 
+    // Enable clocks and route the pins
+    Shell_PeriphEnable(slot->periph);
+
     // Initialize SPI
-    SPI_HandleTypeDef hspi = {0};
-    hspi.Instance = spi_base;
-    hspi.Init.Mode = (strcmp(mode_str, "master") == 0) ? SPI_MODE_MASTER : SPI_MODE_SLAVE;
-    hspi.Init.Direction = (strcmp(dir_str, "2lines") == 0) ? SPI_DIRECTION_2LINES : 
-                          (strcmp(dir_str, "2lines_rxonly") == 0) ? SPI_DIRECTION_2LINES_RXONLY : SPI_DIRECTION_1LINE;
-    hspi.Init.DataSize = (strcmp(datasize_str, "8") == 0) ? SPI_DATASIZE_8BIT : SPI_DATASIZE_16BIT;
-    hspi.Init.CLKPolarity = (strcmp(pol_str, "low") == 0) ? SPI_POLARITY_LOW : SPI_POLARITY_HIGH;
-    hspi.Init.CLKPhase = (strcmp(clkphase_str, "1edge") == 0) ? SPI_PHASE_1EDGE : SPI_PHASE_2EDGE;
-    hspi.Init.NSS = (strcmp(nss_str, "soft") == 0) ? SPI_NSS_SOFT : 
-                    (strcmp(nss_str, "hard_input") == 0) ?  SPI_NSS_HARD_INPUT : SPI_NSS_HARD_OUTPUT;
-    hspi.Init.BaudRatePrescaler = (strcmp(baudr_psc_str, "2") == 0) ? SPI_BAUDRATEPRESCALER_2 : 
-                                  (strcmp(baudr_psc_str, "4") == 0) ? SPI_BAUDRATEPRESCALER_4 : 
-                                  (strcmp(baudr_psc_str, "8") == 0) ? SPI_BAUDRATEPRESCALER_8 : 
-                                  (strcmp(baudr_psc_str, "16") == 0) ? SPI_BAUDRATEPRESCALER_16 : 
-                                  (strcmp(baudr_psc_str, "32") == 0) ? SPI_BAUDRATEPRESCALER_32 : 
-                                  (strcmp(baudr_psc_str, "64") == 0) ? SPI_BAUDRATEPRESCALER_64 : 
-                                  (strcmp(baudr_psc_str, "128") == 0) ? SPI_BAUDRATEPRESCALER_128 : SPI_BAUDRATEPRESCALER_256;
-    hspi.Init.FirstBit = (strcmp(firstbit_str, "msb") == 0) ? SPI_FIRSTBIT_MSB : SPI_FIRSTBIT_LSB;
-    hspi.Init.TIMode = (strcmp(timode_str, "enable") == 0) ? SPI_TIMODE_ENABLE : SPI_TIMODE_DISABLE;
-    hspi.Init.CRCCalculation = (strcmp(crccalc_str, "enable") == 0) ? SPI_CRCCALCULATION_ENABLE : SPI_CRCCALCULATION_DISABLE;
-    hspi.Init.CRCPolynomial = atoi(crcpoly_str);
-
-    if (HAL_OK != HAL_SPI_Init(&hspi)) 
-    {
-        sprintf(buf, "Failed to initialize %s\r\n", peripheral_name);
+    memset(&slot->handle, 0, sizeof(slot->handle));
+    slot->options = opt;
+    slot->handle.Instance = (SPI_TypeDef *)slot->periph->base;
+    slot->handle.Init.Mode = opt.mode;
+    slot->handle.Init.Direction = opt.direction;
+    slot->handle.Init.DataSize = opt.dataSize;
+    slot->handle.Init.CLKPolarity = opt.clkPolarity;
+    slot->handle.Init.CLKPhase = opt.clkPhase;
+    slot->handle.Init.NSS = opt.nss;
+    slot->handle.Init.BaudRatePrescaler = opt.baudRatePrescaler;
+    slot->handle.Init.FirstBit = opt.firstBit;
+    slot->handle.Init.TIMode = opt.tiMode ? SPI_TIMODE_ENABLE : SPI_TIMODE_DISABLE;
+    slot->handle.Init.CRCCalculation = opt.crcCalculation ? SPI_CRCCALCULATION_ENABLE : SPI_CRCCALCULATION_DISABLE;
+    slot->handle.Init.CRCPolynomial = opt.crcPolynomial;
+
+    if (HAL_OK != HAL_SPI_Init(&slot->handle)) 
+    {
+        slot->state = SHELL_BUS_ERROR;
+        sprintf(buf, "Failed to initialize %s\r\n", slot->periph->name);
         sh_print(handle, buf);
         return;
     }
 
-    sprintf(buf, "%s initialized successfully\r\n", peripheral_name);
-    sh_print(handle, buf);
+    slot->state = SHELL_BUS_READY;
+    init_report(handle, slot->periph->name, "initialized", &spiOptions, &slot->options);
 }
 
 /**
   * @brief  initialize selected I2C peripheral
+  * @note   an instance already running with the same options is left alone
   * @param handle shell handle
   * @param argc argument count
   * @param argv argument vector
   * @retval None
   */
-static void init_i2c(Shell_Handle_t *handle, const char* peripheral_name, ShellArg_t *args, int arg_count) 
+static void init_i2c(Shell_Handle_t *handle, const char* peripheral_name, int argc, char *argv[]) 
 {
     char buf[256];
-    I2C_TypeDef* i2c_base = get_i2c_base(peripheral_name);
-    if (NULL == i2c_base) 
+    I2cOptions_t opt;
+    I2C_Config_t *slot = Shell_BusI2c(Shell_PeriphFind(SHELL_PERIPH_I2C, peripheral_name));
+    if (NULL == slot) 
     {
         sprintf(buf, "Invalid I2C instance: %s\r\n", peripheral_name);
         sh_print(handle, buf);
         return;
     }
 
-    // Enable GPIO and I2C clocks
-    if (i2c_base == I2C1) 
-    {
-        __HAL_RCC_I2C1_CLK_ENABLE();
-        __HAL_RCC_GPIOB_CLK_ENABLE(); // PB6/PB7
-    } 
-    else if (i2c_base == I2C2) 
-    {
-        __HAL_RCC_I2C2_CLK_ENABLE();
-        __HAL_RCC_GPIOB_CLK_ENABLE(); // PB10/PB11
-    }
-    else if (i2c_base == I2C3) 
-    {
-        __HAL_RCC_I2C3_CLK_ENABLE();
-        __HAL_RCC_GPIOA_CLK_ENABLE(); // PA8
-        __HAL_RCC_GPIOC_CLK_ENABLE(); //PC9
-    }
-    
-    
-    // Get parameters with defaults
-    const char* clkspeed_str = get_arg_value(args, arg_count, "clkspeed", "100000");
-    const char* dc_str = get_arg_value(args, arg_count, "dc", "2");
-    const char* ownaddr1_str = get_arg_value(args, arg_count, "ownaddr1", "0");
-    const char* addrmode_str = get_arg_value(args, arg_count, "addrmode", "7");
-    const char* dual_str = get_arg_value(args, arg_count, "dual", "disable");
-    const char* ownaddr2_str = get_arg_value(args, arg_count, "ownaddr2", "0");
-    const char* engc_str = get_arg_value(args, arg_count, "engc", "disable");
-    const char* nostrech_str = get_arg_value(args, arg_count, "nostrech", "disable");
-
-    // Configure GPIO
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Mode = GPIO_MODE_AF_OD;
-    GPIO_InitStruct.Pull = GPIO_NOPULL;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
-    
-    if (i2c_base == I2C1) 
-    {
-        GPIO_InitStruct.Alternate = GPIO_AF4_I2C1;
-        GPIO_InitStruct.Pin = GPIO_PIN_6|GPIO_PIN_7;
-        HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
-    }
-    else if (i2c_base == I2C2) 
+    if (!Shell_ParseOptions(handle, &i2cOptions, argc, argv, &opt)) 
     {
-        GPIO_InitStruct.Alternate = GPIO_AF4_I2C2;
-        GPIO_InitStruct.Pin = GPIO_PIN_10|GPIO_PIN_11;
-        HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+        return;
     }
-    else if (i2c_base == I2C3) 
+
+    if (SHELL_BUS_READY == slot->state) 
     {
-        GPIO_InitStruct.Alternate = GPIO_AF7_USART3;
-        GPIO_InitStruct.Pin = GPIO_PIN_10|GPIO_PIN_11;
-        HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+        if (0 == memcmp(&opt, &slot->options, sizeof(opt))) 
+        {
+            init_report(handle, slot->periph->name, "already initialized", &i2cOptions, &slot->options);
+            return;
+        }
+        HAL_I2C_DeInit(&slot->handle);
     }
 
+    // Enable clocks and route the pins
+    Shell_PeriphEnable(slot->periph);
+
     // Initialize I2C
-    I2C_HandleTypeDef hi2c = {0};
-    hi2c.Instance = i2c_base;
-    hi2c.Init.ClockSpeed = atoi(clkspeed_str);
-    hi2c.Init.DutyCycle = (strcmp(dc_str, "2") == 0) ? I2C_DUTYCYCLE_2 : I2C_DUTYCYCLE_16_9;
-    hi2c.Init.OwnAddress1 = atoi(ownaddr1_str);
-    hi2c.Init.AddressingMode = (strcmp(addrmode_str, "7") == 0) ? I2C_ADDRESSINGMODE_7BIT : I2C_ADDRESSINGMODE_10BIT;
-    hi2c.Init.DualAddressMode = (strcmp(dual_str, "enable") == 0) ? I2C_DUALADDRESS_ENABLE : I2C_DUALADDRESS_DISABLE;
-    hi2c.Init.OwnAddress2 = atoi(ownaddr2_str);
-    hi2c.Init.GeneralCallMode = (strcmp(engc_str, "enable") == 0) ? I2C_GENERALCALL_ENABLE : I2C_GENERALCALL_DISABLE;
-    hi2c.Init.NoStretchMode = (strcmp(nostrech_str, "enable") == 0) ? I2C_NOSTRETCH_ENABLE : I2C_NOSTRETCH_DISABLE;
-
-    if (HAL_OK != HAL_I2C_Init(&hi2c)) 
-    {
-        sprintf(buf, "Failed to initialize %s\r\n", peripheral_name);
+    memset(&slot->handle, 0, sizeof(slot->handle));
+    slot->options = opt;
+    slot->handle.Instance = (I2C_TypeDef *)slot->periph->base;
+    slot->handle.Init.ClockSpeed = opt.clockSpeed;
+    slot->handle.Init.DutyCycle = opt.dutyCycle;
+    slot->handle.Init.OwnAddress1 = opt.ownAddress1;
+    slot->handle.Init.AddressingMode = opt.addressingMode;
+    slot->handle.Init.DualAddressMode = opt.dualAddress ? I2C_DUALADDRESS_ENABLE : I2C_DUALADDRESS_DISABLE;
+    slot->handle.Init.OwnAddress2 = opt.ownAddress2;
+    slot->handle.Init.GeneralCallMode = opt.generalCall ? I2C_GENERALCALL_ENABLE : I2C_GENERALCALL_DISABLE;
+    slot->handle.Init.NoStretchMode = opt.noStretch ? I2C_NOSTRETCH_ENABLE : I2C_NOSTRETCH_DISABLE;
+
+    if (HAL_OK != HAL_I2C_Init(&slot->handle)) 
+    {
+        slot->state = SHELL_BUS_ERROR;
+        sprintf(buf, "Failed to initialize %s\r\n", slot->periph->name);
         sh_print(handle, buf);
         return;
     }
 
-    sprintf(buf, "%s initialized successfully\r\n", peripheral_name);
-    sh_print(handle, buf);
+    slot->state = SHELL_BUS_READY;
+    init_report(handle, slot->periph->name, "initialized", &i2cOptions, &slot->options);
 }
 
 /**
   * @brief  initialize selected Timer peripheral
+  * @note   a timer already running with the same options is left alone
   * @param handle shell handle
   * @param argc argument count
   * @param argv argument vector
   * @retval None
   */
-static void init_timer(Shell_Handle_t *handle, const char* peripheral_name, ShellArg_t *args, int arg_count) 
+static void init_timer(Shell_Handle_t *handle, const char* peripheral_name, int argc, char *argv[]) 
 {
     char buf[256];
-    TIM_TypeDef* timer_base = get_timer_base(peripheral_name);
-    if (NULL == timer_base) 
+    TimOptions_t opt;
+    TIM_Config_t *slot = Shell_BusTim(Shell_PeriphFind(SHELL_PERIPH_TIM, peripheral_name));
+    if (NULL == slot) 
     {
         sprintf(buf, "Invalid Timer instance: %s\r\n", peripheral_name);
         sh_print(handle, buf);
         return;
     }
 
+    if (SHELL_BUS_RESERVED == slot->state) 
+    {
+        sprintf(buf, "%s is in use by the firmware\r\n", slot->periph->name);
+        sh_print(handle, buf);
+        return;
+    }
+
+    if (!Shell_ParseOptions(handle, &timOptions, argc, argv, &opt)) 
+    {
+        return;
+    }
+
+    if (SHELL_BUS_READY == slot->state) 
+    {
+        if (0 == memcmp(&opt, &slot->options, sizeof(opt))) 
+        {
+            init_report(handle, slot->periph->name, "already initialized", &timOptions, &slot->options);
+            return;
+        }
+        HAL_TIM_Base_Stop(&slot->handle);
+        HAL_TIM_Base_DeInit(&slot->handle);
+    }
+
     // Enable Timer clock
-    if (timer_base == TIM1) __HAL_RCC_TIM1_CLK_ENABLE();
-    else if (timer_base == TIM2) __HAL_RCC_TIM2_CLK_ENABLE();
-    else if (timer_base == TIM3) __HAL_RCC_TIM3_CLK_ENABLE();
-    else if (timer_base == TIM4) __HAL_RCC_TIM4_CLK_ENABLE();
-    else if (timer_base == TIM5) __HAL_RCC_TIM5_CLK_ENABLE();
-    else if (timer_base == TIM6) __HAL_RCC_TIM6_CLK_ENABLE();
-    else if (timer_base == TIM7) __HAL_RCC_TIM7_CLK_ENABLE();
-    else if (timer_base == TIM8) __HAL_RCC_TIM8_CLK_ENABLE();
-    else if (timer_base == TIM9) __HAL_RCC_TIM9_CLK_ENABLE();
-    else if (timer_base == TIM10) __HAL_RCC_TIM10_CLK_ENABLE();
-    else if (timer_base == TIM11) __HAL_RCC_TIM11_CLK_ENABLE();
-    else if (timer_base == TIM12) __HAL_RCC_TIM12_CLK_ENABLE();
-    else if (timer_base == TIM13) __HAL_RCC_TIM13_CLK_ENABLE();
-    else if (timer_base == TIM14) __HAL_RCC_TIM14_CLK_ENABLE();
-
-    // Get parameters with defaults
-    const char* period_str = get_arg_value(args, arg_count, "period", "1000");
-    const char* prescaler_str = get_arg_value(args, arg_count, "prescaler", "8400");
-    const char* clockdiv_str = get_arg_value(args, arg_count, "clockdiv", "1");
-    const char* countmode_str = get_arg_value(args, arg_count, "countmode", "up");
-    const char* autoreload_str = get_arg_value(args, arg_count, "autoreload", "enable");
-    const char* repcounter_str = get_arg_value(args, arg_count, "repcounter", "0");
+    Shell_PeriphEnable(slot->periph);
 
     // Initialize Timer
-    TIM_HandleTypeDef htim = {0};
-    htim.Instance = timer_base;
-    htim.Init.Period = atoi(period_str);
-    htim.Init.Prescaler = atoi(prescaler_str);
-    htim.Init.ClockDivision = (strcmp(clockdiv_str, "1") == 0) ? TIM_CLOCKDIVISION_DIV1 : 
-                              (strcmp(clockdiv_str, "2") == 0) ? TIM_CLOCKDIVISION_DIV2 : TIM_CLOCKDIVISION_DIV4;
-    htim.Init.CounterMode = (strcmp(countmode_str, "up") == 0) ? TIM_COUNTERMODE_UP : 
-                            (strcmp(countmode_str, "down") == 0) ? TIM_COUNTERMODE_DOWN : 
-                            (strcmp(countmode_str, "center1") == 0) ? TIM_COUNTERMODE_CENTERALIGNED1 :
-                            (strcmp(countmode_str, "center2") == 0) ? TIM_COUNTERMODE_CENTERALIGNED2 : 
-                            TIM_COUNTERMODE_CENTERALIGNED3;
-    htim.Init.AutoReloadPreload = (strcmp(autoreload_str, "enable") == 0) ? TIM_AUTORELOAD_PRELOAD_ENABLE : 
-                                  TIM_AUTORELOAD_PRELOAD_DISABLE;
-    htim.Init.RepetitionCounter = atoi(repcounter_str);
-
-    if (HAL_OK != HAL_TIM_Base_Init(&htim)) 
-    {
-        sprintf(buf, "Failed to initialize %s\r\n", peripheral_name);
+    memset(&slot->handle, 0, sizeof(slot->handle));
+    slot->options = opt;
+    slot->handle.Instance = (TIM_TypeDef *)slot->periph->base;
+    slot->handle.Init.Period = opt.period;
+    slot->handle.Init.Prescaler = opt.prescaler;
+    slot->handle.Init.ClockDivision = opt.clockDivision;
+    slot->handle.Init.CounterMode = opt.counterMode;
+    slot->handle.Init.AutoReloadPreload = opt.autoReload ? TIM_AUTORELOAD_PRELOAD_ENABLE : TIM_AUTORELOAD_PRELOAD_DISABLE;
+    slot->handle.Init.RepetitionCounter = opt.repetitionCounter;
+
+    if (HAL_OK != HAL_TIM_Base_Init(&slot->handle)) 
+    {
+        slot->state = SHELL_BUS_ERROR;
+        sprintf(buf, "Failed to initialize %s\r\n", slot->periph->name);
         sh_print(handle, buf);
         return;
     }
 
-    if (HAL_OK != HAL_TIM_Base_Start(&htim)) 
+    if (HAL_OK != HAL_TIM_Base_Start(&slot->handle)) 
     {
-        sprintf(buf, "Failed to start %s\r\n", peripheral_name);
+        slot->state = SHELL_BUS_ERROR;
+        sprintf(buf, "Failed to start %s\r\n", slot->periph->name);
         sh_print(handle, buf);
         return;
     }
 
-    sprintf(buf, "%s initialized successfully\r\n", peripheral_name);
-    sh_print(handle, buf);
+    slot->state = SHELL_BUS_READY;
+    init_report(handle, slot->periph->name, "initialized", &timOptions, &slot->options);
 }
 
 /**
   * @brief  initialize RTC
+  * @note   an RTC already running with the same options is left alone
   * @param handle shell handle
   * @param argc argument count
   * @param argv argument vector
   * @retval None
   */
-static void init_rtc(Shell_Handle_t *handle, ShellArg_t *args, int arg_count) 
+static void init_rtc(Shell_Handle_t *handle, int argc, char *argv[]) 
 {
-    char buf[256];
+    RtcOptions_t opt;
+    RTC_Config_t *slot = Shell_BusRtc();
+
+    if (!Shell_ParseOptions(handle, &rtcOptions, argc, argv, &opt)) 
+    {
+        return;
+    }
+
+    if (SHELL_BUS_READY == slot->state) 
+    {
+        if (0 == memcmp(&opt, &slot->options, sizeof(opt))) 
+        {
+            init_report(handle, "rtc", "already initialized", &rtcOptions, &slot->options);
+            return;
+        }
+        HAL_RTC_DeInit(&slot->handle);
+    }
 
     // Enable PWR Clock
     __HAL_RCC_PWR_CLK_ENABLE();
@@ -812,31 +1068,25 @@ static void init_rtc(Shell_Handle_t *handle, ShellArg_t *args, int arg_count)
     // Enable access to RTC
     HAL_PWR_EnableBkUpAccess();
 
-    // Get parameters with defaults
-    const char* clock_str = get_arg_value(args, arg_count, "clock", "lse");
-    const char* format_str = get_arg_value(args, arg_count, "format", "24");
-    const char* asyncpre_str = get_arg_value(args, arg_count, "asyncpre", "128");
-    const char* syncpre_str = get_arg_value(args, arg_count, "syncpre", "256");
-
     // Configure RTC clock source
     RCC_OscInitTypeDef RCC_OscInitStruct = {0};
     RCC_PeriphCLKInitTypeDef PeriphClkInitStruct = {0};
 
-    if (strcmp(clock_str, "lse") == 0) 
+    if (RCC_RTCCLKSOURCE_LSE == opt.clockSource) 
     {
         RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_LSE;
         RCC_OscInitStruct.LSEState = RCC_LSE_ON;
         RCC_OscInitStruct.PLL.PLLState = RCC_PLL_NONE;
         PeriphClkInitStruct.RTCClockSelection = RCC_RTCCLKSOURCE_LSE;
     } 
-    else if (strcmp(clock_str, "lsi") == 0) 
+    else if (RCC_RTCCLKSOURCE_LSI == opt.clockSource) 
     {
         RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_LSI;
         RCC_OscInitStruct.LSIState = RCC_LSI_ON;
         RCC_OscInitStruct.PLL.PLLState = RCC_PLL_NONE;
         PeriphClkInitStruct.RTCClockSelection = RCC_RTCCLKSOURCE_LSI;
     } 
-    else if (strcmp(clock_str, "hse") == 0) 
+    else 
     {
         PeriphClkInitStruct.RTCClockSelection = RCC_RTCCLKSOURCE_HSE_DIV8;
     }
@@ -858,114 +1108,125 @@ static void init_rtc(Shell_Handle_t *handle, ShellArg_t *args, int arg_count)
     __HAL_RCC_RTC_ENABLE();
 
     // Initialize RTC
-    RTC_HandleTypeDef hrtc = {0};
-    hrtc.Instance = RTC;
-    hrtc.Init.HourFormat = (strcmp(format_str, "24") == 0) ? RTC_HOURFORMAT_24 : RTC_HOURFORMAT_12;
-    hrtc.Init.AsynchPrediv = atoi(asyncpre_str);
-    hrtc.Init.SynchPrediv = atoi(syncpre_str);
-    hrtc.Init.OutPut = RTC_OUTPUT_DISABLE;
-    hrtc.Init.OutPutPolarity = RTC_OUTPUT_POLARITY_HIGH;
-    hrtc.Init.OutPutType = RTC_OUTPUT_TYPE_OPENDRAIN;
-
-    if (HAL_OK != HAL_RTC_Init(&hrtc)) 
-    {
+    memset(&slot->handle, 0, sizeof(slot->handle));
+    slot->options = opt;
+    slot->handle.Instance = RTC;
+    slot->handle.Init.HourFormat = opt.hourFormat;
+    slot->handle.Init.AsynchPrediv = opt.asynchPrediv;
+    slot->handle.Init.SynchPrediv = opt.synchPrediv;
+    slot->handle.Init.OutPut = RTC_OUTPUT_DISABLE;
+    slot->handle.Init.OutPutPolarity = RTC_OUTPUT_POLARITY_HIGH;
+    slot->handle.Init.OutPutType = RTC_OUTPUT_TYPE_OPENDRAIN;
+
+    if (HAL_OK != HAL_RTC_Init(&slot->handle)) 
+    {
+        slot->state = SHELL_BUS_ERROR;
         sh_print(handle, "Failed to initialize RTC\r\n");
         return;
     }
 
-    sh_print(handle, "RTC initialized successfully\r\n");
+    slot->state = SHELL_BUS_READY;
+    init_report(handle, "rtc", "initialized", &rtcOptions, &slot->options);
 }
 
-/* Helper Functions */
-static GPIO_TypeDef* get_gpio_port(const char *port_str) 
-{
-    if (strcmp(port_str, "gpioa") == 0 || strcmp(port_str, "portA") == 0 || strcmp(port_str, "A") == 0 || strcmp(port_str, "a") == 0) return GPIOA;
-    if (strcmp(port_str, "gpiob") == 0 || strcmp(port_str, "portB") == 0 || strcmp(port_str, "B") == 0 || strcmp(port_str, "b") == 0) return GPIOB;
-    if (strcmp(port_str, "gpioc") == 0 || strcmp(port_str, "portC") == 0 || strcmp(port_str, "C") == 0 || strcmp(port_str, "c") == 0) return GPIOC;
-    if (strcmp(port_str, "gpiod") == 0 || strcmp(port_str, "portD") == 0 || strcmp(port_str, "D") == 0 || strcmp(port_str, "d") == 0) return GPIOD;
-    if (strcmp(port_str, "gpioe") == 0 || strcmp(port_str, "portE") == 0 || strcmp(port_str, "E") == 0 || strcmp(port_str, "e") == 0) return GPIOE;
-    return NULL;
-}
-
-static USART_TypeDef* get_usart_base(const char* uart_name) 
+/**
+  * @brief  print one registry slot with the options it runs with
+  * @param handle shell handle
+  * @param name instance name
+  * @param state what happened or the slot state
+  * @param schema options schema of the peripheral type, NULL to print no options
+  * @param options options struct of the slot
+  * @retval None
+  */
+static void init_report(Shell_Handle_t *handle, const char *name, const char *state, const ShellWords_t *schema, const void *options)
 {
-    if (0 == strcmp(uart_name, "USART1") || 0 == strcmp(uart_name, "UART1") || 0 == strcmp(uart_name, "usart1") || 0 == strcmp(uart_name, "uart1")) return USART1;
-    if (0 == strcmp(uart_name, "USART2") || 0 == strcmp(uart_name, "UART2") || 0 == strcmp(uart_name, "usart2") || 0 == strcmp(uart_name, "uart2")) return USART2;
-    if (0 == strcmp(uart_name, "USART3") || 0 == strcmp(uart_name, "UART3") || 0 == strcmp(uart_name, "usart3") || 0 == strcmp(uart_name, "uart3")) return USART3;
-    if (0 == strcmp(uart_name, "USART4") || 0 == strcmp(uart_name, "UART4") || 0 == strcmp(uart_name, "usart4") || 0 == strcmp(uart_name, "uart4")) return UART4;
-    if (0 == strcmp(uart_name, "USART5") || 0 == strcmp(uart_name, "UART5") || 0 == strcmp(uart_name, "usart5") || 0 == strcmp(uart_name, "uart5")) return UART5;
-    if (0 == strcmp(uart_name, "USART6") || 0 == strcmp(uart_name, "UART6") || 0 == strcmp(uart_name, "usart6") || 0 == strcmp(uart_name, "uart6")) return USART6;
-    return NULL;
+    sh_print(handle, name);
+    sh_print(handle, " ");
+    sh_print(handle, state);
+    if (NULL != schema)
+    {
+        sh_print(handle, ":");
+        Shell_PrintOptionValues(handle, schema, options);
+    }
+    sh_print(handle, "\r\n");
 }
 
-static I2C_TypeDef* get_i2c_base(const char* i2c_name) 
+/**
+  * @brief  list every peripheral the registry knows about
+  * @param handle shell handle
+  * @retval None
+  */
+static void init_list(Shell_Handle_t *handle)
 {
-    if (0 == strcmp(i2c_name, "i2c1") || 0 == strcmp(i2c_name, "I2C1")) return I2C1;
-    if (0 == strcmp(i2c_name, "i2c2") || 0 == strcmp(i2c_name, "I2C2")) return I2C2;
-    if (0 == strcmp(i2c_name, "i2c3") || 0 == strcmp(i2c_name, "I2C3")) return I2C3;
-    return NULL;
-}
+    const ShellPeriph_t *periph;
+    RTC_Config_t *rtc = Shell_BusRtc();
+    bool any = false;
 
-static SPI_TypeDef* get_spi_base(const char* spi_name) 
-{
-    if (0 == strcmp(spi_name, "spi1") || 0 == strcmp(spi_name, "SPI1")) return SPI1;
-    if (0 == strcmp(spi_name, "spi2") || 0 == strcmp(spi_name, "SPI2")) return SPI2;
-    if (0 == strcmp(spi_name, "spi3") || 0 == strcmp(spi_name, "SPI3")) return SPI3;
-    return NULL;
-}
+    for (size_t i = 0; NULL != (periph = Shell_PeriphAt(i)); i++)
+    {
+        const ShellWords_t *schema = NULL;
+        const void *options = NULL;
+        ShellBusState_t state = SHELL_BUS_FREE;
 
-static TIM_TypeDef* get_timer_base(const char* timer_name) 
-{
-    if (0 == strcmp(timer_name, "tim1") || 0 == strcmp(timer_name, "TIM1")) return TIM1;
-    if (0 == strcmp(timer_name, "tim2") || 0 == strcmp(timer_name, "TIM2")) return TIM2;
-    if (0 == strcmp(timer_name, "tim3") || 0 == strcmp(timer_name, "TIM3")) return TIM3;
-    if (0 == strcmp(timer_name, "tim4") || 0 == strcmp(timer_name, "TIM4")) return TIM4;
-    if (0 == strcmp(timer_name, "tim5") || 0 == strcmp(timer_name, "TIM5")) return TIM5;
-    if (0 == strcmp(timer_name, "tim6") || 0 == strcmp(timer_name, "TIM6")) return TIM6;
-    if (0 == strcmp(timer_name, "tim7") || 0 == strcmp(timer_name, "TIM7")) return TIM7;
-    if (0 == strcmp(timer_name, "tim8") || 0 == strcmp(timer_name, "TIM8")) return TIM8;
-    if (0 == strcmp(timer_name, "tim9") || 0 == strcmp(timer_name, "TIM9")) return TIM9;
-    if (0 == strcmp(timer_name, "tim10") || 0 == strcmp(timer_name, "TIM10")) return TIM10;
-    if (0 == strcmp(timer_name, "tim11") || 0 == strcmp(timer_name, "TIM11")) return TIM11;
-    if (0 == strcmp(timer_name, "tim12") || 0 == strcmp(timer_name, "TIM12")) return TIM12;
-    if (0 == strcmp(timer_name, "tim13") || 0 == strcmp(timer_name, "TIM13")) return TIM13;
-    if (0 == strcmp(timer_name, "tim14") || 0 == strcmp(timer_name, "TIM14")) return TIM14;
-    return NULL;
-}
+        if (SHELL_PERIPH_USART == periph->type) 
+        {
+            UART_Config_t *slot = Shell_BusUart(periph);
+            state = slot->state;
+            schema = &uartOptions;
+            options = &slot->options;
+        }
+        else if (SHELL_PERIPH_I2C == periph->type) 
+        {
+            I2C_Config_t *slot = Shell_BusI2c(periph);
+            state = slot->state;
+            schema = &i2cOptions;
+            options = &slot->options;
+        }
+        else if (SHELL_PERIPH_SPI == periph->type) 
+        {
+            SPI_Config_t *slot = Shell_BusSpi(periph);
+            state = slot->state;
+            schema = &spiOptions;
+            options = &slot->options;
+        }
+        else if (SHELL_PERIPH_TIM == periph->type) 
+        {
+            TIM_Config_t *slot = Shell_BusTim(periph);
+            state = slot->state;
+            schema = &timOptions;
+            options = &slot->options;
+        }
 
-static int parse_args(int argc, char *argv[], int start_index, ShellArg_t *args, int max_args) 
-{
-    int arg_count = 0;
-    
-    for (int i = start_index; i < argc && arg_count < max_args; i++) 
-    {
-        if ('-' == argv[i][0]) 
+        if (SHELL_BUS_FREE == state) 
         {
-            args[arg_count].flag = argv[i] + 1; 
-            if (i + 1 < argc && argv[i + 1][0] != '-') 
-            {
-                args[arg_count].value = argv[i + 1];
-                i++;  
-            } 
-            else 
-            {
-                // no value
-                args[arg_count].value = NULL;
-            }
-            arg_count++;
+            continue;
         }
+
+        // options are only meaningful once init got as far as storing them
+        init_report(handle, periph->name, Shell_BusStateName(state),
+                    (SHELL_BUS_RESERVED == state) ? NULL : schema, options);
+        any = true;
     }
-    return arg_count;
-}
 
-static const char* get_arg_value(ShellArg_t *args, int arg_count, const char *flag, const char *default_value) 
-{
-    for (int i = 0; i < arg_count; i++) 
+    if (SHELL_BUS_FREE != rtc->state) 
     {
-        if (0 == strcmp(args[i].flag, flag)) 
-        {
-            return args[i].value ? args[i].value : default_value;
-        }
+        init_report(handle, "rtc", Shell_BusStateName(rtc->state), &rtcOptions, &rtc->options);
+        any = true;
     }
-    return default_value;
+
+    if (!any) 
+    {
+        sh_print(handle, "No peripherals initialized\r\n");
+    }
+}
+
+/* Helper Functions */
+static GPIO_TypeDef* get_gpio_port(const char *port_str) 
+{
+    if (strcmp(port_str, "gpioa") == 0 || strcmp(port_str, "portA") == 0 || strcmp(port_str, "A") == 0 || strcmp(port_str, "a") == 0) return GPIOA;
+    if (strcmp(port_str, "gpiob") == 0 || strcmp(port_str, "portB") == 0 || strcmp(port_str, "B") == 0 || strcmp(port_str, "b") == 0) return GPIOB;
+    if (strcmp(port_str, "gpioc") == 0 || strcmp(port_str, "portC") == 0 || strcmp(port_str, "C") == 0 || strcmp(port_str, "c") == 0) return GPIOC;
+    if (strcmp(port_str, "gpiod") == 0 || strcmp(port_str, "portD") == 0 || strcmp(port_str, "D") == 0 || strcmp(port_str, "d") == 0) return GPIOD;
+    if (strcmp(port_str, "gpioe") == 0 || strcmp(port_str, "portE") == 0 || strcmp(port_str, "E") == 0 || strcmp(port_str, "e") == 0) return GPIOE;
+    return NULL;
 }
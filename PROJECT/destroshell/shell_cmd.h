@@ -7,47 +7,13 @@ extern "C"
 #endif
 
 #include <destroshell.h>
+#include <shell_opt.h>
+#include <shell_bus.h>
+#include <shell_baud.h>
+#include <shell_heap.h>
+#include <shell_rpc.h>
 #include <timers.h>
 
-/* External variables */
-extern uint8_t commandCount;
-extern ShellCommand_t shellCommands[];
-
-/* Shell arguments */
-typedef struct {
-    const char* flag;
-    const char* value;
-} ShellArg_t;
-
-typedef struct {
-    UART_HandleTypeDef handle;
-    USART_TypeDef* instance;
-    bool initialized;
-} UART_Config_t;
-
-typedef struct {
-    I2C_HandleTypeDef handle;
-    I2C_TypeDef* instance;
-    bool initialized;
-} I2C_Config_t;
-
-typedef struct {
-    SPI_HandleTypeDef handle;
-    SPI_TypeDef* instance;
-    bool initialized;
-} SPI_Config_t;
-
-typedef struct {
-    TIM_HandleTypeDef handle;
-    TIM_TypeDef* instance;
-    bool initialized;
-} TIM_Config_t;
-
-typedef struct {
-    RTC_HandleTypeDef handle;
-    bool initialized;
-} RTC_Config_t;
-
 /* API prototypes */
 void shell_cmd_clear(Shell_Handle_t *handle, int argc, char *argv[]);
 void shell_cmd_help(Shell_Handle_t *handle, int argc, char *argv[]);
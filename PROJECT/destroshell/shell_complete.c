@@ -0,0 +1,430 @@
+#include <shell_complete.h>
+#include <shell_opt.h>
+
+/* Private defines -----------------------------------------------------------*/
+#define SHELL_WORDS_MAX_DEPTH 8         /* Nesting limit for Shell_WordsCheck */
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    const ShellWords_t *level;          /* Level the next word is matched against, NULL for free text */
+    const ShellWords_t *options;        /* Options level to return to once a value is consumed */
+    bool value;                         /* Next word is the value of an option */
+} ShellWalk_t;
+
+/* Exported variables --------------------------------------------------------*/
+const ShellWords_t shellCommandWords = { NULL, NULL, 0, SHELL_WORDS_COMMANDS };
+
+/**
+  * @brief  number of words on a level
+  * @param level trie level
+  * @retval word count
+  */
+static size_t Shell_WordsCount(const ShellWords_t *level)
+{
+    if (0 != (SHELL_WORDS_COMMANDS & level->flags))
+    {
+        return (size_t)(SHELL_COMMANDS_END - SHELL_COMMANDS_BEGIN);
+    }
+    return level->count;
+}
+
+/**
+  * @brief  word i of a level
+  * @param level trie level
+  * @param i word index
+  * @retval word
+  */
+static const char *Shell_WordsName(const ShellWords_t *level, size_t i)
+{
+    if (0 != (SHELL_WORDS_COMMANDS & level->flags))
+    {
+        return SHELL_COMMANDS_BEGIN[i].commandName;
+    }
+    if (0 != (SHELL_WORDS_OPTIONS & level->flags))
+    {
+        return level->opts[i].flag;
+    }
+    return level->words[i].word;
+}
+
+/**
+  * @brief  level following word i of a level
+  * @param level trie level
+  * @param i word index
+  * @retval next level, NULL for free text
+  */
+static const ShellWords_t *Shell_WordsNext(const ShellWords_t *level, size_t i)
+{
+    if (0 != (SHELL_WORDS_COMMANDS & level->flags))
+    {
+        return SHELL_COMMANDS_BEGIN[i].args;
+    }
+    if (0 != (SHELL_WORDS_OPTIONS & level->flags))
+    {
+        return level->opts[i].values;
+    }
+    return level->words[i].next;
+}
+
+/**
+  * @brief  find the range of words starting with a prefix
+  * @param level trie level
+  * @param prefix prefix, need not be terminated
+  * @param len prefix length
+  * @param first receives the index of the first matching word
+  * @retval number of matching words
+  */
+static size_t Shell_WordsRange(const ShellWords_t *level, const char *prefix, size_t len, size_t *first)
+{
+    size_t low = 0;
+    size_t high = Shell_WordsCount(level);
+    size_t end;
+
+    // lower bound: first word not below the prefix
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+
+        if (strncmp(Shell_WordsName(level, mid), prefix, len) < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    *first = low;
+
+    // upper bound: first word past the prefix
+    high = Shell_WordsCount(level);
+    end = low;
+    while (end < high)
+    {
+        size_t mid = end + (high - end) / 2;
+
+        if (0 == strncmp(Shell_WordsName(level, mid), prefix, len))
+        {
+            end = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return end - low;
+}
+
+/**
+  * @brief  find a word on a level
+  * @param level trie level
+  * @param word word to look for, must match exactly
+  * @retval word index or -1 if not found
+  */
+int Shell_WordsFind(const ShellWords_t *level, const char *word)
+{
+    size_t len = strlen(word);
+    size_t first;
+
+    if ((NULL == level) || (0 == Shell_WordsRange(level, word, len, &first)))
+    {
+        return -1;
+    }
+    // the shortest word of the range sorts first
+    return ('\0' == Shell_WordsName(level, first)[len]) ? (int)first : -1;
+}
+
+/**
+  * @brief  match one complete word and advance the walk
+  * @note   a unique prefix is replaced by the full word. Option values are taken
+  *         verbatim since a number may well be a prefix of another valid number.
+  * @param walk walk state
+  * @param word word to match, may be replaced by a pointer to the full word
+  * @retval number of candidates; above 1 the word is ambiguous and the walk did not advance
+  */
+static size_t Shell_WalkStep(ShellWalk_t *walk, char **word)
+{
+    const ShellWords_t *level;
+    size_t len = strlen(*word);
+    size_t first;
+    size_t n;
+
+    if (walk->value)
+    {
+        walk->level = walk->options;
+        walk->value = false;
+
+        // a bare boolean flag is followed straight by the next flag
+        if ('-' != (*word)[0])
+        {
+            return 0;
+        }
+    }
+
+    level = walk->level;
+    if (NULL == level)
+    {
+        return 0;
+    }
+
+    n = Shell_WordsRange(level, *word, len, &first);
+
+    // an exact match beats longer words it is a prefix of, it always sorts first
+    if ((n > 1) && ('\0' == Shell_WordsName(level, first)[len]))
+    {
+        n = 1;
+    }
+
+    if (n > 1)
+    {
+        return n;
+    }
+
+    if (1 == n)
+    {
+        // trie words live in flash, handlers only ever read argv
+        *word = (char *)Shell_WordsName(level, first);
+    }
+
+    if (0 != (SHELL_WORDS_OPTIONS & level->flags))
+    {
+        // unknown flags are left to the command, completion stays on the options
+        if (1 == n)
+        {
+            walk->options = level;
+            walk->level = Shell_WordsNext(level, first);
+            walk->value = true;
+        }
+        return n;
+    }
+
+    walk->level = (1 == n) ? Shell_WordsNext(level, first) : NULL;
+    return n;
+}
+
+/**
+  * @brief  print the words of a level that start with a prefix
+  * @param handle shell handle
+  * @param level trie level
+  * @param prefix prefix, need not be terminated
+  * @param len prefix length
+  * @retval None
+  */
+static void Shell_PrintCandidates(Shell_Handle_t *handle, const ShellWords_t *level, const char *prefix, size_t len)
+{
+    size_t first;
+    size_t n = Shell_WordsRange(level, prefix, len, &first);
+
+    sh_print(handle, "\r\n");
+    for (size_t i = first; i < first + n; i++)
+    {
+        sh_print(handle, Shell_WordsName(level, i));
+        sh_print(handle, "  ");
+    }
+    sh_print(handle, "\r\n");
+}
+
+/**
+  * @brief  append text to the line being edited and echo it
+  * @param handle shell handle
+  * @param text text to append
+  * @param len text length
+  * @retval true if it fit
+  */
+static bool Shell_LineAppend(Shell_Handle_t *handle, const char *text, size_t len)
+{
+    if (handle->bufferIndex + len > SHELL_MAX_LINE_LEN - 1)
+    {
+        return false;
+    }
+
+    memcpy(&handle->cmdBuffer[handle->bufferIndex], text, len);
+    handle->bufferIndex += len;
+    sh_write(handle, (const uint8_t *)text, len);
+    return true;
+}
+
+/**
+  * @brief  complete the word under the cursor (TAB)
+  * @note   a single candidate is completed with a trailing blank, several are
+  *         completed up to their common prefix and listed when that adds nothing
+  * @param handle shell handle
+  * @retval None
+  */
+void Shell_CompleteLine(Shell_Handle_t *handle)
+{
+    char line[SHELL_MAX_LINE_LEN];
+    char *words[SHELL_MAX_ARGS];
+    int count = 0;
+    size_t start = handle->bufferIndex;
+    ShellWalk_t walk = { &shellCommandWords, NULL, false };
+    const char *partial;
+    size_t len;
+    size_t first;
+    size_t n;
+
+    // the partial word runs from the last blank up to the cursor
+    while ((start > 0) && (' ' != handle->cmdBuffer[start - 1]))
+    {
+        start--;
+    }
+    partial = &handle->cmdBuffer[start];
+    len = handle->bufferIndex - start;
+
+    memcpy(line, handle->cmdBuffer, handle->bufferIndex);
+    line[handle->bufferIndex] = '\0';
+    if (NULL != strpbrk(line, "\"'\\"))
+    {
+        // quoted words are not completed
+        sh_print(handle, "\a");
+        return;
+    }
+
+    line[start] = '\0';
+    for (char *p = line; '\0' != *p; )
+    {
+        while (' ' == *p)
+        {
+            *p++ = '\0';
+        }
+        if ('\0' == *p)
+        {
+            break;
+        }
+        if (count == SHELL_MAX_ARGS - 1)
+        {
+            sh_print(handle, "\a");
+            return;
+        }
+        words[count++] = p;
+        while (('\0' != *p) && (' ' != *p))
+        {
+            p++;
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (Shell_WalkStep(&walk, &words[i]) > 1)
+        {
+            sh_print(handle, "\a");
+            return;
+        }
+    }
+
+    // a bare boolean flag can be followed straight by the next flag
+    if (walk.value && (len > 0) && ('-' == partial[0]))
+    {
+        walk.level = walk.options;
+    }
+
+    n = (NULL != walk.level) ? Shell_WordsRange(walk.level, partial, len, &first) : 0;
+    if (0 == n)
+    {
+        sh_print(handle, "\a");
+        return;
+    }
+
+    // the range is sorted, so its first and last word bound the common prefix
+    const char *low = Shell_WordsName(walk.level, first);
+    const char *high = Shell_WordsName(walk.level, first + n - 1);
+    size_t common = len;
+
+    while (('\0' != low[common]) && (low[common] == high[common]))
+    {
+        common++;
+    }
+
+    if (common > len)
+    {
+        if (!Shell_LineAppend(handle, &low[len], common - len))
+        {
+            sh_print(handle, "\a");
+            return;
+        }
+    }
+    else if (n > 1)
+    {
+        Shell_PrintCandidates(handle, walk.level, partial, len);
+        sh_print(handle, SHELL_PROMPT);
+        sh_write(handle, (const uint8_t *)handle->cmdBuffer, handle->bufferIndex);
+        return;
+    }
+
+    if (1 == n)
+    {
+        Shell_LineAppend(handle, " ", 1);
+    }
+}
+
+/**
+  * @brief  replace unique prefixes of the command name and its words by the full words
+  * @param handle shell handle, ambiguous words are reported on it
+  * @param argc argument count
+  * @param argv argument vector, entries may be redirected to constant strings
+  * @retval false if a word is ambiguous
+  */
+bool Shell_ExpandArgs(Shell_Handle_t *handle, int argc, char *argv[])
+{
+    ShellWalk_t walk = { &shellCommandWords, NULL, false };
+
+    for (int i = 0; i < argc; i++)
+    {
+        const ShellWords_t *level = walk.level;
+
+        if (Shell_WalkStep(&walk, &argv[i]) > 1)
+        {
+            sh_print(handle, "➩ Ambiguous: ");
+            sh_print(handle, argv[i]);
+            Shell_PrintCandidates(handle, level, argv[i], strlen(argv[i]));
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+  * @brief  verify a level and everything below it is sorted without duplicates
+  * @param level trie level
+  * @param depth nesting depth of level, guards against cycles
+  * @retval first word out of order, NULL if the level is fine
+  */
+static const char *Shell_WordsCheckDepth(const ShellWords_t *level, int depth)
+{
+    const char *bad;
+
+    if ((NULL == level) || (0 != (SHELL_WORDS_COMMANDS & level->flags)))
+    {
+        return NULL;
+    }
+
+    if ((depth > SHELL_WORDS_MAX_DEPTH) && (level->count > 0))
+    {
+        return Shell_WordsName(level, 0);
+    }
+
+    for (size_t i = 0; i < level->count; i++)
+    {
+        if ((i > 0) && (strcmp(Shell_WordsName(level, i - 1), Shell_WordsName(level, i)) >= 0))
+        {
+            return Shell_WordsName(level, i);
+        }
+
+        bad = Shell_WordsCheckDepth(Shell_WordsNext(level, i), depth + 1);
+        if (NULL != bad)
+        {
+            return bad;
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @brief  verify a word trie is sorted, binary search depends on it
+  * @param level top level of the trie
+  * @retval first word out of order, NULL if the trie is fine
+  */
+const char *Shell_WordsCheck(const ShellWords_t *level)
+{
+    return Shell_WordsCheckDepth(level, 0);
+}
@@ -0,0 +1,20 @@
+#ifndef __SHELL_COMPLETE_H__
+#define __SHELL_COMPLETE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <destroshell.h>
+
+/* API prototypes */
+void Shell_CompleteLine(Shell_Handle_t *handle);
+bool Shell_ExpandArgs(Shell_Handle_t *handle, int argc, char *argv[]);
+const char *Shell_WordsCheck(const ShellWords_t *level);
+int Shell_WordsFind(const ShellWords_t *level, const char *word);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_COMPLETE_H__ */
@@ -0,0 +1,210 @@
+#include <destroshell.h>
+#include <shell_opt.h>
+#include <shell_periph.h>
+
+/*
+ * Output backpressure of a session. -fc switches RTS/CTS on the shell UART
+ * (pins from shell_periph.cpp), -policy and -timeout set what a write does
+ * when the output is full (ShellTxPolicy_t). Options left out keep their
+ * setting; without any, the settings and TX counters are shown.
+ */
+
+/* Configuration constants */
+#define SHELL_FLOW_KEEP 0xFFFFFFFFu     /* Option not given, setting unchanged */
+
+typedef struct {
+    uint32_t flowControl;
+    uint32_t policy;
+    uint32_t timeout;
+} FlowOptions_t;
+
+/* Private variables ----------------------------------------------------------*/
+static const ShellWord_t flowControlWords[] = {
+    { "cts",    NULL, UART_HWCONTROL_CTS },
+    { "none",   NULL, UART_HWCONTROL_NONE },
+    { "rts",    NULL, UART_HWCONTROL_RTS },
+    { "rtscts", NULL, UART_HWCONTROL_RTS_CTS },
+};
+static const ShellWord_t flowPolicyWords[] = {
+    { "block",  NULL, SHELL_TX_BLOCK },
+    { "newest", NULL, SHELL_TX_DROP_NEWEST },
+    { "oldest", NULL, SHELL_TX_DROP_OLDEST },
+};
+static const ShellWords_t flowControlValues = SHELL_WORDS(flowControlWords, 0);
+static const ShellWords_t flowPolicyValues = SHELL_WORDS(flowPolicyWords, 0);
+
+static const ShellOpt_t flowOptionTable[] = {
+    SHELL_OPTION_ENUM("-fc", FlowOptions_t, flowControl, flowControlValues, SHELL_FLOW_KEEP),
+    SHELL_OPTION_ENUM("-policy", FlowOptions_t, policy, flowPolicyValues, SHELL_FLOW_KEEP),
+    SHELL_OPTION_INT("-timeout", FlowOptions_t, timeout, 0, 60000, SHELL_FLOW_KEEP),
+};
+static const ShellWords_t flowOptions = SHELL_OPTIONS(flowOptionTable);
+
+/**
+  * @brief  word of an option value
+  * @param values value list
+  * @param value value to name
+  * @retval word, "?" if the list has none for it
+  */
+static const char *Shell_FlowWord(const ShellWords_t *values, uint32_t value)
+{
+    for (uint16_t i = 0; i < values->count; i++)
+    {
+        if (value == values->words[i].value)
+        {
+            return values->words[i].word;
+        }
+    }
+    return "?";
+}
+
+/**
+  * @brief  format a flow control pin as " CTS PD3"
+  * @param buf destination
+  * @param size destination size
+  * @param signal signal name
+  * @param pins pin group, nothing is written for an unused one
+  * @retval None
+  */
+static void Shell_FlowPin(char *buf, size_t size, const char *signal, const ShellPeriphPins_t *pins)
+{
+    buf[0] = '\0';
+    if (0 != pins->port)
+    {
+        snprintf(buf, size, " %s P%c%u", signal, (char)('A' + (pins->port - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE)),
+                 (unsigned)__builtin_ctz(pins->pins));
+    }
+}
+
+/**
+  * @brief  print flow control, output policy and TX counters of the session
+  * @param handle shell handle
+  * @param huart UART of the session, NULL for none
+  * @retval None
+  */
+static void Shell_FlowShow(Shell_Handle_t *handle, UART_HandleTypeDef *huart)
+{
+    ShellTransportStats_t stats;
+    char cts[16];
+    char rts[16];
+    char buf[160];
+
+    if (NULL != huart)
+    {
+        const ShellPeriph_t *periph = Shell_PeriphFromBase((uintptr_t)huart->Instance);
+
+        cts[0] = '\0';
+        rts[0] = '\0';
+        if (NULL != periph)
+        {
+            Shell_FlowPin(cts, sizeof(cts), "CTS", &periph->cts);
+            Shell_FlowPin(rts, sizeof(rts), "RTS", &periph->rts);
+        }
+        snprintf(buf, sizeof(buf), "%s: flow control %s, pins%s%s\r\n",
+                 (NULL != periph) ? periph->name : "uart",
+                 Shell_FlowWord(&flowControlValues, huart->Init.HwFlowCtl),
+                 (('\0' == cts[0]) && ('\0' == rts[0])) ? " none" : cts, rts);
+        sh_print(handle, buf);
+    }
+
+    handle->transport->stats(handle, &stats);
+    snprintf(buf, sizeof(buf), "Output policy %s, timeout %lu ms\r\n"
+             "TX %lu bytes, dropped %lu, stalls %lu\r\n",
+             Shell_FlowWord(&flowPolicyValues, handle->txPolicy), (unsigned long)handle->txTimeout,
+             (unsigned long)stats.txBytes, (unsigned long)stats.txDropped, (unsigned long)stats.txStalls);
+    sh_print(handle, buf);
+}
+
+/**
+  * @brief  switch RTS/CTS on the UART of the session
+  * @param handle shell handle
+  * @param huart UART of the session
+  * @param hwFlowCtl UART_HWCONTROL_NONE, _RTS, _CTS or _RTS_CTS
+  * @retval true if the UART runs with it
+  */
+static bool Shell_FlowControl(Shell_Handle_t *handle, UART_HandleTypeDef *huart, uint32_t hwFlowCtl)
+{
+    const ShellPeriph_t *periph = Shell_PeriphFromBase((uintptr_t)huart->Instance);
+    UART_InitTypeDef init = huart->Init;
+    bool routed;
+    bool held;
+    char buf[96];
+
+    // the GPIO ports are shared with init on the other sessions
+    Shell_Lock(SHELL_LOCK_BUS);
+    routed = (NULL != periph) && Shell_PeriphEnableFlow(periph, hwFlowCtl);
+    held = routed && (0u != (hwFlowCtl & UART_HWCONTROL_CTS)) &&
+           (GPIO_PIN_SET == HAL_GPIO_ReadPin((GPIO_TypeDef *)periph->cts.port, periph->cts.pins));
+    Shell_Unlock(SHELL_LOCK_BUS);
+
+    if (!routed)
+    {
+        snprintf(buf, sizeof(buf), "%s has no RTS/CTS pins\r\n", (NULL != periph) ? periph->name : "This UART");
+        sh_print(handle, buf);
+        return false;
+    }
+
+    // an undriven CTS is pulled up and would hold the shell's output off for good
+    if (held)
+    {
+        sh_print(handle, "CTS is not asserted, is the RTS of the host wired up?\r\n");
+        return false;
+    }
+
+    init.HwFlowCtl = hwFlowCtl;
+    if (!sh_configure(handle, &init))
+    {
+        sh_print(handle, "Could not reprogram the UART, flow control unchanged\r\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+  * @brief  show or set flow control and the output policy of the session
+  * @param handle shell handle
+  * @param argc argument count
+  * @param argv argument vector
+  * @retval None
+  */
+void shell_cmd_flow(Shell_Handle_t *handle, int argc, char *argv[])
+{
+    UART_HandleTypeDef *huart = (NULL != handle->transport->uart) ? handle->transport->uart(handle) : NULL;
+    FlowOptions_t opt;
+
+    if (!Shell_ParseOptions(handle, &flowOptions, argc - 1, &argv[1], &opt))
+    {
+        return;
+    }
+
+    if (SHELL_FLOW_KEEP != opt.flowControl)
+    {
+        if (NULL == huart)
+        {
+            sh_print(handle, "This shell does not run on a UART\r\n");
+            return;
+        }
+        if (!Shell_FlowControl(handle, huart, opt.flowControl))
+        {
+            return;
+        }
+    }
+
+    // read by the transport write under the TX lock
+    if ((SHELL_FLOW_KEEP != opt.policy) || (SHELL_FLOW_KEEP != opt.timeout))
+    {
+        xSemaphoreTake(handle->txLock, portMAX_DELAY);
+        if (SHELL_FLOW_KEEP != opt.policy)
+        {
+            handle->txPolicy = (ShellTxPolicy_t)opt.policy;
+        }
+        if (SHELL_FLOW_KEEP != opt.timeout)
+        {
+            handle->txTimeout = opt.timeout;
+        }
+        xSemaphoreGive(handle->txLock);
+    }
+
+    Shell_FlowShow(handle, huart);
+}
+SHELL_COMMAND_ARGS(flow, "Show or set flow control and the output overflow policy", "flow [-fc none|rts|cts|rtscts] [-policy block|newest|oldest] [-timeout <ms>]", shell_cmd_flow, &flowOptions);
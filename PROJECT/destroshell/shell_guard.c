@@ -0,0 +1,108 @@
+#include <destroshell.h>
+#include <shell_guard.h>
+
+#if ( configUSE_SHELL_STACK_GUARD == 1 )
+
+/**
+  * @brief  send a string through the transport's polled path, no RTOS calls
+  * @param handle shell handle
+  * @param str string to send
+  * @retval None
+  */
+static void Shell_GuardPuts(Shell_Handle_t *handle, const char *str)
+{
+    handle->transport->drain(handle, (const uint8_t *)str, strlen(str));
+}
+
+/**
+  * @brief  set up the guard region and enable the MPU
+  * @note   call before the scheduler starts; the region is moved onto the
+  *         incoming task's stack from the first context switch on
+  * @retval None
+  */
+void Shell_StackGuardInit(void)
+{
+    MPU_Region_InitTypeDef region = { 0 };
+
+    HAL_MPU_Disable();
+
+    region.Enable = MPU_REGION_ENABLE;
+    region.Number = configSHELL_STACK_GUARD_REGION;
+    region.BaseAddress = 0;             // parked on the vector table until the first switch
+    region.Size = MPU_REGION_SIZE_32B;
+    region.SubRegionDisable = 0x00;
+    region.TypeExtField = MPU_TEX_LEVEL0;
+    region.AccessPermission = MPU_REGION_PRIV_RO_URO;
+    region.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+    region.IsShareable = MPU_ACCESS_SHAREABLE;
+    region.IsCacheable = MPU_ACCESS_CACHEABLE;
+    region.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+    HAL_MPU_ConfigRegion(&region);
+
+    // everything outside the guard keeps the default memory map, MemManage is enabled too
+    HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+}
+
+/**
+  * @brief  report a MemManage fault on the shell port
+  * @note   runs from MemManage_Handler: pending output is drained and the
+  *         report polled out, nothing here takes a lock or blocks
+  * @param handle shell handle
+  * @retval None
+  */
+void Shell_StackGuardFault(Shell_Handle_t *handle)
+{
+    uint32_t cfsr = SCB->CFSR;
+    uint32_t guard;
+    uint32_t address = SCB->MMFAR;
+    uint32_t psp = __get_PSP();
+    const char *task = (taskSCHEDULER_NOT_STARTED != xTaskGetSchedulerState()) ? pcTaskGetName(NULL) : "(none)";
+    const char *cause;
+    char buf[128];
+
+    if ((NULL == handle) || (NULL == handle->transport))
+    {
+        return;
+    }
+
+    MPU->RNR = configSHELL_STACK_GUARD_REGION;
+    guard = MPU->RBAR & MPU_RBAR_ADDR_Msk;
+
+    // a stacking fault has no address, the process stack pointer tells where it went
+    if (0 != (cfsr & SCB_CFSR_MMARVALID_Msk))
+    {
+        cause = ((address >= guard) && (address < guard + configSHELL_STACK_GUARD_SIZE)) ? "stack overflow" : "access violation";
+    }
+    else if (0 != (cfsr & (SCB_CFSR_MSTKERR_Msk | SCB_CFSR_MLSPERR_Msk)))
+    {
+        address = psp;
+        cause = (psp < guard + configSHELL_STACK_GUARD_SIZE) ? "stack overflow" : "exception stacking";
+    }
+    else
+    {
+        address = 0;
+        cause = (0 != (cfsr & SCB_CFSR_IACCVIOL_Msk)) ? "instruction access" : "memory management";
+    }
+
+    sh_drain(handle);
+
+    snprintf(buf, sizeof(buf), "\r\n*** MemManage: %s in task '%s'\r\n", cause, task);
+    Shell_GuardPuts(handle, buf);
+    snprintf(buf, sizeof(buf), "*** address 0x%08lx, guard 0x%08lx..0x%08lx, PSP 0x%08lx, CFSR 0x%08lx\r\n",
+             (unsigned long)address, (unsigned long)guard, (unsigned long)(guard + configSHELL_STACK_GUARD_SIZE - 1u),
+             (unsigned long)psp, (unsigned long)cfsr);
+    Shell_GuardPuts(handle, buf);
+}
+
+#else
+
+void Shell_StackGuardInit(void)
+{
+}
+
+void Shell_StackGuardFault(Shell_Handle_t *handle)
+{
+    (void)handle;
+}
+
+#endif /* configUSE_SHELL_STACK_GUARD */
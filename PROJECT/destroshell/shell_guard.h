@@ -0,0 +1,27 @@
+#ifndef __SHELL_GUARD_H__
+#define __SHELL_GUARD_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <destroshell.h>
+
+/*
+ * MPU stack guard. One MPU region covers the lowest 32-byte aligned block of
+ * the running task's stack; traceTASK_SWITCHED_IN (see FreeRTOSConfig.h)
+ * moves it on every context switch. The region is read-only rather than
+ * no-access so stack high water marks can still be read, while the first
+ * push past the end of the stack raises MemManage, whose handler names the
+ * task instead of letting it run over the next heap block.
+ */
+
+/* API prototypes */
+void Shell_StackGuardInit(void);
+void Shell_StackGuardFault(Shell_Handle_t *handle);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_GUARD_H__ */
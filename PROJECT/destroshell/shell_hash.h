@@ -0,0 +1,174 @@
+#ifndef __SHELL_HASH_H__
+#define __SHELL_HASH_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * Command name hashing. Kept free of FreeRTOS and HAL so the host
+ * benchmark in tools/ runs the exact same code as the target.
+ *
+ * The hash is a weighted sum h = c0*K^1 + c1*K^2 + ... (mod 2^32). Unlike
+ * FNV it has no data dependency between characters, so SHELL_NAME_HASH()
+ * folds to a constant in a static initializer and names are hashed at
+ * build time. Shell_NameHash() computes the same value at run time.
+ */
+#define SHELL_CMD_NAME_MAX 16           /* Longest command name the hash covers */
+
+#define SHELL_HASH_W0   0x01000193u
+#define SHELL_HASH_W1   0x26027A69u
+#define SHELL_HASH_W2   0x3EE6B34Bu
+#define SHELL_HASH_W3   0x502C3F11u
+#define SHELL_HASH_W4   0x46A747C3u
+#define SHELL_HASH_W5   0xFC55F7F9u
+#define SHELL_HASH_W6   0x34555CFBu
+#define SHELL_HASH_W7   0x5D615F21u
+#define SHELL_HASH_W8   0x2148C0F3u
+#define SHELL_HASH_W9   0x5887BE89u
+#define SHELL_HASH_W10  0xE6B0F1ABu
+#define SHELL_HASH_W11  0xD38C7031u
+#define SHELL_HASH_W12  0x37149D23u
+#define SHELL_HASH_W13  0xD8735E19u
+#define SHELL_HASH_W14  0xD69D215Bu
+#define SHELL_HASH_W15  0x345B8241u
+
+/* character i of a string literal, 0 past its end */
+#define SHELL_HASH_C(s, i)  ((i) < sizeof(s) - 1 ? (uint32_t)(uint8_t)(s)[(i) < sizeof(s) - 1 ? (i) : 0] : 0u)
+
+#define SHELL_NAME_HASH(s)                                                              \
+    ((uint32_t)(SHELL_HASH_C(s, 0)  * SHELL_HASH_W0  + SHELL_HASH_C(s, 1)  * SHELL_HASH_W1  + \
+                SHELL_HASH_C(s, 2)  * SHELL_HASH_W2  + SHELL_HASH_C(s, 3)  * SHELL_HASH_W3  + \
+                SHELL_HASH_C(s, 4)  * SHELL_HASH_W4  + SHELL_HASH_C(s, 5)  * SHELL_HASH_W5  + \
+                SHELL_HASH_C(s, 6)  * SHELL_HASH_W6  + SHELL_HASH_C(s, 7)  * SHELL_HASH_W7  + \
+                SHELL_HASH_C(s, 8)  * SHELL_HASH_W8  + SHELL_HASH_C(s, 9)  * SHELL_HASH_W9  + \
+                SHELL_HASH_C(s, 10) * SHELL_HASH_W10 + SHELL_HASH_C(s, 11) * SHELL_HASH_W11 + \
+                SHELL_HASH_C(s, 12) * SHELL_HASH_W12 + SHELL_HASH_C(s, 13) * SHELL_HASH_W13 + \
+                SHELL_HASH_C(s, 14) * SHELL_HASH_W14 + SHELL_HASH_C(s, 15) * SHELL_HASH_W15))
+
+/* Index slot value meaning "empty", entries are stored as table index + 1 */
+#define SHELL_HASH_EMPTY 0u
+
+/**
+  * @brief  hash a command name at run time, same value as SHELL_NAME_HASH()
+  * @param name NUL terminated name
+  * @param hash receives the hash
+  * @retval 0 on success, -1 if the name is longer than SHELL_CMD_NAME_MAX
+  */
+static inline int Shell_NameHash(const char *name, uint32_t *hash)
+{
+    static const uint32_t weights[SHELL_CMD_NAME_MAX] = {
+        SHELL_HASH_W0,  SHELL_HASH_W1,  SHELL_HASH_W2,  SHELL_HASH_W3,
+        SHELL_HASH_W4,  SHELL_HASH_W5,  SHELL_HASH_W6,  SHELL_HASH_W7,
+        SHELL_HASH_W8,  SHELL_HASH_W9,  SHELL_HASH_W10, SHELL_HASH_W11,
+        SHELL_HASH_W12, SHELL_HASH_W13, SHELL_HASH_W14, SHELL_HASH_W15
+    };
+    uint32_t h = 0;
+    size_t i;
+
+    for (i = 0; '\0' != name[i]; i++)
+    {
+        if (i >= SHELL_CMD_NAME_MAX)
+        {
+            return -1;
+        }
+        h += (uint32_t)(uint8_t)name[i] * weights[i];
+    }
+
+    *hash = h;
+    return 0;
+}
+
+/**
+  * @brief  map a hash onto an index of 2^bits slots (Fibonacci hashing)
+  * @param hash name hash
+  * @param bits log2 of the slot count
+  * @retval slot number
+  */
+static inline uint32_t Shell_HashSlot(uint32_t hash, unsigned bits)
+{
+    return (hash * 0x9E3779B1u) >> (32u - bits);
+}
+
+/**
+  * @brief  build an open addressing index over a table of descriptors
+  * @note   hash points at the hash field of the first entry, consecutive entries
+  *         are stride bytes apart. Keep count below half the slot count.
+  * @param slots index storage, 2^bits entries
+  * @param bits log2 of the slot count
+  * @param hash hash field of entry 0
+  * @param stride entry size in bytes
+  * @param count number of entries
+  * @retval 0 on success, -1 if the index is too small
+  */
+static inline int Shell_HashIndexBuild(uint16_t *slots, unsigned bits, const uint32_t *hash,
+                                       size_t stride, size_t count)
+{
+    const uint32_t mask = (1u << bits) - 1u;
+    size_t i;
+
+    memset(slots, 0, sizeof(slots[0]) << bits);
+    if ((count >= mask) || (count >= UINT16_MAX))
+    {
+        return -1;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        uint32_t h = *(const uint32_t *)((const uint8_t *)hash + i * stride);
+        uint32_t slot = Shell_HashSlot(h, bits);
+
+        while (SHELL_HASH_EMPTY != slots[slot])
+        {
+            slot = (slot + 1u) & mask;
+        }
+        slots[slot] = (uint16_t)(i + 1u);
+    }
+    return 0;
+}
+
+/**
+  * @brief  look a name up in an index built by Shell_HashIndexBuild
+  * @param slots index storage, 2^bits entries
+  * @param bits log2 of the slot count
+  * @param hash hash field of entry 0
+  * @param name name field of entry 0
+  * @param stride entry size in bytes
+  * @param key name to look for
+  * @retval entry number or -1 if not found
+  */
+static inline int Shell_HashIndexFind(const uint16_t *slots, unsigned bits, const uint32_t *hash,
+                                      const char *const *name, size_t stride, const char *key)
+{
+    const uint32_t mask = (1u << bits) - 1u;
+    uint32_t h;
+    uint32_t slot;
+
+    if (0 != Shell_NameHash(key, &h))
+    {
+        return -1;
+    }
+
+    for (slot = Shell_HashSlot(h, bits); SHELL_HASH_EMPTY != slots[slot]; slot = (slot + 1u) & mask)
+    {
+        size_t i = slots[slot] - 1u;
+
+        // full hash compare first, strcmp only runs on the entry that matches
+        if ((h == *(const uint32_t *)((const uint8_t *)hash + i * stride)) &&
+            (0 == strcmp(key, *(const char *const *)((const uint8_t *)name + i * stride))))
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_HASH_H__ */
@@ -0,0 +1,406 @@
+#include <shell_heap.h>
+
+/* Same layout as heap_4's BlockLink_t */
+typedef struct HeapBlock {
+    struct HeapBlock *next;
+    size_t size;
+} HeapBlock_t;
+
+#define HEAP_ALLOCATED_BIT ((size_t)1 << ((sizeof(size_t) * 8u) - 1u))
+
+/* Exported variables --------------------------------------------------------*/
+/* The FreeRTOS heap, configAPPLICATION_ALLOCATED_HEAP */
+uint8_t ucHeap[configTOTAL_HEAP_SIZE];
+
+/**
+  * @brief  walk every heap block and summarize the free ones
+  * @note   runs with the scheduler suspended, the lock heap_4 itself takes,
+  *         so interrupts keep running; only counters are collected here and
+  *         the caller formats afterwards
+  * @param frag summary to fill
+  * @retval None
+  */
+void Shell_HeapWalk(ShellHeapFrag_t *frag)
+{
+    uintptr_t start = ((uintptr_t)ucHeap + portBYTE_ALIGNMENT_MASK) & ~(uintptr_t)portBYTE_ALIGNMENT_MASK;
+    uintptr_t end = (uintptr_t)ucHeap + configTOTAL_HEAP_SIZE;
+    uintptr_t addr = start;
+
+    memset(frag, 0, sizeof(*frag));
+
+    vTaskSuspendAll();
+    while ((addr + sizeof(HeapBlock_t)) <= end)
+    {
+        const HeapBlock_t *block = (const HeapBlock_t *)addr;
+        size_t size = block->size & ~HEAP_ALLOCATED_BIT;
+
+        // a raw size of 0 is heap_4's end marker; anything else smaller than
+        // a header, or running past the heap, would stall or derail the walk
+        if (0 == block->size)
+        {
+            break;
+        }
+        if ((size < sizeof(HeapBlock_t)) || (size > (end - addr)))
+        {
+            frag->corrupt = true;
+            break;
+        }
+
+        if (0 != (block->size & HEAP_ALLOCATED_BIT))
+        {
+            frag->usedBlocks++;
+            frag->usedBytes += size;
+        }
+        else
+        {
+            uint32_t b = 31u - (uint32_t)__builtin_clz((uint32_t)size);
+
+            b = (b < SHELL_HEAP_BUCKETS) ? b : (SHELL_HEAP_BUCKETS - 1u);
+            frag->buckets[b]++;
+            frag->bucketBytes[b] += size;
+            frag->freeBlocks++;
+            frag->freeBytes += size;
+            frag->largest = (size > frag->largest) ? size : frag->largest;
+        }
+        addr += size;
+    }
+    frag->corrupt = frag->corrupt || ((addr + sizeof(HeapBlock_t)) > end);
+    (void)xTaskResumeAll();
+}
+
+/**
+  * @brief  print free block sizes, the largest free block and a fragmentation index
+  * @note   index = 1 - largest / free: 0% is one contiguous free block, near
+  *         100% is free memory scattered in blocks too small to be useful
+  * @param handle shell handle
+  * @retval None
+  */
+void Shell_HeapFrag(Shell_Handle_t *handle)
+{
+    ShellHeapFrag_t frag;
+    uint32_t peak = 0;
+    uint32_t index;
+    char buf[96];
+
+    Shell_HeapWalk(&frag);
+
+    if (frag.corrupt)
+    {
+        sh_print(handle, "Heap walk left the heap, block headers are corrupt\r\n");
+    }
+    if (0 == frag.freeBlocks)
+    {
+        sh_print(handle, "No free blocks\r\n");
+        return;
+    }
+
+    index = 1000u - (uint32_t)(((uint64_t)frag.largest * 1000u) / frag.freeBytes);
+    snprintf(buf, sizeof(buf), "Free: %lu bytes in %lu blocks, largest %lu (fits %lu)\r\n",
+             (unsigned long)frag.freeBytes, (unsigned long)frag.freeBlocks, (unsigned long)frag.largest,
+             (unsigned long)(frag.largest - sizeof(HeapBlock_t)));
+    sh_print(handle, buf);
+    snprintf(buf, sizeof(buf), "Used: %lu bytes in %lu blocks\r\n",
+             (unsigned long)frag.usedBytes, (unsigned long)frag.usedBlocks);
+    sh_print(handle, buf);
+    snprintf(buf, sizeof(buf), "Fragmentation: %lu.%lu%%\r\n", (unsigned long)(index / 10u), (unsigned long)(index % 10u));
+    sh_print(handle, buf);
+
+    for (uint32_t b = 0; b < SHELL_HEAP_BUCKETS; b++)
+    {
+        peak = (frag.buckets[b] > peak) ? frag.buckets[b] : peak;
+    }
+
+    sh_print(handle, "Block size          Blocks     Bytes\r\n");
+    for (uint32_t b = 0; b < SHELL_HEAP_BUCKETS; b++)
+    {
+        uint32_t bar = (frag.buckets[b] * 30u + peak - 1u) / peak;
+
+        if (0 == frag.buckets[b])
+        {
+            continue;
+        }
+
+        if (b < (SHELL_HEAP_BUCKETS - 1u))
+        {
+            snprintf(buf, sizeof(buf), "%7lu - %-7lu  %6lu  %8lu  ", 1ul << b, (2ul << b) - 1ul,
+                     (unsigned long)frag.buckets[b], (unsigned long)frag.bucketBytes[b]);
+        }
+        else
+        {
+            snprintf(buf, sizeof(buf), "%7lu or more  %6lu  %8lu  ", 1ul << b,
+                     (unsigned long)frag.buckets[b], (unsigned long)frag.bucketBytes[b]);
+        }
+        sh_print(handle, buf);
+        memset(buf, '#', bar);
+        buf[bar] = '\0';
+        sh_print(handle, buf);
+        sh_print(handle, "\r\n");
+    }
+}
+
+#if ( configUSE_SHELL_HEAP_TRACE == 1 )
+
+typedef struct {
+    void *block;                        /* NULL: never used, HEAP_TRACE_REMOVED: freed */
+    uint32_t site;
+} HeapTraceLive_t;
+
+#define HEAP_TRACE_LIVE (1u << SHELL_HEAP_TRACE_BITS)
+#define HEAP_TRACE_REMOVED ((void *)1)
+
+/* Exported variables --------------------------------------------------------*/
+volatile uint32_t ulShellHeapTraceOn = 0;
+
+/* Private variables ----------------------------------------------------------*/
+static ShellHeapSite_t traceSites[SHELL_HEAP_TRACE_SITES] __attribute__((section(".ccmbss")));
+static HeapTraceLive_t traceLive[HEAP_TRACE_LIVE] __attribute__((section(".ccmbss")));
+static ShellHeapSite_t traceReport[SHELL_HEAP_TRACE_SITES] __attribute__((section(".ccmbss")));
+static uint32_t traceUsedSites;
+static uint32_t traceUntracked;         /* Blocks that found no live entry */
+static TickType_t traceStart;
+static TickType_t traceEnd;             /* Tick of heap trace stop */
+
+static const ShellWord_t heapTraceWords[] = {
+    { "clear", NULL, 0 },
+    { "start", NULL, 0 },
+    { "stop",  NULL, 0 },
+};
+const ShellWords_t shellHeapTraceArgs = SHELL_WORDS(heapTraceWords, 0);
+
+/**
+  * @brief  live table slot a block hashes to
+  * @param block block address
+  * @retval first slot to probe
+  */
+static inline uint32_t Shell_HeapTraceHash(const void *block)
+{
+    return (((uint32_t)(uintptr_t)block >> 3) * 2654435761u) >> (32u - SHELL_HEAP_TRACE_BITS);
+}
+
+/**
+  * @brief  traceMALLOC hook, account a block to its call site
+  * @note   called inside pvPortMalloc with the scheduler suspended
+  * @param pvAddress block returned to the caller, NULL when the allocation failed
+  * @param pvCaller return address of the pvPortMalloc call
+  * @retval None
+  */
+void Shell_HeapTraceMalloc(void *pvAddress, void *pvCaller)
+{
+    uintptr_t caller = (uintptr_t)pvCaller & ~(uintptr_t)1u;
+    ShellHeapSite_t *site = &traceSites[SHELL_HEAP_TRACE_SITES - 1u];
+    uint32_t index;
+
+    for (index = 0; index < traceUsedSites; index++)
+    {
+        if (caller == traceSites[index].caller)
+        {
+            site = &traceSites[index];
+            break;
+        }
+    }
+    if ((index == traceUsedSites) && (traceUsedSites < (SHELL_HEAP_TRACE_SITES - 1u)))
+    {
+        site = &traceSites[traceUsedSites++];
+        site->caller = caller;
+    }
+    index = (uint32_t)(site - traceSites);
+
+    if (NULL == pvAddress)
+    {
+        site->failures++;
+        return;
+    }
+
+    // the block header in front of the payload holds the real block size
+    size_t size = (((const HeapBlock_t *)pvAddress) - 1)->size & ~HEAP_ALLOCATED_BIT;
+    uint32_t slot = Shell_HeapTraceHash(pvAddress);
+
+    site->allocs++;
+    for (uint32_t probe = 0; probe < SHELL_HEAP_TRACE_PROBES; probe++)
+    {
+        HeapTraceLive_t *entry = &traceLive[(slot + probe) & (HEAP_TRACE_LIVE - 1u)];
+
+        if ((NULL == entry->block) || (HEAP_TRACE_REMOVED == entry->block))
+        {
+            entry->block = pvAddress;
+            entry->site = index;
+            site->liveBlocks++;
+            site->liveBytes += size;
+            site->peakBytes = (site->liveBytes > site->peakBytes) ? site->liveBytes : site->peakBytes;
+            return;
+        }
+    }
+    traceUntracked++;
+}
+
+/**
+  * @brief  traceFREE hook, give a block back to the site that allocated it
+  * @note   called inside vPortFree with the scheduler suspended; blocks
+  *         allocated before the trace started are not found and ignored
+  * @param pvAddress block being freed
+  * @param ulSize block size, header included
+  * @retval None
+  */
+void Shell_HeapTraceFree(void *pvAddress, uint32_t ulSize)
+{
+    uint32_t slot = Shell_HeapTraceHash(pvAddress);
+
+    for (uint32_t probe = 0; probe < SHELL_HEAP_TRACE_PROBES; probe++)
+    {
+        HeapTraceLive_t *entry = &traceLive[(slot + probe) & (HEAP_TRACE_LIVE - 1u)];
+
+        if (NULL == entry->block)
+        {
+            return;
+        }
+        if (pvAddress == entry->block)
+        {
+            ShellHeapSite_t *site = &traceSites[entry->site];
+
+            entry->block = HEAP_TRACE_REMOVED;
+            site->frees++;
+            site->liveBlocks--;
+            site->liveBytes -= ulSize;
+            return;
+        }
+    }
+}
+
+/**
+  * @brief  forget every site and live block
+  * @note   the hooks are off or the scheduler is suspended
+  * @retval None
+  */
+static void Shell_HeapTraceClear(void)
+{
+    memset(traceSites, 0, sizeof(traceSites));
+    memset(traceLive, 0, sizeof(traceLive));
+    traceUsedSites = 0;
+    traceUntracked = 0;
+    traceStart = xTaskGetTickCount();
+    traceEnd = traceStart;
+}
+
+/**
+  * @brief  print live allocations, allocation rate and peak usage per call site
+  * @param handle shell handle
+  * @retval None
+  */
+static void Shell_HeapTraceReport(Shell_Handle_t *handle)
+{
+    uint32_t count;
+    uint32_t untracked;
+    uint32_t elapsed;
+    char buf[96];
+
+    // copy under the heap's own lock, format afterwards
+    vTaskSuspendAll();
+    memcpy(traceReport, traceSites, sizeof(traceReport));
+    count = traceUsedSites;
+    untracked = traceUntracked;
+    elapsed = (uint32_t)(((ulShellHeapTraceOn ? xTaskGetTickCount() : traceEnd) - traceStart) * portTICK_PERIOD_MS);
+    (void)xTaskResumeAll();
+
+    // the overflow site is reported after the named ones when it saw anything
+    if ((0 != traceReport[SHELL_HEAP_TRACE_SITES - 1u].allocs) || (0 != traceReport[SHELL_HEAP_TRACE_SITES - 1u].failures))
+    {
+        traceReport[count++] = traceReport[SHELL_HEAP_TRACE_SITES - 1u];
+    }
+
+    // insertion sort, most live bytes first
+    for (uint32_t i = 1; i < count; i++)
+    {
+        ShellHeapSite_t site = traceReport[i];
+        uint32_t pos = i;
+
+        while ((pos > 0) && (traceReport[pos - 1].liveBytes < site.liveBytes))
+        {
+            traceReport[pos] = traceReport[pos - 1];
+            pos--;
+        }
+        traceReport[pos] = site;
+    }
+
+    snprintf(buf, sizeof(buf), "Heap trace %s, %lu.%lu s, %lu blocks untracked\r\n",
+             ulShellHeapTraceOn ? "running" : "stopped", (unsigned long)(elapsed / 1000u),
+             (unsigned long)((elapsed % 1000u) / 100u), (unsigned long)untracked);
+    sh_print(handle, buf);
+    sh_print(handle, "Call site     Live   Bytes    Peak  Allocs   Frees  Alloc/s  Fail\r\n");
+
+    if (0 == elapsed)
+    {
+        elapsed = 1;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const ShellHeapSite_t *site = &traceReport[i];
+        uint32_t rate = (uint32_t)(((uint64_t)site->allocs * 10000u) / elapsed);
+
+        if (0 == site->caller)
+        {
+            snprintf(buf, sizeof(buf), "%-10s", "(other)");
+        }
+        else
+        {
+            snprintf(buf, sizeof(buf), "0x%08lx", (unsigned long)site->caller);
+        }
+        sh_print(handle, buf);
+        snprintf(buf, sizeof(buf), "  %6lu  %6lu  %6lu  %6lu  %6lu  %5lu.%lu  %4lu\r\n",
+                 (unsigned long)site->liveBlocks, (unsigned long)site->liveBytes,
+                 (unsigned long)site->peakBytes, (unsigned long)site->allocs,
+                 (unsigned long)site->frees, (unsigned long)(rate / 10u), (unsigned long)(rate % 10u),
+                 (unsigned long)site->failures);
+        sh_print(handle, buf);
+    }
+}
+
+/**
+  * @brief  heap trace subcommand
+  * @param handle shell handle
+  * @param argc argument count, argv[0] is "trace"
+  * @param argv argument vector
+  * @retval None
+  */
+void Shell_HeapTrace(Shell_Handle_t *handle, int argc, char *argv[])
+{
+    const char *action = (argc > 1) ? argv[1] : "";
+
+    if (0 == strcmp(action, "start"))
+    {
+        vTaskSuspendAll();
+        if (0 == ulShellHeapTraceOn)
+        {
+            Shell_HeapTraceClear();
+            ulShellHeapTraceOn = 1;
+        }
+        (void)xTaskResumeAll();
+        sh_print(handle, "Heap trace started, call sites are return addresses (addr2line -e <elf>)\r\n");
+    }
+    else if (0 == strcmp(action, "stop"))
+    {
+        if (0 != ulShellHeapTraceOn)
+        {
+            ulShellHeapTraceOn = 0;
+            traceEnd = xTaskGetTickCount();
+        }
+        sh_print(handle, "Heap trace stopped\r\n");
+    }
+    else if (0 == strcmp(action, "clear"))
+    {
+        vTaskSuspendAll();
+        Shell_HeapTraceClear();
+        (void)xTaskResumeAll();
+        sh_print(handle, "Heap trace cleared\r\n");
+    }
+    else if (1 == argc)
+    {
+        Shell_HeapTraceReport(handle);
+    }
+    else
+    {
+        sh_print(handle, "Usage: heap trace [start|stop|clear]\r\n");
+    }
+}
+
+#endif /* configUSE_SHELL_HEAP_TRACE */
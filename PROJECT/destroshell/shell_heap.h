@@ -0,0 +1,70 @@
+#ifndef __SHELL_HEAP_H__
+#define __SHELL_HEAP_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <destroshell.h>
+
+/*
+ * Heap inspection for heap_4. The heap array is provided here
+ * (configAPPLICATION_ALLOCATED_HEAP) so its blocks can be walked: every
+ * block starts with heap_4's BlockLink_t, free blocks have the top bit of
+ * the size clear and the last block (pxEnd) has size 0.
+ */
+
+/* Configuration constants */
+#define SHELL_HEAP_BUCKETS 18           /* buckets[b] counts free blocks of [2^b, 2^(b+1)) bytes */
+
+typedef struct {
+    uint32_t freeBlocks;
+    uint32_t freeBytes;
+    uint32_t largest;                   /* Largest free block, header included */
+    uint32_t usedBlocks;
+    uint32_t usedBytes;
+    bool corrupt;                       /* Walk left the heap before reaching the end block */
+    uint32_t buckets[SHELL_HEAP_BUCKETS];
+    uint32_t bucketBytes[SHELL_HEAP_BUCKETS];
+} ShellHeapFrag_t;
+
+#if ( configUSE_SHELL_HEAP_TRACE == 1 )
+
+/*
+ * Allocation trace. The traceMALLOC/traceFREE hooks (see FreeRTOSConfig.h)
+ * attribute every block to the return address of its pvPortMalloc call.
+ * Both tables are fixed size and probed a bounded number of times, so a
+ * hook costs the same however long the trace runs; what does not fit is
+ * counted, not tracked. The tables live in CCMRAM.
+ */
+#define SHELL_HEAP_TRACE_SITES 32       /* Distinct call sites, the last one collects the rest */
+#define SHELL_HEAP_TRACE_BITS 8         /* Live block table of 2^bits entries */
+#define SHELL_HEAP_TRACE_PROBES 16      /* Entries tried before a block goes untracked */
+
+typedef struct {
+    uintptr_t caller;                   /* Return address of the pvPortMalloc call, 0 for the overflow site */
+    uint32_t allocs;
+    uint32_t frees;                     /* Frees of blocks allocated while tracing */
+    uint32_t failures;                  /* pvPortMalloc returned NULL */
+    uint32_t liveBlocks;
+    uint32_t liveBytes;                 /* Block sizes, heap_4 header included */
+    uint32_t peakBytes;
+} ShellHeapSite_t;
+
+/* Words after "heap trace" */
+extern const ShellWords_t shellHeapTraceArgs;
+
+#endif /* configUSE_SHELL_HEAP_TRACE */
+
+/* API prototypes */
+void Shell_HeapWalk(ShellHeapFrag_t *frag);
+void Shell_HeapFrag(Shell_Handle_t *handle);
+#if ( configUSE_SHELL_HEAP_TRACE == 1 )
+void Shell_HeapTrace(Shell_Handle_t *handle, int argc, char *argv[]);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_HEAP_H__ */
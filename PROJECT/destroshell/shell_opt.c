@@ -0,0 +1,277 @@
+#include <shell_opt.h>
+#include <shell_complete.h>
+#include <stdlib.h>
+
+/* Private variables ----------------------------------------------------------*/
+static const ShellWord_t boolWords[] = {
+    { "0",       NULL, 0 },
+    { "1",       NULL, 1 },
+    { "disable", NULL, 0 },
+    { "enable",  NULL, 1 },
+    { "false",   NULL, 0 },
+    { "off",     NULL, 0 },
+    { "on",      NULL, 1 },
+    { "true",    NULL, 1 },
+};
+
+/* Exported variables --------------------------------------------------------*/
+const ShellWords_t shellBoolWords = SHELL_WORDS(boolWords, 0);
+
+/**
+  * @brief  parse an unsigned integer option value
+  * @note   decimal or 0x hexadecimal, an optional k or M suffix multiplies by 10^3 or 10^6
+  * @param str value text
+  * @param value receives the number
+  * @retval true if str is a complete number that fits 32 bits
+  */
+bool Shell_OptParseInt(const char *str, uint32_t *value)
+{
+    unsigned long long v;
+    char *end;
+    int base = 10;
+
+    if ((str[0] < '0') || (str[0] > '9'))
+    {
+        return false;
+    }
+
+    if (('0' == str[0]) && (('x' == str[1]) || ('X' == str[1])))
+    {
+        base = 16;
+    }
+
+    v = strtoull(str, &end, base);
+    if (v > UINT32_MAX)
+    {
+        return false;
+    }
+
+    if (('k' == *end) || ('K' == *end))
+    {
+        v *= 1000u;
+        end++;
+    }
+    else if ('M' == *end)
+    {
+        v *= 1000000u;
+        end++;
+    }
+
+    if (('\0' != *end) || (v > UINT32_MAX))
+    {
+        return false;
+    }
+
+    *value = (uint32_t)v;
+    return true;
+}
+
+/**
+  * @brief  print the words of a value list separated by '/'
+  * @param handle shell handle
+  * @param values value list
+  * @retval None
+  */
+static void Shell_OptPrintValues(Shell_Handle_t *handle, const ShellWords_t *values)
+{
+    for (uint16_t i = 0; i < values->count; i++)
+    {
+        if (i > 0)
+        {
+            sh_print(handle, "/");
+        }
+        sh_print(handle, values->words[i].word);
+    }
+}
+
+/**
+  * @brief  parse options against a schema in a single pass
+  * @note   every field described by the schema is written, defaults first
+  * @param handle shell handle, invalid options are reported on it
+  * @param schema options level built with SHELL_OPTIONS
+  * @param argc number of option words
+  * @param argv option words
+  * @param out options struct the schema offsets refer to
+  * @retval true if every option was valid
+  */
+bool Shell_ParseOptions(Shell_Handle_t *handle, const ShellWords_t *schema, int argc, char *argv[], void *out)
+{
+    char buf[128];
+
+    for (uint16_t i = 0; i < schema->count; i++)
+    {
+        *(uint32_t *)((uint8_t *)out + schema->opts[i].offset) = schema->opts[i].def;
+    }
+
+    for (int i = 0; i < argc; i++)
+    {
+        int index = Shell_WordsFind(schema, argv[i]);
+        const ShellOpt_t *opt;
+        const char *value;
+        uint32_t *field;
+        uint32_t number;
+
+        if (index < 0)
+        {
+            snprintf(buf, sizeof(buf), "Unknown option: %s\r\n", argv[i]);
+            sh_print(handle, buf);
+            return false;
+        }
+
+        opt = &schema->opts[index];
+        field = (uint32_t *)((uint8_t *)out + opt->offset);
+        value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        // a bare boolean flag switches the option on
+        if ((SHELL_OPT_BOOL == opt->type) && ((NULL == value) || ('-' == value[0])))
+        {
+            *field = 1;
+            continue;
+        }
+
+        if (NULL == value)
+        {
+            snprintf(buf, sizeof(buf), "Missing value for %s\r\n", opt->flag);
+            sh_print(handle, buf);
+            return false;
+        }
+        i++;
+
+        if (SHELL_OPT_INT == opt->type)
+        {
+            if (!Shell_OptParseInt(value, &number))
+            {
+                snprintf(buf, sizeof(buf), "Invalid number for %s: %s\r\n", opt->flag, value);
+                sh_print(handle, buf);
+                return false;
+            }
+
+            if ((number < opt->min) || (number > opt->max))
+            {
+                snprintf(buf, sizeof(buf), "%s out of range %lu..%lu: %s\r\n", opt->flag,
+                         (unsigned long)opt->min, (unsigned long)opt->max, value);
+                sh_print(handle, buf);
+                return false;
+            }
+
+            *field = number;
+            continue;
+        }
+
+        index = Shell_WordsFind(opt->values, value);
+        if (index < 0)
+        {
+            snprintf(buf, sizeof(buf), "Invalid value for %s: %s, expected ", opt->flag, value);
+            sh_print(handle, buf);
+            Shell_OptPrintValues(handle, opt->values);
+            sh_print(handle, "\r\n");
+            return false;
+        }
+
+        *field = opt->values->words[index].value;
+    }
+    return true;
+}
+
+/**
+  * @brief  print the options of a schema with their accepted values and defaults
+  * @param handle shell handle
+  * @param schema options level built with SHELL_OPTIONS
+  * @retval None
+  */
+void Shell_PrintOptions(Shell_Handle_t *handle, const ShellWords_t *schema)
+{
+    char buf[64];
+
+    for (uint16_t i = 0; i < schema->count; i++)
+    {
+        const ShellOpt_t *opt = &schema->opts[i];
+
+        sh_print(handle, "   [");
+        sh_print(handle, opt->flag);
+        sh_print(handle, " <");
+        if (SHELL_OPT_INT == opt->type)
+        {
+            snprintf(buf, sizeof(buf), "%lu..%lu", (unsigned long)opt->min, (unsigned long)opt->max);
+            sh_print(handle, buf);
+        }
+        else if (SHELL_OPT_BOOL == opt->type)
+        {
+            sh_print(handle, "on/off");
+        }
+        else
+        {
+            Shell_OptPrintValues(handle, opt->values);
+        }
+        sh_print(handle, ">]");
+
+        // defaults are shown as the user would type them
+        if (SHELL_OPT_INT == opt->type)
+        {
+            snprintf(buf, sizeof(buf), " default %lu\r\n", (unsigned long)opt->def);
+            sh_print(handle, buf);
+            continue;
+        }
+
+        if (SHELL_OPT_BOOL == opt->type)
+        {
+            sh_print(handle, (0 != opt->def) ? " default on\r\n" : " default off\r\n");
+            continue;
+        }
+
+        for (uint16_t k = 0; k < opt->values->count; k++)
+        {
+            if (opt->values->words[k].value == opt->def)
+            {
+                sh_print(handle, " default ");
+                sh_print(handle, opt->values->words[k].word);
+                break;
+            }
+        }
+        sh_print(handle, "\r\n");
+    }
+}
+
+/**
+  * @brief  print parsed options the way they would be typed
+  * @param handle shell handle
+  * @param schema options level built with SHELL_OPTIONS
+  * @param options options struct filled by Shell_ParseOptions
+  * @retval None
+  */
+void Shell_PrintOptionValues(Shell_Handle_t *handle, const ShellWords_t *schema, const void *options)
+{
+    char buf[32];
+
+    for (uint16_t i = 0; i < schema->count; i++)
+    {
+        const ShellOpt_t *opt = &schema->opts[i];
+        uint32_t value = *(const uint32_t *)((const uint8_t *)options + opt->offset);
+
+        sh_print(handle, " ");
+        sh_print(handle, opt->flag);
+
+        if (SHELL_OPT_INT == opt->type)
+        {
+            snprintf(buf, sizeof(buf), " %lu", (unsigned long)value);
+            sh_print(handle, buf);
+            continue;
+        }
+
+        if (SHELL_OPT_BOOL == opt->type)
+        {
+            sh_print(handle, (0 != value) ? " on" : " off");
+            continue;
+        }
+
+        for (uint16_t k = 0; k < opt->values->count; k++)
+        {
+            if (opt->values->words[k].value == value)
+            {
+                sh_print(handle, " ");
+                sh_print(handle, opt->values->words[k].word);
+                break;
+            }
+        }
+    }
+}
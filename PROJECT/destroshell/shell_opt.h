@@ -0,0 +1,56 @@
+#ifndef __SHELL_OPT_H__
+#define __SHELL_OPT_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <destroshell.h>
+#include <stddef.h>
+
+/*
+ * Option schema. A command describes its -flags in a const table sorted by
+ * flag; Shell_ParseOptions fills a struct of uint32_t fields from it in one
+ * pass over argv. The same table is the options level of the argument word
+ * trie, so TAB completion and prefix expansion know every flag and value.
+ */
+typedef enum {
+    SHELL_OPT_ENUM = 0,                 /* One of the words in values, stores that word's value */
+    SHELL_OPT_INT,                      /* Unsigned in [min, max], 0x prefix and k/M suffixes accepted */
+    SHELL_OPT_BOOL                      /* Bare flag, or on/off, enable/disable, true/false, 1/0 */
+} ShellOptType_t;
+
+typedef struct ShellOpt {
+    const char *flag;                   /* "-name", the schema is sorted by flag */
+    ShellOptType_t type;
+    uint16_t offset;                    /* offsetof the uint32_t field in the options struct */
+    const ShellWords_t *values;         /* Accepted words with their value (enum and bool) */
+    uint32_t min;                       /* Integer range, inclusive */
+    uint32_t max;
+    uint32_t def;                       /* Stored when the option is not given */
+} ShellOpt_t;
+
+/* Words accepted by boolean options */
+extern const ShellWords_t shellBoolWords;
+
+#define SHELL_OPTION_ENUM(flag, type, field, values, def) \
+    { flag, SHELL_OPT_ENUM, offsetof(type, field), &(values), 0, 0, def }
+#define SHELL_OPTION_INT(flag, type, field, min, max, def) \
+    { flag, SHELL_OPT_INT, offsetof(type, field), NULL, min, max, def }
+#define SHELL_OPTION_BOOL(flag, type, field, def) \
+    { flag, SHELL_OPT_BOOL, offsetof(type, field), &shellBoolWords, 0, 1, def }
+
+/* Options level of the word trie built from a schema table */
+#define SHELL_OPTIONS(opts)  { NULL, opts, sizeof(opts) / sizeof((opts)[0]), SHELL_WORDS_OPTIONS }
+
+/* API prototypes */
+bool Shell_ParseOptions(Shell_Handle_t *handle, const ShellWords_t *schema, int argc, char *argv[], void *out);
+bool Shell_OptParseInt(const char *str, uint32_t *value);
+void Shell_PrintOptions(Shell_Handle_t *handle, const ShellWords_t *schema);
+void Shell_PrintOptionValues(Shell_Handle_t *handle, const ShellWords_t *schema, const void *options);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_OPT_H__ */
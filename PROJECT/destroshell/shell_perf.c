@@ -0,0 +1,207 @@
+#include <shell_perf.h>
+#include <shell_complete.h>
+
+#if SHELL_PERF
+
+/* Exported variables --------------------------------------------------------*/
+ShellPerf_t *shellPerf = NULL;
+TickType_t shellPerfWrapTicks = portMAX_DELAY;
+
+/* Private variables ----------------------------------------------------------*/
+static const ShellWord_t perfWords[] = {
+    { "hist",  &shellCommandWords, 0 },
+    { "reset", NULL, 0 },
+};
+static const ShellWords_t perfArgs = SHELL_WORDS(perfWords, 0);
+
+/**
+  * @brief  clear the statistics of every command
+  * @note   one entry per critical section, other sessions may be recording
+  * @retval None
+  */
+static void Shell_PerfReset(void)
+{
+    size_t count = SHELL_COMMANDS_END - SHELL_COMMANDS_BEGIN;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        taskENTER_CRITICAL();
+        memset(&shellPerf[i], 0, sizeof(ShellPerf_t));
+        shellPerf[i].min = UINT32_MAX;
+        taskEXIT_CRITICAL();
+    }
+}
+
+/**
+  * @brief  consistent copy of the statistics of a command
+  * @param command command to read
+  * @param perf receives the copy
+  * @retval None
+  */
+static void Shell_PerfRead(const ShellCommand_t *command, ShellPerf_t *perf)
+{
+    taskENTER_CRITICAL();
+    *perf = shellPerf[command - SHELL_COMMANDS_BEGIN];
+    taskEXIT_CRITICAL();
+}
+
+/**
+  * @brief  allocate the statistics, one entry per registered command
+  * @note   called from Shell_Init, the table size is only known after linking
+  * @retval None
+  */
+void Shell_PerfInit(void)
+{
+    size_t count = SHELL_COMMANDS_END - SHELL_COMMANDS_BEGIN;
+
+    // a call spanning this many ticks may have wrapped CYCCNT
+    shellPerfWrapTicks = (TickType_t)(((uint64_t)UINT32_MAX * configTICK_RATE_HZ) / SystemCoreClock);
+
+    shellPerf = pvPortMalloc(count * sizeof(ShellPerf_t));
+    if (NULL != shellPerf)
+    {
+        Shell_PerfReset();
+    }
+}
+
+/**
+  * @brief  upper bound of the bucket holding a percentile
+  * @param perf command statistics
+  * @param permille percentile in 1/1000
+  * @retval cycles, never above the maximum seen
+  */
+static uint32_t Shell_PerfPercentile(const ShellPerf_t *perf, uint32_t permille)
+{
+    uint32_t rank = (uint32_t)(((uint64_t)perf->count * permille + 999u) / 1000u);
+    uint32_t seen = 0;
+
+    for (uint32_t b = 0; b < SHELL_PERF_BUCKETS; b++)
+    {
+        seen += perf->hist[b];
+        if (seen >= rank)
+        {
+            uint32_t bound = (b < 31u) ? ((2u << b) - 1u) : UINT32_MAX;
+            return (bound < perf->max) ? bound : perf->max;
+        }
+    }
+    return perf->max;
+}
+
+/**
+  * @brief  print the latency histogram of one command
+  * @param handle shell handle
+  * @param command command to show
+  * @retval None
+  */
+static void Shell_PerfHist(Shell_Handle_t *handle, const ShellCommand_t *command)
+{
+    ShellPerf_t copy;
+    const ShellPerf_t *perf = &copy;
+    uint32_t peak = 0;
+    char buf[96];
+
+    Shell_PerfRead(command, &copy);
+
+    if (0 == perf->count)
+    {
+        sh_print(handle, "No calls recorded\r\n");
+        return;
+    }
+
+    for (uint32_t b = 0; b < SHELL_PERF_BUCKETS; b++)
+    {
+        peak = (perf->hist[b] > peak) ? perf->hist[b] : peak;
+    }
+
+    sh_print(handle, "Cycles                      Calls\r\n");
+    for (uint32_t b = 0; b < SHELL_PERF_BUCKETS; b++)
+    {
+        uint32_t bar = (uint32_t)(((uint64_t)perf->hist[b] * 30u + peak - 1u) / peak);
+
+        if (0 == perf->hist[b])
+        {
+            continue;
+        }
+
+        snprintf(buf, sizeof(buf), "%10lu - %-10lu  %8lu  ", 1ul << b,
+                 (b < 31u) ? ((2ul << b) - 1ul) : (unsigned long)UINT32_MAX, (unsigned long)perf->hist[b]);
+        sh_print(handle, buf);
+        memset(buf, '#', bar);
+        buf[bar] = '\0';
+        sh_print(handle, buf);
+        sh_print(handle, "\r\n");
+    }
+}
+
+/**
+  * @brief  show per command latency in CPU cycles
+  * @param handle shell handle
+  * @param argc argument count
+  * @param argv argument vector
+  * @retval None
+  */
+void shell_cmd_perf(Shell_Handle_t *handle, int argc, char *argv[])
+{
+    char buf[96];
+
+    if (NULL == shellPerf)
+    {
+        sh_print(handle, "Command statistics are not available\r\n");
+        return;
+    }
+
+    if ((2 == argc) && (0 == strcmp(argv[1], "reset")))
+    {
+        Shell_PerfReset();
+        sh_print(handle, "Command statistics cleared\r\n");
+        return;
+    }
+
+    if ((3 == argc) && (0 == strcmp(argv[1], "hist")))
+    {
+        const ShellCommand_t *command = Shell_FindCommand(argv[2]);
+
+        if (NULL == command)
+        {
+            snprintf(buf, sizeof(buf), "Unknown command: %s\r\n", argv[2]);
+            sh_print(handle, buf);
+            return;
+        }
+        Shell_PerfHist(handle, command);
+        return;
+    }
+
+    if (1 != argc)
+    {
+        sh_print(handle, "Usage: perf | perf hist <command> | perf reset\r\n");
+        return;
+    }
+
+    snprintf(buf, sizeof(buf), "Cycles at %lu MHz\r\n", (unsigned long)(SystemCoreClock / 1000000u));
+    sh_print(handle, buf);
+    sh_print(handle, "Command        Calls         Min        Mean         p99         Max\r\n");
+
+    for (const ShellCommand_t *command = SHELL_COMMANDS_BEGIN; command < SHELL_COMMANDS_END; command++)
+    {
+        ShellPerf_t copy;
+        const ShellPerf_t *perf = &copy;
+
+        Shell_PerfRead(command, &copy);
+        if (0 == perf->count)
+        {
+            continue;
+        }
+
+        snprintf(buf, sizeof(buf), "%-12s%8lu  %10lu  %10lu  %10lu  %10lu\r\n",
+                 command->commandName,
+                 (unsigned long)perf->count,
+                 (unsigned long)perf->min,
+                 (unsigned long)(perf->total / perf->count),
+                 (unsigned long)Shell_PerfPercentile(perf, 990u),
+                 (unsigned long)perf->max);
+        sh_print(handle, buf);
+    }
+}
+SHELL_COMMAND_ARGS(perf, "Show per command latency", "perf | perf hist <command> | perf reset", shell_cmd_perf, &perfArgs);
+
+#endif /* SHELL_PERF */
@@ -0,0 +1,100 @@
+#ifndef __SHELL_PERF_H__
+#define __SHELL_PERF_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <destroshell.h>
+
+/*
+ * Per command latency, measured around every commandHandler call with the
+ * DWT cycle counter. The time is wall clock from dispatch to return, so it
+ * includes preemption and the time a command blocks. Each command keeps a
+ * histogram with power of two buckets; percentiles are read from it.
+ * Build with SHELL_PERF=0 to compile the timing out of Shell_Task.
+ */
+#ifndef SHELL_PERF
+#define SHELL_PERF 1
+#endif
+
+#define SHELL_PERF_BUCKETS 32           /* hist[b] counts calls of [2^b, 2^(b+1)) cycles */
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t hist[SHELL_PERF_BUCKETS];
+} ShellPerf_t;
+
+#if SHELL_PERF
+
+/* One entry per command, in command table order; NULL if allocation failed */
+extern ShellPerf_t *shellPerf;
+extern TickType_t shellPerfWrapTicks;
+
+/**
+  * @brief  add one call to the statistics of a command
+  * @note   inline so a dispatch costs a CLZ and a few loads and stores; the
+  *         entry is updated in a critical section as sessions finish
+  *         commands concurrently
+  * @param index command table index
+  * @param cycles CYCCNT delta of the call
+  * @param ticks tick count delta, tells a call longer than one CYCCNT wrap
+  * @retval None
+  */
+static inline void Shell_PerfRecord(size_t index, uint32_t cycles, TickType_t ticks)
+{
+    ShellPerf_t *perf;
+
+    if (NULL == shellPerf)
+    {
+        return;
+    }
+    perf = &shellPerf[index];
+
+    if (ticks >= shellPerfWrapTicks)
+    {
+        cycles = UINT32_MAX;
+    }
+
+    taskENTER_CRITICAL();
+    perf->hist[31u - (uint32_t)__builtin_clz(cycles | 1u)]++;
+    perf->count++;
+    perf->total += cycles;
+    if (cycles < perf->min)
+    {
+        perf->min = cycles;
+    }
+    if (cycles > perf->max)
+    {
+        perf->max = cycles;
+    }
+    taskEXIT_CRITICAL();
+}
+
+#define SHELL_PERF_BEGIN(start)                                                            \
+    uint32_t start = DWT->CYCCNT;                                                          \
+    TickType_t start##Tick = xTaskGetTickCount()
+
+#define SHELL_PERF_END(command, start)                                                     \
+    Shell_PerfRecord((size_t)((command) - SHELL_COMMANDS_BEGIN), DWT->CYCCNT - (start),    \
+                     xTaskGetTickCount() - start##Tick)
+
+/* API prototypes */
+void Shell_PerfInit(void);
+
+#else
+
+#define SHELL_PERF_BEGIN(start)
+#define SHELL_PERF_END(command, start)
+#define Shell_PerfInit()
+
+#endif /* SHELL_PERF */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_PERF_H__ */
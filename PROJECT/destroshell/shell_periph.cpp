@@ -0,0 +1,452 @@
+#include <shell_periph.h>
+#include <shell_hash.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace {
+
+/* Private constants ---------------------------------------------------------*/
+constexpr unsigned periphIndexBits = 6;         /* 64 slots, keep the table below half of that */
+
+constexpr uint32_t hashWeights[SHELL_CMD_NAME_MAX] = {
+    SHELL_HASH_W0,  SHELL_HASH_W1,  SHELL_HASH_W2,  SHELL_HASH_W3,
+    SHELL_HASH_W4,  SHELL_HASH_W5,  SHELL_HASH_W6,  SHELL_HASH_W7,
+    SHELL_HASH_W8,  SHELL_HASH_W9,  SHELL_HASH_W10, SHELL_HASH_W11,
+    SHELL_HASH_W12, SHELL_HASH_W13, SHELL_HASH_W14, SHELL_HASH_W15
+};
+
+constexpr uintptr_t apb1enr = RCC_BASE + offsetof(RCC_TypeDef, APB1ENR);
+constexpr uintptr_t apb2enr = RCC_BASE + offsetof(RCC_TypeDef, APB2ENR);
+
+constexpr ShellPeriphDma_t noDma = { 0, 0 };
+
+/* Compile time helpers ------------------------------------------------------*/
+constexpr char foldCase(char c)
+{
+    return ((c >= 'A') && (c <= 'Z')) ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+/* same value as Shell_NameHash() of the lower case name */
+constexpr uint32_t foldHash(const char *name)
+{
+    uint32_t h = 0;
+
+    for (size_t i = 0; ('\0' != name[i]) && (i < SHELL_CMD_NAME_MAX); i++)
+    {
+        h += static_cast<uint32_t>(static_cast<uint8_t>(foldCase(name[i]))) * hashWeights[i];
+    }
+    return h;
+}
+
+constexpr bool sameName(const char *a, const char *b)
+{
+    size_t i = 0;
+
+    while (('\0' != a[i]) && (a[i] == b[i]))
+    {
+        i++;
+    }
+    return a[i] == b[i];
+}
+
+constexpr ShellPeriphDma_t dma(uintptr_t stream, uint32_t channel)
+{
+    return { stream, channel };
+}
+
+constexpr ShellPeriphPins_t pins(uintptr_t port, uint16_t mask, uint8_t af)
+{
+    return { port, mask, af };
+}
+
+constexpr ShellPeriph_t periph(ShellPeriphType_t type, const char *name, uintptr_t base,
+                               uintptr_t rccEnr, uint32_t rccMask, IRQn_Type irq,
+                               ShellPeriphDma_t rx, ShellPeriphDma_t tx,
+                               ShellPeriphPins_t p0 = { 0, 0, 0 }, ShellPeriphPins_t p1 = { 0, 0, 0 })
+{
+    return { name, foldHash(name), type, base, rccEnr, rccMask, irq, rx, tx, { p0, p1 }, { 0, 0, 0 }, { 0, 0, 0 } };
+}
+
+/* USART descriptor with its RTS/CTS pins */
+constexpr ShellPeriph_t flow(ShellPeriph_t desc, ShellPeriphPins_t cts, ShellPeriphPins_t rts)
+{
+    desc.cts = cts;
+    desc.rts = rts;
+    return desc;
+}
+
+/* Descriptor table ----------------------------------------------------------*/
+/*
+ * RTS/CTS: usart2 takes PD3/PD4 as PA0 is the user button and PA0/PA1 are
+ * uart4; usart3 takes PB13/PB14 as PD12 drives an LED. UART4/5 have no
+ * flow control and USART6 has it on port G only, which the 100 pin package
+ * lacks.
+ */
+constexpr ShellPeriph_t periphTable[] = {
+    flow(periph(SHELL_PERIPH_USART, "usart1", USART1_BASE, apb2enr, RCC_APB2ENR_USART1EN, USART1_IRQn,
+                dma(DMA2_Stream2_BASE, DMA_CHANNEL_4), dma(DMA2_Stream7_BASE, DMA_CHANNEL_4),
+                pins(GPIOA_BASE, GPIO_PIN_9 | GPIO_PIN_10, GPIO_AF7_USART1)),
+         pins(GPIOA_BASE, GPIO_PIN_11, GPIO_AF7_USART1), pins(GPIOA_BASE, GPIO_PIN_12, GPIO_AF7_USART1)),
+    flow(periph(SHELL_PERIPH_USART, "usart2", USART2_BASE, apb1enr, RCC_APB1ENR_USART2EN, USART2_IRQn,
+                dma(DMA1_Stream5_BASE, DMA_CHANNEL_4), dma(DMA1_Stream6_BASE, DMA_CHANNEL_4),
+                pins(GPIOA_BASE, GPIO_PIN_2 | GPIO_PIN_3, GPIO_AF7_USART2)),
+         pins(GPIOD_BASE, GPIO_PIN_3, GPIO_AF7_USART2), pins(GPIOD_BASE, GPIO_PIN_4, GPIO_AF7_USART2)),
+    flow(periph(SHELL_PERIPH_USART, "usart3", USART3_BASE, apb1enr, RCC_APB1ENR_USART3EN, USART3_IRQn,
+                dma(DMA1_Stream1_BASE, DMA_CHANNEL_4), dma(DMA1_Stream3_BASE, DMA_CHANNEL_4),
+                pins(GPIOB_BASE, GPIO_PIN_10 | GPIO_PIN_11, GPIO_AF7_USART3)),
+         pins(GPIOB_BASE, GPIO_PIN_13, GPIO_AF7_USART3), pins(GPIOB_BASE, GPIO_PIN_14, GPIO_AF7_USART3)),
+    periph(SHELL_PERIPH_USART, "uart4", UART4_BASE, apb1enr, RCC_APB1ENR_UART4EN, UART4_IRQn,
+           dma(DMA1_Stream2_BASE, DMA_CHANNEL_4), dma(DMA1_Stream4_BASE, DMA_CHANNEL_4),
+           pins(GPIOA_BASE, GPIO_PIN_0 | GPIO_PIN_1, GPIO_AF8_UART4)),
+    periph(SHELL_PERIPH_USART, "uart5", UART5_BASE, apb1enr, RCC_APB1ENR_UART5EN, UART5_IRQn,
+           dma(DMA1_Stream0_BASE, DMA_CHANNEL_4), dma(DMA1_Stream7_BASE, DMA_CHANNEL_4),
+           pins(GPIOC_BASE, GPIO_PIN_12, GPIO_AF8_UART5), pins(GPIOD_BASE, GPIO_PIN_2, GPIO_AF8_UART5)),
+    periph(SHELL_PERIPH_USART, "usart6", USART6_BASE, apb2enr, RCC_APB2ENR_USART6EN, USART6_IRQn,
+           dma(DMA2_Stream1_BASE, DMA_CHANNEL_5), dma(DMA2_Stream6_BASE, DMA_CHANNEL_5),
+           pins(GPIOC_BASE, GPIO_PIN_6 | GPIO_PIN_7, GPIO_AF8_USART6)),
+
+    periph(SHELL_PERIPH_I2C, "i2c1", I2C1_BASE, apb1enr, RCC_APB1ENR_I2C1EN, I2C1_EV_IRQn,
+           dma(DMA1_Stream0_BASE, DMA_CHANNEL_1), dma(DMA1_Stream6_BASE, DMA_CHANNEL_1),
+           pins(GPIOB_BASE, GPIO_PIN_6 | GPIO_PIN_7, GPIO_AF4_I2C1)),
+    periph(SHELL_PERIPH_I2C, "i2c2", I2C2_BASE, apb1enr, RCC_APB1ENR_I2C2EN, I2C2_EV_IRQn,
+           dma(DMA1_Stream2_BASE, DMA_CHANNEL_7), dma(DMA1_Stream7_BASE, DMA_CHANNEL_7),
+           pins(GPIOB_BASE, GPIO_PIN_10 | GPIO_PIN_11, GPIO_AF4_I2C2)),
+    periph(SHELL_PERIPH_I2C, "i2c3", I2C3_BASE, apb1enr, RCC_APB1ENR_I2C3EN, I2C3_EV_IRQn,
+           dma(DMA1_Stream2_BASE, DMA_CHANNEL_3), dma(DMA1_Stream4_BASE, DMA_CHANNEL_3),
+           pins(GPIOA_BASE, GPIO_PIN_8, GPIO_AF4_I2C3), pins(GPIOC_BASE, GPIO_PIN_9, GPIO_AF4_I2C3)),
+
+    periph(SHELL_PERIPH_SPI, "spi1", SPI1_BASE, apb2enr, RCC_APB2ENR_SPI1EN, SPI1_IRQn,
+           dma(DMA2_Stream0_BASE, DMA_CHANNEL_3), dma(DMA2_Stream3_BASE, DMA_CHANNEL_3),
+           pins(GPIOA_BASE, GPIO_PIN_5 | GPIO_PIN_6 | GPIO_PIN_7, GPIO_AF5_SPI1)),
+    periph(SHELL_PERIPH_SPI, "spi2", SPI2_BASE, apb1enr, RCC_APB1ENR_SPI2EN, SPI2_IRQn,
+           dma(DMA1_Stream3_BASE, DMA_CHANNEL_0), dma(DMA1_Stream4_BASE, DMA_CHANNEL_0),
+           pins(GPIOC_BASE, GPIO_PIN_2 | GPIO_PIN_3, GPIO_AF5_SPI2), pins(GPIOB_BASE, GPIO_PIN_10, GPIO_AF5_SPI2)),
+    periph(SHELL_PERIPH_SPI, "spi3", SPI3_BASE, apb1enr, RCC_APB1ENR_SPI3EN, SPI3_IRQn,
+           dma(DMA1_Stream0_BASE, DMA_CHANNEL_0), dma(DMA1_Stream5_BASE, DMA_CHANNEL_0),
+           pins(GPIOC_BASE, GPIO_PIN_10 | GPIO_PIN_11 | GPIO_PIN_12, GPIO_AF6_SPI3)),
+
+    periph(SHELL_PERIPH_TIM, "tim1", TIM1_BASE, apb2enr, RCC_APB2ENR_TIM1EN, TIM1_UP_TIM10_IRQn,
+           dma(DMA2_Stream5_BASE, DMA_CHANNEL_6), noDma),
+    periph(SHELL_PERIPH_TIM, "tim2", TIM2_BASE, apb1enr, RCC_APB1ENR_TIM2EN, TIM2_IRQn,
+           dma(DMA1_Stream1_BASE, DMA_CHANNEL_3), noDma),
+    periph(SHELL_PERIPH_TIM, "tim3", TIM3_BASE, apb1enr, RCC_APB1ENR_TIM3EN, TIM3_IRQn,
+           dma(DMA1_Stream2_BASE, DMA_CHANNEL_5), noDma),
+    periph(SHELL_PERIPH_TIM, "tim4", TIM4_BASE, apb1enr, RCC_APB1ENR_TIM4EN, TIM4_IRQn,
+           dma(DMA1_Stream6_BASE, DMA_CHANNEL_2), noDma),
+    periph(SHELL_PERIPH_TIM, "tim5", TIM5_BASE, apb1enr, RCC_APB1ENR_TIM5EN, TIM5_IRQn,
+           dma(DMA1_Stream0_BASE, DMA_CHANNEL_6), noDma),
+    periph(SHELL_PERIPH_TIM, "tim6", TIM6_BASE, apb1enr, RCC_APB1ENR_TIM6EN, TIM6_DAC_IRQn,
+           dma(DMA1_Stream1_BASE, DMA_CHANNEL_7), noDma),
+    periph(SHELL_PERIPH_TIM, "tim7", TIM7_BASE, apb1enr, RCC_APB1ENR_TIM7EN, TIM7_IRQn,
+           dma(DMA1_Stream2_BASE, DMA_CHANNEL_1), noDma),
+    periph(SHELL_PERIPH_TIM, "tim8", TIM8_BASE, apb2enr, RCC_APB2ENR_TIM8EN, TIM8_UP_TIM13_IRQn,
+           dma(DMA2_Stream1_BASE, DMA_CHANNEL_7), noDma),
+    periph(SHELL_PERIPH_TIM, "tim9", TIM9_BASE, apb2enr, RCC_APB2ENR_TIM9EN, TIM1_BRK_TIM9_IRQn,
+           noDma, noDma),
+    periph(SHELL_PERIPH_TIM, "tim10", TIM10_BASE, apb2enr, RCC_APB2ENR_TIM10EN, TIM1_UP_TIM10_IRQn,
+           noDma, noDma),
+    periph(SHELL_PERIPH_TIM, "tim11", TIM11_BASE, apb2enr, RCC_APB2ENR_TIM11EN, TIM1_TRG_COM_TIM11_IRQn,
+           noDma, noDma),
+    periph(SHELL_PERIPH_TIM, "tim12", TIM12_BASE, apb1enr, RCC_APB1ENR_TIM12EN, TIM8_BRK_TIM12_IRQn,
+           noDma, noDma),
+    periph(SHELL_PERIPH_TIM, "tim13", TIM13_BASE, apb1enr, RCC_APB1ENR_TIM13EN, TIM8_UP_TIM13_IRQn,
+           noDma, noDma),
+    periph(SHELL_PERIPH_TIM, "tim14", TIM14_BASE, apb1enr, RCC_APB1ENR_TIM14EN, TIM8_TRG_COM_TIM14_IRQn,
+           noDma, noDma),
+};
+
+constexpr size_t periphCount = sizeof(periphTable) / sizeof(periphTable[0]);
+
+struct TypeName {
+    const char *name;
+    ShellPeriphType_t type;
+};
+
+constexpr TypeName typeNames[] = {
+    { "i2c",   SHELL_PERIPH_I2C },
+    { "rtc",   SHELL_PERIPH_RTC },
+    { "spi",   SHELL_PERIPH_SPI },
+    { "tim",   SHELL_PERIPH_TIM },
+    { "uart",  SHELL_PERIPH_USART },
+    { "usart", SHELL_PERIPH_USART },
+};
+
+/* Hashed name index ---------------------------------------------------------*/
+struct PeriphIndex {
+    uint16_t slot[1u << periphIndexBits];       /* table index + 1, 0 when empty */
+};
+
+/* same probing as Shell_HashIndexBuild(), done by the compiler */
+constexpr PeriphIndex buildIndex()
+{
+    PeriphIndex index = {};
+    constexpr uint32_t mask = (1u << periphIndexBits) - 1u;
+
+    for (size_t i = 0; i < periphCount; i++)
+    {
+        uint32_t slot = (periphTable[i].nameHash * 0x9E3779B1u) >> (32u - periphIndexBits);
+
+        while (SHELL_HASH_EMPTY != index.slot[slot])
+        {
+            slot = (slot + 1u) & mask;
+        }
+        index.slot[slot] = static_cast<uint16_t>(i + 1u);
+    }
+    return index;
+}
+
+constexpr bool namesUnique()
+{
+    for (size_t i = 0; i < periphCount; i++)
+    {
+        for (size_t k = i + 1; k < periphCount; k++)
+        {
+            if (sameName(periphTable[i].name, periphTable[k].name))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* position of every descriptor among the instances of its type */
+struct PeriphUnits {
+    uint8_t unit[periphCount];
+};
+
+constexpr PeriphUnits buildUnits()
+{
+    PeriphUnits units = {};
+    uint8_t next[SHELL_PERIPH_NONE] = {};
+
+    for (size_t i = 0; i < periphCount; i++)
+    {
+        units.unit[i] = next[periphTable[i].type]++;
+    }
+    return units;
+}
+
+constexpr size_t countOf(ShellPeriphType_t type)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < periphCount; i++)
+    {
+        count += (type == periphTable[i].type) ? 1u : 0u;
+    }
+    return count;
+}
+
+constexpr PeriphIndex periphIndex = buildIndex();
+constexpr PeriphUnits periphUnits = buildUnits();
+
+static_assert(2u * periphCount <= (1u << periphIndexBits), "peripheral index too small, raise periphIndexBits");
+static_assert(namesUnique(), "duplicate peripheral name");
+static_assert(SHELL_PERIPH_USART_COUNT == countOf(SHELL_PERIPH_USART), "SHELL_PERIPH_USART_COUNT out of date");
+static_assert(SHELL_PERIPH_I2C_COUNT == countOf(SHELL_PERIPH_I2C), "SHELL_PERIPH_I2C_COUNT out of date");
+static_assert(SHELL_PERIPH_SPI_COUNT == countOf(SHELL_PERIPH_SPI), "SHELL_PERIPH_SPI_COUNT out of date");
+static_assert(SHELL_PERIPH_TIM_COUNT == countOf(SHELL_PERIPH_TIM), "SHELL_PERIPH_TIM_COUNT out of date");
+static_assert(foldHash("USART1") == SHELL_NAME_HASH("usart1"), "foldHash out of sync with shell_hash.h");
+
+/**
+  * @brief  look up a lower case instance name in the hashed index
+  * @param name lower case name
+  * @retval descriptor or NULL
+  */
+const ShellPeriph_t *Shell_PeriphLookup(const char *name)
+{
+    int i = Shell_HashIndexFind(periphIndex.slot, periphIndexBits, &periphTable[0].nameHash,
+                                &periphTable[0].name, sizeof(ShellPeriph_t), name);
+
+    return (i < 0) ? NULL : &periphTable[i];
+}
+
+/**
+  * @brief  clock a GPIO port and route a pin group to its alternate function
+  * @param group pins, ignored when unused
+  * @param gpio mode, pull and speed
+  * @retval None
+  */
+void Shell_PeriphRoute(const ShellPeriphPins_t &group, GPIO_InitTypeDef &gpio)
+{
+    if (0 == group.port)
+    {
+        return;
+    }
+
+    // GPIO ports sit 0x400 apart and their AHB1 enable bits follow the same order
+    uint32_t port = (group.port - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE);
+    SET_BIT(RCC->AHB1ENR, RCC_AHB1ENR_GPIOAEN << port);
+    (void)READ_BIT(RCC->AHB1ENR, RCC_AHB1ENR_GPIOAEN << port);
+
+    gpio.Pin = group.pins;
+    gpio.Alternate = group.af;
+    HAL_GPIO_Init(reinterpret_cast<GPIO_TypeDef *>(group.port), &gpio);
+}
+
+} // namespace
+
+/**
+  * @brief  map a peripheral type name (usart, uart, i2c, spi, tim, rtc) to its type
+  * @param name type name, any case
+  * @retval peripheral type or SHELL_PERIPH_NONE
+  */
+extern "C" ShellPeriphType_t Shell_PeriphTypeFind(const char *name)
+{
+    for (const TypeName &entry : typeNames)
+    {
+        size_t i = 0;
+
+        while (('\0' != name[i]) && (foldCase(name[i]) == entry.name[i]))
+        {
+            i++;
+        }
+        if (('\0' == name[i]) && ('\0' == entry.name[i]))
+        {
+            return entry.type;
+        }
+    }
+    return SHELL_PERIPH_NONE;
+}
+
+/**
+  * @brief  find a peripheral instance by name
+  * @note   case insensitive; uartN and usartN name the same instance
+  * @param type expected peripheral type
+  * @param name instance name
+  * @retval descriptor or NULL if there is no such instance of that type
+  */
+extern "C" const ShellPeriph_t *Shell_PeriphFind(ShellPeriphType_t type, const char *name)
+{
+    char folded[SHELL_CMD_NAME_MAX + 2];
+    const ShellPeriph_t *periph;
+    size_t len;
+
+    for (len = 0; '\0' != name[len]; len++)
+    {
+        if (len >= SHELL_CMD_NAME_MAX)
+        {
+            return NULL;
+        }
+        folded[len] = foldCase(name[len]);
+    }
+    folded[len] = '\0';
+
+    periph = Shell_PeriphLookup(folded);
+
+    if ((NULL == periph) && (SHELL_PERIPH_USART == type))
+    {
+        if (0 == strncmp(folded, "usart", 5))
+        {
+            // usart4 -> uart4
+            memmove(&folded[1], &folded[2], len - 1);
+            folded[0] = 'u';
+            periph = Shell_PeriphLookup(folded);
+        }
+        else if (0 == strncmp(folded, "uart", 4))
+        {
+            // uart1 -> usart1
+            memmove(&folded[2], &folded[1], len);
+            folded[1] = 's';
+            periph = Shell_PeriphLookup(folded);
+        }
+    }
+
+    return ((NULL != periph) && (type == periph->type)) ? periph : NULL;
+}
+
+/**
+  * @brief  find the descriptor of a peripheral instance address
+  * @param base peripheral base address, e.g. huart->Instance
+  * @retval descriptor or NULL
+  */
+extern "C" const ShellPeriph_t *Shell_PeriphFromBase(uintptr_t base)
+{
+    for (const ShellPeriph_t &periph : periphTable)
+    {
+        if (base == periph.base)
+        {
+            return &periph;
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @brief  walk the descriptor table
+  * @param index table position
+  * @retval descriptor or NULL past the end
+  */
+extern "C" const ShellPeriph_t *Shell_PeriphAt(size_t index)
+{
+    return (index < periphCount) ? &periphTable[index] : NULL;
+}
+
+/**
+  * @brief  index of a peripheral among the instances of its type
+  * @note   usart1 is 0 and uart4 is 3; sizes per type are SHELL_PERIPH_*_COUNT
+  * @param periph peripheral descriptor
+  * @retval unit index
+  */
+extern "C" unsigned Shell_PeriphUnit(const ShellPeriph_t *periph)
+{
+    return periphUnits.unit[periph - periphTable];
+}
+
+/**
+  * @brief  bring a peripheral up: clock enable and pin alternate functions
+  * @param periph peripheral descriptor
+  * @retval None
+  */
+extern "C" void Shell_PeriphEnable(const ShellPeriph_t *periph)
+{
+    volatile uint32_t *enr = reinterpret_cast<volatile uint32_t *>(periph->rccEnr);
+    GPIO_InitTypeDef gpio = {};
+
+    SET_BIT(*enr, periph->rccMask);
+    // Delay after an RCC peripheral clock enabling
+    (void)READ_BIT(*enr, periph->rccMask);
+
+    gpio.Mode = (SHELL_PERIPH_I2C == periph->type) ? GPIO_MODE_AF_OD : GPIO_MODE_AF_PP;
+    gpio.Pull = (SHELL_PERIPH_USART == periph->type) ? GPIO_PULLUP : GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+
+    for (const ShellPeriphPins_t &group : periph->pins)
+    {
+        Shell_PeriphRoute(group, gpio);
+    }
+}
+
+/**
+  * @brief  route the RTS and/or CTS pins of a USART
+  * @note   CTS is pulled up, so an unconnected input holds the transmitter off
+  * @param periph USART descriptor
+  * @param hwFlowCtl UART_HWCONTROL_NONE, _RTS, _CTS or _RTS_CTS
+  * @retval false if the USART has no pin for a signal asked for
+  */
+extern "C" bool Shell_PeriphEnableFlow(const ShellPeriph_t *periph, uint32_t hwFlowCtl)
+{
+    bool cts = (0u != (hwFlowCtl & UART_HWCONTROL_CTS));
+    bool rts = (0u != (hwFlowCtl & UART_HWCONTROL_RTS));
+    GPIO_InitTypeDef gpio = {};
+
+    if ((cts && (0 == periph->cts.port)) || (rts && (0 == periph->rts.port)))
+    {
+        return false;
+    }
+
+    gpio.Mode = GPIO_MODE_AF_PP;
+    gpio.Pull = GPIO_PULLUP;
+    gpio.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+
+    if (cts)
+    {
+        Shell_PeriphRoute(periph->cts, gpio);
+    }
+    if (rts)
+    {
+        Shell_PeriphRoute(periph->rts, gpio);
+    }
+    return true;
+}
@@ -0,0 +1,75 @@
+#ifndef __SHELL_PERIPH_H__
+#define __SHELL_PERIPH_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stm32f4xx_hal.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Peripheral descriptors for the init command. The table is generated at
+ * compile time in shell_periph.cpp (C++ constexpr) together with its hashed
+ * name index, so it lives in flash and lookups cost one hash and a strcmp.
+ * Addresses are kept as integers because constexpr cannot cast them.
+ */
+typedef enum {
+    SHELL_PERIPH_USART = 0,
+    SHELL_PERIPH_I2C,
+    SHELL_PERIPH_SPI,
+    SHELL_PERIPH_TIM,
+    SHELL_PERIPH_RTC,
+    SHELL_PERIPH_NONE
+} ShellPeriphType_t;
+
+#define SHELL_PERIPH_PIN_GROUPS 2       /* Ports a peripheral spreads its pins over */
+
+/* Instances per type in the descriptor table, checked at compile time */
+#define SHELL_PERIPH_USART_COUNT 6
+#define SHELL_PERIPH_I2C_COUNT 3
+#define SHELL_PERIPH_SPI_COUNT 3
+#define SHELL_PERIPH_TIM_COUNT 14
+
+typedef struct {
+    uintptr_t port;                     /* GPIOx base, 0 for an unused group */
+    uint16_t pins;                      /* GPIO_PIN_x mask */
+    uint8_t af;                         /* GPIO_AFx_... */
+} ShellPeriphPins_t;
+
+typedef struct {
+    uintptr_t stream;                   /* DMAx_Streamy base, 0 if there is no request */
+    uint32_t channel;                   /* DMA_CHANNEL_x */
+} ShellPeriphDma_t;
+
+typedef struct {
+    const char *name;                   /* Lower case instance name */
+    uint32_t nameHash;                  /* SHELL_NAME_HASH of name */
+    ShellPeriphType_t type;
+    uintptr_t base;                     /* Peripheral base address */
+    uintptr_t rccEnr;                   /* Address of the RCC clock enable register */
+    uint32_t rccMask;                   /* Enable bit in that register */
+    IRQn_Type irq;                      /* Global or event interrupt */
+    ShellPeriphDma_t dmaRx;             /* RX request, update request for timers */
+    ShellPeriphDma_t dmaTx;             /* TX request */
+    ShellPeriphPins_t pins[SHELL_PERIPH_PIN_GROUPS];
+    ShellPeriphPins_t cts;              /* USART flow control input, unused group if there is none */
+    ShellPeriphPins_t rts;              /* USART flow control output */
+} ShellPeriph_t;
+
+/* API prototypes */
+ShellPeriphType_t Shell_PeriphTypeFind(const char *name);
+const ShellPeriph_t *Shell_PeriphFind(ShellPeriphType_t type, const char *name);
+const ShellPeriph_t *Shell_PeriphFromBase(uintptr_t base);
+const ShellPeriph_t *Shell_PeriphAt(size_t index);
+unsigned Shell_PeriphUnit(const ShellPeriph_t *periph);
+void Shell_PeriphEnable(const ShellPeriph_t *periph);
+bool Shell_PeriphEnableFlow(const ShellPeriph_t *periph, uint32_t hwFlowCtl);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_PERIPH_H__ */
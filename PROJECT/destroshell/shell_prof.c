@@ -0,0 +1,284 @@
+#include <shell_prof.h>
+#include <shell_bus.h>
+#include <shell_opt.h>
+
+typedef struct {
+    uint32_t rate;
+} ProfOptions_t;
+
+/* Private variables ----------------------------------------------------------*/
+static TIM_HandleTypeDef htim7;
+static ShellProfSlot_t *profTable;      /* Allocated by the first prof start */
+static volatile uint32_t profSamples;
+static volatile uint32_t profDropped;
+static uint32_t profRate;
+static bool profRunning;
+
+static const ShellOpt_t profOptionTable[] = {
+    SHELL_OPTION_INT("-rate", ProfOptions_t, rate, 100, 50000, 10000),
+};
+static const ShellWords_t profOptions = SHELL_OPTIONS(profOptionTable);
+
+static const ShellWord_t profWords[] = {
+    { "clear", NULL, 0 },
+    { "dump",  NULL, 0 },
+    { "start", &profOptions, 0 },
+    { "stop",  NULL, 0 },
+};
+static const ShellWords_t profArgs = SHELL_WORDS(profWords, 0);
+
+/* Private function prototypes -----------------------------------------------*/
+void Shell_ProfSample(const uint32_t *frame) __attribute__((used));
+
+/**
+  * @brief  TIM7 interrupt, hands the stacked exception frame to Shell_ProfSample
+  * @note   naked so nothing is pushed before the frame is located; bit 2 of
+  *         EXC_RETURN tells whether the interrupted context ran on PSP (a task)
+  *         or on MSP (an interrupt or the scheduler start up). The PC sits at
+  *         the same offset in the basic and the FPU frame.
+  * @retval None
+  */
+__attribute__((naked)) void TIM7_IRQHandler(void)
+{
+    __asm volatile (
+        "tst   lr, #4            \n"
+        "ite   eq                \n"
+        "mrseq r0, msp           \n"
+        "mrsne r0, psp           \n"
+        "b     Shell_ProfSample  \n"
+    );
+}
+
+/**
+  * @brief  count the PC of the interrupted context
+  * @note   runs above configMAX_SYSCALL_INTERRUPT_PRIORITY, so no kernel calls
+  * @param frame exception frame: r0-r3, r12, lr, pc, xpsr
+  * @retval None
+  */
+void Shell_ProfSample(const uint32_t *frame)
+{
+    uint32_t pc = frame[6];
+    uint32_t slot = ((pc >> 1) * 2654435761u) >> (32u - SHELL_PROF_BITS);
+
+    // cleared first, the write needs a few cycles to reach the timer
+    TIM7->SR = ~(uint32_t)TIM_SR_UIF;
+    profSamples++;
+
+    for (uint32_t probe = 0; probe < SHELL_PROF_PROBES; probe++)
+    {
+        ShellProfSlot_t *entry = &profTable[(slot + probe) & ((1u << SHELL_PROF_BITS) - 1u)];
+
+        if (pc == entry->pc)
+        {
+            entry->hits++;
+            return;
+        }
+        if (0 == entry->hits)
+        {
+            entry->pc = pc;
+            entry->hits = 1;
+            return;
+        }
+    }
+    profDropped++;
+}
+
+/**
+  * @brief  claim TIM7 so init cannot reconfigure it under the profiler
+  * @retval None
+  */
+void Shell_ProfInit(void)
+{
+    htim7.Instance = TIM7;
+    Shell_BusReserveTim(&htim7);
+}
+
+/**
+  * @brief  start sampling
+  * @note   same clock set up as the TIM6 timebase: 1 MHz counter, the
+  *         period sets the rate
+  * @param rate samples per second
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef Shell_ProfStart(uint32_t rate)
+{
+    RCC_ClkInitTypeDef clkconfig;
+    uint32_t timclock;
+    uint32_t latency;
+    HAL_StatusTypeDef status;
+
+    __HAL_RCC_TIM7_CLK_ENABLE();
+
+    HAL_RCC_GetClockConfig(&clkconfig, &latency);
+    if (RCC_HCLK_DIV1 == clkconfig.APB1CLKDivider)
+    {
+        timclock = HAL_RCC_GetPCLK1Freq();
+    }
+    else
+    {
+        timclock = 2UL * HAL_RCC_GetPCLK1Freq();
+    }
+
+    htim7.Instance = TIM7;
+    htim7.Init.Prescaler = (timclock / SHELL_PROF_TIMER_HZ) - 1U;
+    htim7.Init.Period = (SHELL_PROF_TIMER_HZ / rate) - 1U;
+    htim7.Init.ClockDivision = 0;
+    htim7.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim7.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+
+    status = HAL_TIM_Base_Init(&htim7);
+    if (HAL_OK != status)
+    {
+        return status;
+    }
+
+    HAL_NVIC_SetPriority(TIM7_IRQn, SHELL_PROF_IRQ_PRIORITY, 0U);
+    HAL_NVIC_EnableIRQ(TIM7_IRQn);
+
+    // the period is whole microseconds, report the rate actually used
+    profRate = SHELL_PROF_TIMER_HZ / (htim7.Init.Period + 1U);
+    return HAL_TIM_Base_Start_IT(&htim7);
+}
+
+/**
+  * @brief  stop sampling, the table is kept
+  * @retval None
+  */
+static void Shell_ProfStop(void)
+{
+    if (!profRunning)
+    {
+        return;
+    }
+    HAL_TIM_Base_Stop_IT(&htim7);
+    HAL_NVIC_DisableIRQ(TIM7_IRQn);
+    profRunning = false;
+}
+
+/**
+  * @brief  send the table in binary, see ShellProfHeader_t
+  * @param handle shell handle
+  * @retval None
+  */
+static void Shell_ProfDump(Shell_Handle_t *handle)
+{
+    ShellProfHeader_t header = { SHELL_PROF_MAGIC, profRate, profSamples, profDropped, 0 };
+
+    for (uint32_t i = 0; i < (1u << SHELL_PROF_BITS); i++)
+    {
+        header.count += (0 != profTable[i].hits) ? 1u : 0u;
+    }
+
+    sh_write(handle, (const uint8_t *)&header, sizeof(header));
+    for (uint32_t i = 0; i < (1u << SHELL_PROF_BITS); i++)
+    {
+        if (0 != profTable[i].hits)
+        {
+            sh_write(handle, (const uint8_t *)&profTable[i], sizeof(ShellProfSlot_t));
+        }
+    }
+}
+
+/**
+  * @brief  prof subcommands, with the profiler locked
+  * @param handle shell handle
+  * @param argc argument count
+  * @param argv argument vector
+  * @retval None
+  */
+static void Shell_ProfCommand(Shell_Handle_t *handle, int argc, char *argv[])
+{
+    const char *action = (argc > 1) ? argv[1] : "";
+    char buf[96];
+
+    if (NULL == profTable)
+    {
+        profTable = pvPortMalloc((1u << SHELL_PROF_BITS) * sizeof(ShellProfSlot_t));
+        if (NULL == profTable)
+        {
+            sh_print(handle, "Failed to allocate memory for the profile\r\n");
+            return;
+        }
+        memset(profTable, 0, (1u << SHELL_PROF_BITS) * sizeof(ShellProfSlot_t));
+    }
+
+    if (0 == strcmp(action, "start"))
+    {
+        ProfOptions_t opt;
+
+        if (!Shell_ParseOptions(handle, &profOptions, argc - 2, &argv[2], &opt))
+        {
+            return;
+        }
+        if (profRunning)
+        {
+            sh_print(handle, "Profiler already running\r\n");
+            return;
+        }
+        if (HAL_OK != Shell_ProfStart(opt.rate))
+        {
+            sh_print(handle, "Failed to start TIM7\r\n");
+            return;
+        }
+        profRunning = true;
+        snprintf(buf, sizeof(buf), "Sampling at %lu Hz\r\n", (unsigned long)profRate);
+        sh_print(handle, buf);
+    }
+    else if (0 == strcmp(action, "stop"))
+    {
+        Shell_ProfStop();
+        sh_print(handle, "Profiler stopped\r\n");
+    }
+    else if (0 == strcmp(action, "clear"))
+    {
+        // the handler must not run between the counters and the table
+        HAL_NVIC_DisableIRQ(TIM7_IRQn);
+        memset(profTable, 0, (1u << SHELL_PROF_BITS) * sizeof(ShellProfSlot_t));
+        profSamples = 0;
+        profDropped = 0;
+        if (profRunning)
+        {
+            HAL_NVIC_EnableIRQ(TIM7_IRQn);
+        }
+        sh_print(handle, "Profile cleared\r\n");
+    }
+    else if (0 == strcmp(action, "dump"))
+    {
+        // a consistent snapshot, and the dump itself stays out of the profile
+        Shell_ProfStop();
+        Shell_ProfDump(handle);
+    }
+    else if (1 == argc)
+    {
+        uint32_t used = 0;
+
+        for (uint32_t i = 0; i < (1u << SHELL_PROF_BITS); i++)
+        {
+            used += (0 != profTable[i].hits) ? 1u : 0u;
+        }
+        snprintf(buf, sizeof(buf), "Profiler %s, %lu Hz, %lu samples, %lu/%lu PCs, %lu dropped\r\n",
+                 profRunning ? "running" : "stopped", (unsigned long)profRate,
+                 (unsigned long)profSamples, (unsigned long)used,
+                 (unsigned long)(1u << SHELL_PROF_BITS), (unsigned long)profDropped);
+        sh_print(handle, buf);
+    }
+    else
+    {
+        sh_print(handle, "Usage: prof | prof start [-rate <hz>] | prof stop | prof clear | prof dump\r\n");
+    }
+}
+
+/**
+  * @brief  PC sampling profiler
+  * @param handle shell handle
+  * @param argc argument count
+  * @param argv argument vector
+  * @retval None
+  */
+void shell_cmd_prof(Shell_Handle_t *handle, int argc, char *argv[])
+{
+    Shell_Lock(SHELL_LOCK_PROF);
+    Shell_ProfCommand(handle, argc, argv);
+    Shell_Unlock(SHELL_LOCK_PROF);
+}
+SHELL_COMMAND_ARGS(prof, "Sample the program counter", "prof | prof start [-rate <hz>] | prof stop | prof clear | prof dump", shell_cmd_prof, &profArgs);
@@ -0,0 +1,49 @@
+#ifndef __SHELL_PROF_H__
+#define __SHELL_PROF_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <destroshell.h>
+
+/*
+ * Sampling PC profiler. TIM7 interrupts at a fixed rate above
+ * configMAX_SYSCALL_INTERRUPT_PRIORITY, so it also lands inside critical
+ * sections and kernel interrupts; the handler reads the PC stacked by the
+ * interrupted context and counts it in an open addressing hash table.
+ * "prof dump" sends the table in binary for tools/prof_symbolize.py.
+ */
+
+/* Configuration constants */
+#define SHELL_PROF_BITS 9               /* Hash table of 2^bits distinct PCs */
+#define SHELL_PROF_PROBES 8             /* Slots tried before a sample is dropped */
+#define SHELL_PROF_IRQ_PRIORITY 2       /* Must stay below configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY */
+#define SHELL_PROF_TIMER_HZ 1000000u    /* TIM7 counter clock, as the TIM6 timebase */
+#define SHELL_PROF_MAGIC 0x31465250u    /* "PRF1" on the wire */
+
+/*
+ * Dump format, little endian: one header followed by header.count slots in
+ * table order, empty slots skipped.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t rate;                      /* Samples per second */
+    uint32_t samples;                   /* Every interrupt taken, dropped ones included */
+    uint32_t dropped;                   /* Samples that found no free slot */
+    uint32_t count;                     /* Slots that follow */
+} ShellProfHeader_t;
+
+typedef struct {
+    uint32_t pc;
+    uint32_t hits;
+} ShellProfSlot_t;
+
+/* API prototypes */
+void Shell_ProfInit(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_PROF_H__ */
@@ -0,0 +1,520 @@
+#include <shell_rpc.h>
+#include <shell_complete.h>
+
+/* Configuration constants */
+#define RPC_HEADER 3                    /* seq u16, op or status u8 */
+#define RPC_CRC 2
+#define RPC_WIRE_MAX (SHELL_RPC_PAYLOAD_MAX + SHELL_RPC_PAYLOAD_MAX / 254 + 3)
+#define RPC_DISCARD UINT16_MAX          /* bufferIndex of a frame too long for cmdBuffer */
+
+/* Private variables ----------------------------------------------------------*/
+static uint8_t rpcPayload[SHELL_RPC_PAYLOAD_MAX] __attribute__((section(".ccmbss")));
+static uint8_t rpcWire[RPC_WIRE_MAX] __attribute__((section(".ccmbss")));
+static SemaphoreHandle_t rpcLock = NULL;    /* Response buffers, shared by the sessions */
+
+/* CRC-16/CCITT-FALSE, poly 0x1021 MSB first, one nibble per lookup */
+static const uint16_t rpcCrcNibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+/**
+  * @brief  CRC-16/CCITT-FALSE of a block
+  * @param data bytes
+  * @param len number of bytes
+  * @retval CRC, 0x29B1 for "123456789"
+  */
+static uint16_t Shell_RpcCrc(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        crc = (uint16_t)((crc << 4) ^ rpcCrcNibble[(crc >> 12) ^ (data[i] >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ rpcCrcNibble[(crc >> 12) ^ (data[i] & 0x0F)]);
+    }
+    return crc;
+}
+
+/**
+  * @brief  COBS encode a block, no delimiters added
+  * @param src bytes to encode
+  * @param len number of bytes
+  * @param dst output, at least len + len / 254 + 1 bytes
+  * @retval encoded length
+  */
+static size_t Shell_CobsEncode(const uint8_t *src, size_t len, uint8_t *dst)
+{
+    size_t code = 0;                    // where the length byte of the current block goes
+    size_t out = 1;
+    uint8_t run = 1;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (0 != src[i])
+        {
+            dst[out++] = src[i];
+            run++;
+        }
+
+        if ((0 == src[i]) || (0xFF == run))
+        {
+            dst[code] = run;
+            code = out++;
+            run = 1;
+        }
+    }
+    dst[code] = run;
+    return out;
+}
+
+/**
+  * @brief  COBS decode a block in place
+  * @param data encoded bytes without delimiters, replaced by the decoded ones
+  * @param len number of encoded bytes
+  * @retval decoded length, 0 if the encoding is broken
+  */
+static size_t Shell_CobsDecode(uint8_t *data, size_t len)
+{
+    size_t in = 0;
+    size_t out = 0;
+
+    // the output never overtakes the input, a block shrinks by its length byte
+    while (in < len)
+    {
+        uint8_t code = data[in++];
+
+        if ((0 == code) || (in + code - 1 > len))
+        {
+            return 0;
+        }
+        for (uint8_t i = 1; i < code; i++)
+        {
+            data[out++] = data[in++];
+        }
+        if ((0xFF != code) && (in < len))
+        {
+            data[out++] = 0;
+        }
+    }
+    return out;
+}
+
+/**
+  * @brief  seal the response in rpcPayload and send it as one frame
+  * @param handle shell handle
+  * @param seq sequence number of the request
+  * @param status SHELL_RPC_OK or an error
+  * @param len payload length, header included
+  * @retval None
+  */
+static void Shell_RpcReply(Shell_Handle_t *handle, uint16_t seq, uint8_t status, size_t len)
+{
+    rpcPayload[0] = (uint8_t)seq;
+    rpcPayload[1] = (uint8_t)(seq >> 8);
+    rpcPayload[2] = status;
+
+    uint16_t crc = Shell_RpcCrc(rpcPayload, len);
+    rpcPayload[len++] = (uint8_t)crc;
+    rpcPayload[len++] = (uint8_t)(crc >> 8);
+
+    rpcWire[0] = 0;
+    size_t wire = 1 + Shell_CobsEncode(rpcPayload, len, &rpcWire[1]);
+    rpcWire[wire++] = 0;
+    sh_write(handle, rpcWire, wire);
+}
+
+/**
+  * @brief  run the command line of a CALL, its values go to the response
+  * @param handle shell handle
+  * @param line command line, modified in place
+  * @param out response being built
+  * @retval response status
+  */
+static uint8_t Shell_RpcCall(Shell_Handle_t *handle, char *line, ShellRpcOut_t *out)
+{
+    int argc;
+    char *argv[SHELL_MAX_ARGS];
+    uint8_t status = SHELL_RPC_OK;
+
+    // set before parsing so an "Ambiguous" report lands in the response too
+    handle->rpcOut = out;
+
+    Shell_ParseArgs(line, &argc, argv);
+    if ((0 == argc) || !Shell_ExpandArgs(handle, argc, argv))
+    {
+        status = SHELL_RPC_ERR_ARGS;
+    }
+    else
+    {
+        const ShellCommand_t *command = Shell_FindCommand(argv[0]);
+
+        if (NULL == command)
+        {
+            status = SHELL_RPC_ERR_COMMAND;
+        }
+        else
+        {
+            Shell_RunCommand(handle, command, argc, argv);
+        }
+    }
+
+    handle->rpcOut = NULL;
+    if ((SHELL_RPC_OK == status) && out->overflow)
+    {
+        status = SHELL_RPC_ERR_OVERFLOW;
+    }
+    return status;
+}
+
+/**
+  * @brief  set up what the sessions share, called once by Shell_CoreInit
+  * @retval None
+  */
+void Shell_RpcInit(void)
+{
+    rpcLock = xSemaphoreCreateMutex();
+}
+
+/**
+  * @brief  take one received byte ahead of the line editor
+  * @note   runs in vUartTask. In text mode it watches for SHELL_RPC_ESCAPE,
+  *         whose bytes are held back from the line; in frame mode it collects
+  *         a frame into cmdBuffer and queues it for Shell_Task at the next zero
+  * @param handle shell handle
+  * @param ch received byte
+  * @retval true if the byte was consumed
+  */
+bool Shell_RpcFeed(Shell_Handle_t *handle, uint8_t ch)
+{
+    if (handle->rpcMode)
+    {
+        if (0 != ch)
+        {
+            if (0 == handle->bufferIndex)
+            {
+                handle->cmdBuffer[handle->bufferIndex++] = SHELL_RPC_TAG;
+            }
+            if (handle->bufferIndex < SHELL_MAX_LINE_LEN)
+            {
+                handle->cmdBuffer[handle->bufferIndex++] = ch;
+            }
+            else
+            {
+                handle->bufferIndex = RPC_DISCARD;
+            }
+        }
+        else if (RPC_DISCARD == handle->bufferIndex)
+        {
+            // the tag alone makes Shell_Task answer with a frame error
+            xMessageBufferSend(handle->cmdMessages, handle->cmdBuffer, 1, portMAX_DELAY);
+            handle->bufferIndex = 0;
+        }
+        else if (0 != handle->bufferIndex)
+        {
+            xMessageBufferSend(handle->cmdMessages, handle->cmdBuffer, handle->bufferIndex, portMAX_DELAY);
+            handle->bufferIndex = 0;
+        }
+        return true;
+    }
+
+    if ((uint8_t)SHELL_RPC_ESCAPE[handle->rpcEscape] != ch)
+    {
+        // a broken escape is dropped, the byte may still start a new one
+        handle->rpcEscape = 0;
+        if ((uint8_t)SHELL_RPC_ESCAPE[0] != ch)
+        {
+            return false;
+        }
+    }
+
+    handle->rpcEscape++;
+    if ('\0' == SHELL_RPC_ESCAPE[handle->rpcEscape])
+    {
+        handle->rpcEscape = 0;
+        handle->bufferIndex = 0;
+        handle->rpcMode = true;
+    }
+    return true;
+}
+
+/**
+  * @brief  handle one frame queued by Shell_RpcFeed and send its response
+  * @note   runs in Shell_Task, one frame at a time across sessions
+  * @param handle shell handle
+  * @param frame COBS bytes without delimiters, decoded in place
+  * @param len number of bytes, 0 for a frame too long to receive
+  * @retval None
+  */
+void Shell_RpcFrame(Shell_Handle_t *handle, uint8_t *frame, size_t len)
+{
+    ShellRpcOut_t out = { &rpcPayload[0], RPC_HEADER, sizeof(rpcPayload) - RPC_CRC, 0, false };
+    uint16_t seq = 0;
+    uint8_t status;
+
+    if ((NULL == rpcLock) || (pdPASS != xSemaphoreTake(rpcLock, portMAX_DELAY)))
+    {
+        return;
+    }
+
+    len = Shell_CobsDecode(frame, len);
+    if (len < RPC_HEADER + RPC_CRC)
+    {
+        Shell_RpcReply(handle, 0, SHELL_RPC_ERR_FRAME, RPC_HEADER);
+        xSemaphoreGive(rpcLock);
+        return;
+    }
+
+    seq = (uint16_t)(frame[0] | (frame[1] << 8));
+    len -= RPC_CRC;
+    if (Shell_RpcCrc(frame, len) != (uint16_t)(frame[len] | (frame[len + 1] << 8)))
+    {
+        Shell_RpcReply(handle, seq, SHELL_RPC_ERR_CRC, RPC_HEADER);
+        xSemaphoreGive(rpcLock);
+        return;
+    }
+
+    // the CRC has been read, its first byte terminates the body
+    frame[len] = '\0';
+
+    switch (frame[2])
+    {
+    case SHELL_RPC_OP_CALL:
+        status = Shell_RpcCall(handle, (char *)&frame[RPC_HEADER], &out);
+        break;
+
+    case SHELL_RPC_OP_PING:
+        handle->rpcOut = &out;
+        Shell_RpcBytes(handle, &frame[RPC_HEADER], len - RPC_HEADER);
+        handle->rpcOut = NULL;
+        status = SHELL_RPC_OK;
+        break;
+
+    case SHELL_RPC_OP_EXIT:
+        status = SHELL_RPC_OK;
+        break;
+
+    default:
+        status = SHELL_RPC_ERR_OP;
+        break;
+    }
+
+    Shell_RpcReply(handle, seq, status, out.len);
+    xSemaphoreGive(rpcLock);
+
+    if (SHELL_RPC_OP_EXIT == frame[2])
+    {
+        handle->rpcMode = false;
+        sh_print(handle, "\r\n" SHELL_PROMPT);
+    }
+}
+
+/**
+  * @brief  room for one item in the response of the running CALL
+  * @param handle shell handle
+  * @param type SHELL_RPC_U8 ... SHELL_RPC_LIST
+  * @param len value bytes after the type
+  * @retval where the value goes, NULL outside a CALL or when it does not fit
+  */
+static uint8_t *Shell_RpcItem(Shell_Handle_t *handle, uint8_t type, size_t len)
+{
+    ShellRpcOut_t *out = handle->rpcOut;
+
+    if ((NULL == out) || out->overflow)
+    {
+        return NULL;
+    }
+
+    // a typed value ends the text run before it
+    out->text = 0;
+    if (out->len + 1u + len > out->size)
+    {
+        out->overflow = true;
+        return NULL;
+    }
+
+    out->data[out->len] = type;
+    uint8_t *value = &out->data[out->len + 1];
+    out->len += (uint16_t)(1 + len);
+    return value;
+}
+
+/**
+  * @brief  store an integer little endian
+  * @param dst destination
+  * @param value integer
+  * @param len number of bytes
+  * @retval None
+  */
+static void Shell_RpcPut(uint8_t *dst, uint64_t value, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        dst[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+/**
+  * @brief  append printed output to the response, called by sh_write during a CALL
+  * @note   consecutive writes grow one STR item
+  * @param handle shell handle
+  * @param data bytes printed
+  * @param len number of bytes
+  * @retval None
+  */
+void Shell_RpcText(Shell_Handle_t *handle, const uint8_t *data, size_t len)
+{
+    ShellRpcOut_t *out = handle->rpcOut;
+
+    if ((NULL == out) || out->overflow)
+    {
+        return;
+    }
+
+    if (0 == out->text)
+    {
+        uint8_t *item = Shell_RpcItem(handle, SHELL_RPC_STR, 2);
+        if (NULL == item)
+        {
+            return;
+        }
+        Shell_RpcPut(item, 0, 2);
+        out->text = (uint16_t)(item - out->data);
+    }
+
+    size_t room = out->size - out->len;
+    if (len > room)
+    {
+        len = room;
+        out->overflow = true;
+    }
+
+    memcpy(&out->data[out->len], data, len);
+    out->len += (uint16_t)len;
+    uint16_t total = (uint16_t)(out->data[out->text] | (out->data[out->text + 1] << 8)) + (uint16_t)len;
+    Shell_RpcPut(&out->data[out->text], total, 2);
+}
+
+/**
+  * @brief  emit an unsigned 8 bit value
+  * @param handle shell handle
+  * @param value value
+  * @retval None
+  */
+void Shell_RpcU8(Shell_Handle_t *handle, uint8_t value)
+{
+    uint8_t *item = Shell_RpcItem(handle, SHELL_RPC_U8, 1);
+    if (NULL != item)
+    {
+        Shell_RpcPut(item, value, 1);
+    }
+}
+
+/**
+  * @brief  emit an unsigned 16 bit value
+  * @param handle shell handle
+  * @param value value
+  * @retval None
+  */
+void Shell_RpcU16(Shell_Handle_t *handle, uint16_t value)
+{
+    uint8_t *item = Shell_RpcItem(handle, SHELL_RPC_U16, 2);
+    if (NULL != item)
+    {
+        Shell_RpcPut(item, value, 2);
+    }
+}
+
+/**
+  * @brief  emit an unsigned 32 bit value
+  * @param handle shell handle
+  * @param value value
+  * @retval None
+  */
+void Shell_RpcU32(Shell_Handle_t *handle, uint32_t value)
+{
+    uint8_t *item = Shell_RpcItem(handle, SHELL_RPC_U32, 4);
+    if (NULL != item)
+    {
+        Shell_RpcPut(item, value, 4);
+    }
+}
+
+/**
+  * @brief  emit a signed 32 bit value
+  * @param handle shell handle
+  * @param value value
+  * @retval None
+  */
+void Shell_RpcI32(Shell_Handle_t *handle, int32_t value)
+{
+    uint8_t *item = Shell_RpcItem(handle, SHELL_RPC_I32, 4);
+    if (NULL != item)
+    {
+        Shell_RpcPut(item, (uint32_t)value, 4);
+    }
+}
+
+/**
+  * @brief  emit an unsigned 64 bit value
+  * @param handle shell handle
+  * @param value value
+  * @retval None
+  */
+void Shell_RpcU64(Shell_Handle_t *handle, uint64_t value)
+{
+    uint8_t *item = Shell_RpcItem(handle, SHELL_RPC_U64, 8);
+    if (NULL != item)
+    {
+        Shell_RpcPut(item, value, 8);
+    }
+}
+
+/**
+  * @brief  emit a string
+  * @param handle shell handle
+  * @param str NUL terminated string, the terminator is not sent
+  * @retval None
+  */
+void Shell_RpcStr(Shell_Handle_t *handle, const char *str)
+{
+    size_t len = strlen(str);
+    uint8_t *item = Shell_RpcItem(handle, SHELL_RPC_STR, 2 + len);
+    if (NULL != item)
+    {
+        Shell_RpcPut(item, len, 2);
+        memcpy(&item[2], str, len);
+    }
+}
+
+/**
+  * @brief  emit raw bytes
+  * @param handle shell handle
+  * @param data bytes
+  * @param len number of bytes
+  * @retval None
+  */
+void Shell_RpcBytes(Shell_Handle_t *handle, const uint8_t *data, size_t len)
+{
+    uint8_t *item = Shell_RpcItem(handle, SHELL_RPC_BYTES, 2 + len);
+    if (NULL != item)
+    {
+        Shell_RpcPut(item, len, 2);
+        memcpy(&item[2], data, len);
+    }
+}
+
+/**
+  * @brief  open a list, the next count items are its elements
+  * @param handle shell handle
+  * @param count number of elements, lists nest
+  * @retval None
+  */
+void Shell_RpcList(Shell_Handle_t *handle, uint16_t count)
+{
+    uint8_t *item = Shell_RpcItem(handle, SHELL_RPC_LIST, 2);
+    if (NULL != item)
+    {
+        Shell_RpcPut(item, count, 2);
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef __SHELL_RPC_H__
+#define __SHELL_RPC_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <destroshell.h>
+
+/*
+ * Framed binary mode for test rigs. SHELL_RPC_ESCAPE switches a session
+ * from the line editor to frames; the EXIT op switches it back. A frame is
+ * COBS encoded and delimited by 0x00 on both sides, so a receiver that
+ * joins mid stream resynchronizes at the next zero and stray text is a
+ * frame that fails its CRC.
+ *
+ *   request   seq u16 | op u8 | body        | crc u16
+ *   response  seq u16 | status u8 | values  | crc u16
+ *
+ * Integers are little endian, the CRC is CRC-16/CCITT-FALSE over everything
+ * before it. A response carries the seq of its request. CALL runs a command
+ * line from the same table as the text shell; values are typed items the
+ * handler emits with Shell_Rpc*() (see Shell_RpcActive), and whatever it
+ * prints meanwhile arrives as STR items.
+ */
+
+/* Configuration constants */
+#define SHELL_RPC_ESCAPE "\x1b\x02RPC"  /* ESC STX "RPC", typed in text mode */
+#define SHELL_RPC_PAYLOAD_MAX 1024      /* Response bytes before encoding, header and CRC included */
+#define SHELL_RPC_TAG 0x01              /* First byte of a frame on cmdMessages, never starts a text line */
+
+/* Request ops */
+#define SHELL_RPC_OP_CALL 1             /* Body is a command line */
+#define SHELL_RPC_OP_PING 2             /* Body comes back as one BYTES item */
+#define SHELL_RPC_OP_EXIT 3             /* Back to text mode after the response */
+
+/* Response status */
+#define SHELL_RPC_OK 0
+#define SHELL_RPC_ERR_CRC 1
+#define SHELL_RPC_ERR_FRAME 2           /* Bad COBS, too short or too long */
+#define SHELL_RPC_ERR_OP 3
+#define SHELL_RPC_ERR_COMMAND 4         /* Unknown command */
+#define SHELL_RPC_ERR_OVERFLOW 5        /* Values did not fit, the payload stops at the last whole item;
+                                           captured text is kept up to the limit, its STR may be cut short */
+#define SHELL_RPC_ERR_ARGS 6            /* Empty or ambiguous command line */
+
+/* Value types, each item is its type byte followed by the value */
+#define SHELL_RPC_U8 1
+#define SHELL_RPC_U16 2
+#define SHELL_RPC_U32 3
+#define SHELL_RPC_I32 4
+#define SHELL_RPC_U64 5
+#define SHELL_RPC_STR 6                 /* u16 length, then the bytes */
+#define SHELL_RPC_BYTES 7               /* u16 length, then the bytes */
+#define SHELL_RPC_LIST 8                /* u16 count, then that many items */
+
+/* Response being built by a CALL */
+struct ShellRpcOut {
+    uint8_t *data;
+    uint16_t len;
+    uint16_t size;                      /* Room for items, the CRC excluded */
+    uint16_t text;                      /* Offset of the length of the open STR item, 0 for none */
+    bool overflow;
+};
+typedef struct ShellRpcOut ShellRpcOut_t;
+
+/**
+  * @brief  tell a command handler to emit typed values instead of text
+  * @param handle shell handle passed to the handler
+  * @retval true while the handler runs for a CALL frame
+  */
+static inline bool Shell_RpcActive(const Shell_Handle_t *handle)
+{
+    return (NULL != handle->rpcOut);
+}
+
+/* API prototypes */
+void Shell_RpcInit(void);
+bool Shell_RpcFeed(Shell_Handle_t *handle, uint8_t ch);
+void Shell_RpcFrame(Shell_Handle_t *handle, uint8_t *frame, size_t len);
+void Shell_RpcText(Shell_Handle_t *handle, const uint8_t *data, size_t len);
+void Shell_RpcU8(Shell_Handle_t *handle, uint8_t value);
+void Shell_RpcU16(Shell_Handle_t *handle, uint16_t value);
+void Shell_RpcU32(Shell_Handle_t *handle, uint32_t value);
+void Shell_RpcI32(Shell_Handle_t *handle, int32_t value);
+void Shell_RpcU64(Shell_Handle_t *handle, uint64_t value);
+void Shell_RpcStr(Shell_Handle_t *handle, const char *str);
+void Shell_RpcBytes(Shell_Handle_t *handle, const uint8_t *data, size_t len);
+void Shell_RpcList(Shell_Handle_t *handle, uint16_t count);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_RPC_H__ */
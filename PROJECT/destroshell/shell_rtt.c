@@ -0,0 +1,172 @@
+#include <shell_rtt.h>
+
+#if ( configUSE_SHELL_RTT == 1 )
+
+#include <SEGGER_RTT.h>
+
+/**
+  * @brief  hand the link buffers to RTT
+  * @param handle shell handle, link is a ShellRttLink_t
+  * @retval true
+  */
+static bool Shell_RttInit(Shell_Handle_t *handle)
+{
+    ShellRttLink_t *link = (ShellRttLink_t *)handle->link;
+
+    memset(&link->stats, 0, sizeof(link->stats));
+    link->detached = false;
+    SEGGER_RTT_ConfigUpBuffer(link->channel, "Terminal", link->up, sizeof(link->up), SEGGER_RTT_MODE_NO_BLOCK_TRIM);
+    SEGGER_RTT_ConfigDownBuffer(link->channel, "Terminal", link->down, sizeof(link->down), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+    return true;
+}
+
+/**
+  * @brief  poll the down buffer once a tick until something arrives
+  * @param handle shell handle
+  * @param data destination
+  * @param len maximum number of bytes
+  * @retval bytes read, at least one
+  */
+static size_t Shell_RttRead(Shell_Handle_t *handle, uint8_t *data, size_t len)
+{
+    ShellRttLink_t *link = (ShellRttLink_t *)handle->link;
+    unsigned count;
+
+    while (0 == (count = SEGGER_RTT_Read(link->channel, data, len)))
+    {
+        vTaskDelay(1);
+    }
+
+    link->stats.rxBytes += count;
+    return count;
+}
+
+/**
+  * @brief  copy bytes into the up buffer, waiting for the debugger while it reads
+  * @param handle shell handle
+  * @param data bytes to send
+  * @param len number of bytes
+  * @retval None
+  */
+static void Shell_RttWrite(Shell_Handle_t *handle, const uint8_t *data, size_t len)
+{
+    ShellRttLink_t *link = (ShellRttLink_t *)handle->link;
+    TickType_t stalled = 0;
+
+    if (link->detached && (0 == SEGGER_RTT_GetBytesInBuffer(link->channel)))
+    {
+        // the debugger caught up
+        link->detached = false;
+    }
+
+    while (len > 0)
+    {
+        unsigned count = SEGGER_RTT_Write(link->channel, data, len);
+
+        link->stats.txBytes += count;
+        data += count;
+        len -= count;
+
+        if ((0 == count) && (0 == stalled))
+        {
+            link->stats.txStalls++;
+        }
+
+        if (0 != count)
+        {
+            stalled = 0;
+        }
+        else if (link->detached || (stalled >= pdMS_TO_TICKS(SHELL_RTT_STALL_TIMEOUT)) ||
+                 (taskSCHEDULER_RUNNING != xTaskGetSchedulerState()))
+        {
+            link->detached = true;
+            link->stats.txDropped += len;
+            break;
+        }
+        else
+        {
+            vTaskDelay(1);
+            stalled++;
+        }
+    }
+}
+
+/**
+  * @brief  wait until the debugger has read the up buffer
+  * @param handle shell handle
+  * @param timeout maximum time to wait in ticks
+  * @retval true if the buffer is empty
+  */
+static bool Shell_RttFlush(Shell_Handle_t *handle, TickType_t timeout)
+{
+    ShellRttLink_t *link = (ShellRttLink_t *)handle->link;
+    TickType_t start = xTaskGetTickCount();
+
+    while ((0 != SEGGER_RTT_GetBytesInBuffer(link->channel)) && !link->detached &&
+           ((xTaskGetTickCount() - start) < timeout))
+    {
+        vTaskDelay(1);
+    }
+
+    return (0 == SEGGER_RTT_GetBytesInBuffer(link->channel));
+}
+
+/**
+  * @brief  write data without locks or RTOS calls, for fault handlers
+  * @note   waits for room for at most SHELL_RTT_STALL_TIMEOUT, counted in core cycles
+  * @param handle shell handle
+  * @param data bytes to send, may be NULL
+  * @param len number of bytes
+  * @retval None
+  */
+static void Shell_RttDrain(Shell_Handle_t *handle, const uint8_t *data, size_t len)
+{
+    ShellRttLink_t *link = (ShellRttLink_t *)handle->link;
+    uint32_t limit = (SystemCoreClock / 1000u) * SHELL_RTT_STALL_TIMEOUT;
+    uint32_t start = DWT->CYCCNT;
+
+    while ((NULL != data) && (len > 0))
+    {
+        unsigned count = SEGGER_RTT_WriteNoLock(link->channel, data, len);
+
+        link->stats.txBytes += count;
+        data += count;
+        len -= count;
+
+        if (0 != count)
+        {
+            start = DWT->CYCCNT;
+        }
+        else if (link->detached || ((DWT->CYCCNT - start) >= limit))
+        {
+            link->detached = true;
+            link->stats.txDropped += len;
+            break;
+        }
+    }
+}
+
+/**
+  * @brief  copy the link counters
+  * @param handle shell handle
+  * @param stats destination
+  * @retval None
+  */
+static void Shell_RttStats(Shell_Handle_t *handle, ShellTransportStats_t *stats)
+{
+    *stats = ((ShellRttLink_t *)handle->link)->stats;
+}
+
+const ShellTransport_t shellRtt = {
+    "rtt",
+    Shell_RttInit,
+    Shell_RttRead,
+    Shell_RttWrite,
+    Shell_RttFlush,
+    Shell_RttDrain,
+    Shell_RttStats,
+    NULL,
+    NULL,
+};
+
+#endif /* configUSE_SHELL_RTT */
@@ -0,0 +1,43 @@
+#ifndef __SHELL_RTT_H__
+#define __SHELL_RTT_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <destroshell.h>
+
+#if ( configUSE_SHELL_RTT == 1 )
+
+/*
+ * SEGGER RTT transport (shellRtt). The shell owns one RTT channel, both
+ * directions, with buffers in the link; the debugger moves the bytes while
+ * the core runs, so no UART pins or interrupts are involved. SystemView
+ * keeps its own channel. The up buffer is in non-blocking trim mode: when
+ * the debugger stops reading, writes wait SHELL_RTT_STALL_TIMEOUT once and
+ * then drop output (txDropped) until the buffer empties again.
+ */
+
+/* Configuration constants */
+#define SHELL_RTT_CHANNEL 0             /* Terminal channel, SystemView uses 1 */
+#define SHELL_RTT_UP_SIZE 4096          /* Target to host */
+#define SHELL_RTT_DOWN_SIZE 256         /* Host to target */
+#define SHELL_RTT_STALL_TIMEOUT 100     /* ms without progress before output is dropped */
+
+typedef struct {
+    unsigned channel;                   /* RTT buffer index */
+    char up[SHELL_RTT_UP_SIZE];
+    char down[SHELL_RTT_DOWN_SIZE];
+    volatile bool detached;             /* Nobody read for SHELL_RTT_STALL_TIMEOUT */
+    ShellTransportStats_t stats;
+} ShellRttLink_t;
+
+extern const ShellTransport_t shellRtt;
+
+#endif /* configUSE_SHELL_RTT */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_RTT_H__ */
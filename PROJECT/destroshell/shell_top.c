@@ -0,0 +1,286 @@
+#include <shell_top.h>
+#include <shell_opt.h>
+
+/*
+ * One snapshot of every task: the kernel's run time counter and the
+ * context switch count kept in the task tag by traceTASK_SWITCHED_OUT
+ * (see FreeRTOSConfig.h).
+ */
+typedef struct {
+    TaskStatus_t *tasks;
+    uint32_t *switches;
+    UBaseType_t count;
+    UBaseType_t size;
+    uint32_t total;                     /* Run time counter when the snapshot was taken */
+} TopSample_t;
+
+typedef struct {
+    uint32_t runTime;                   /* Run time counter delta over the window */
+    uint32_t switches;                  /* Context switches into the task over the window */
+    UBaseType_t index;                  /* Task in the later snapshot */
+} TopRow_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t stream;
+    uint32_t window;
+} TopOptions_t;
+
+/* Exported variables --------------------------------------------------------*/
+void *pvShellTopLastTask = NULL;
+
+/* Private variables ----------------------------------------------------------*/
+static uint32_t cycleLast;              /* CYCCNT at the previous read */
+static uint64_t cycleTotal;             /* CYCCNT extended past its 32-bit wrap */
+
+static const ShellOpt_t topOptionTable[] = {
+    SHELL_OPTION_INT("-count", TopOptions_t, count, 1, 10000, 1),
+    SHELL_OPTION_BOOL("-stream", TopOptions_t, stream, 0),
+    SHELL_OPTION_INT("-window", TopOptions_t, window, 10, 60000, 1000),
+};
+static const ShellWords_t topOptions = SHELL_OPTIONS(topOptionTable);
+
+/**
+  * @brief  start the cycle counter that clocks the run time stats
+  * @note   portCONFIGURE_TIMER_FOR_RUN_TIME_STATS, called by vTaskStartScheduler
+  * @retval None
+  */
+void Shell_TopTimerInit(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    // SystemView shares CYCCNT, so it is never reset
+    cycleLast = DWT->CYCCNT;
+    cycleTotal = 0;
+}
+
+/**
+  * @brief  read the run time counter
+  * @note   portGET_RUN_TIME_COUNTER_VALUE; callable from tasks and interrupts.
+  *         CYCCNT wraps every 2^32 cycles, so it has to be read at least that
+  *         often; the tick hook makes sure of it.
+  * @retval CPU cycles since the scheduler started divided by 2^SHELL_TOP_SHIFT
+  */
+uint32_t Shell_TopCounter(void)
+{
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    uint32_t now = DWT->CYCCNT;
+    uint32_t value;
+
+    cycleTotal += (uint32_t)(now - cycleLast);
+    cycleLast = now;
+    value = (uint32_t)(cycleTotal >> SHELL_TOP_SHIFT);
+
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+    return value;
+}
+
+/**
+  * @brief  allocate room for a snapshot of every task
+  * @param sample snapshot to set up
+  * @retval true on success
+  */
+static bool Shell_TopAlloc(TopSample_t *sample)
+{
+    sample->size = uxTaskGetNumberOfTasks() + SHELL_TOP_SPARE_TASKS;
+    sample->count = 0;
+    sample->tasks = pvPortMalloc(sample->size * sizeof(TaskStatus_t));
+    sample->switches = pvPortMalloc(sample->size * sizeof(uint32_t));
+
+    return (NULL != sample->tasks) && (NULL != sample->switches);
+}
+
+/**
+  * @brief  release a snapshot
+  * @param sample snapshot
+  * @retval None
+  */
+static void Shell_TopFree(TopSample_t *sample)
+{
+    vPortFree(sample->tasks);
+    vPortFree(sample->switches);
+}
+
+/**
+  * @brief  take a snapshot of every task
+  * @note   the scheduler stays suspended until the tags are read, so no task
+  *         can be deleted and freed under the handles just collected
+  * @param sample snapshot
+  * @retval None
+  */
+static void Shell_TopSample(TopSample_t *sample)
+{
+    vTaskSuspendAll();
+    sample->count = uxTaskGetSystemState(sample->tasks, sample->size, NULL);
+    sample->total = Shell_TopCounter();
+    for (UBaseType_t i = 0; i < sample->count; i++)
+    {
+        sample->switches[i] = (uint32_t)(uintptr_t)xTaskGetApplicationTaskTag(sample->tasks[i].xHandle);
+    }
+    xTaskResumeAll();
+}
+
+/**
+  * @brief  state letter of a task, as printed by vTaskList
+  * @param state task state
+  * @retval letter
+  */
+static char Shell_TopState(eTaskState state)
+{
+    static const char letters[] = { 'X', 'R', 'B', 'S', 'D' };
+
+    return (state < sizeof(letters)) ? letters[state] : '?';
+}
+
+/**
+  * @brief  print per task CPU share and context switches between two snapshots
+  * @note   counters are unsigned deltas, so wrapping between snapshots is fine
+  * @param handle shell handle
+  * @param before earlier snapshot
+  * @param after later snapshot
+  * @param rows scratch, one row per task of the later snapshot
+  * @param window length of the window in ms
+  * @retval None
+  */
+static void Shell_TopPrint(Shell_Handle_t *handle, const TopSample_t *before, const TopSample_t *after,
+                           TopRow_t *rows, uint32_t window)
+{
+    uint32_t total = after->total - before->total;
+    TaskHandle_t idle = xTaskGetIdleTaskHandle();
+    uint32_t idleTime = 0;
+    char buf[96];
+
+    if (0 == total)
+    {
+        total = 1;
+    }
+
+    for (UBaseType_t i = 0; i < after->count; i++)
+    {
+        TopRow_t row = { after->tasks[i].ulRunTimeCounter, after->switches[i], i };
+        UBaseType_t pos = i;
+
+        // a task created during the window started from zero
+        for (UBaseType_t k = 0; k < before->count; k++)
+        {
+            if (before->tasks[k].xHandle == after->tasks[i].xHandle)
+            {
+                row.runTime -= before->tasks[k].ulRunTimeCounter;
+                row.switches -= before->switches[k];
+                break;
+            }
+        }
+
+        if (idle == after->tasks[i].xHandle)
+        {
+            idleTime = row.runTime;
+        }
+
+        // insertion sort, busiest task first
+        while ((pos > 0) && (rows[pos - 1].runTime < row.runTime))
+        {
+            rows[pos] = rows[pos - 1];
+            pos--;
+        }
+        rows[pos] = row;
+    }
+
+    // idle is accounted when it is switched out, so it cannot exceed the window; clamp anyway
+    if (idleTime > total)
+    {
+        idleTime = total;
+    }
+
+    uint32_t load = 1000u - (uint32_t)(((uint64_t)idleTime * 1000u) / total);
+    snprintf(buf, sizeof(buf), "top: %lu ms window, load %lu.%lu%%, %lu tasks\r\n",
+             (unsigned long)window, (unsigned long)(load / 10u), (unsigned long)(load % 10u),
+             (unsigned long)after->count);
+    sh_print(handle, buf);
+    sh_print(handle, "Task        State  Prio    CPU%  Switches\r\n");
+
+    for (UBaseType_t n = 0; n < after->count; n++)
+    {
+        UBaseType_t i = rows[n].index;
+        uint32_t share = (uint32_t)(((uint64_t)rows[n].runTime * 1000u) / total);
+
+        snprintf(buf, sizeof(buf), "%-12s%-7c%4lu  %4lu.%lu  %8lu\r\n",
+                 after->tasks[i].pcTaskName,
+                 Shell_TopState(after->tasks[i].eCurrentState),
+                 (unsigned long)after->tasks[i].uxCurrentPriority,
+                 (unsigned long)(share / 10u), (unsigned long)(share % 10u),
+                 (unsigned long)rows[n].switches);
+        sh_print(handle, buf);
+    }
+}
+
+/**
+  * @brief  show per task CPU usage and context switches over a time window
+  * @param handle shell handle
+  * @param argc argument count
+  * @param argv argument vector
+  * @retval None
+  */
+void shell_cmd_top(Shell_Handle_t *handle, int argc, char *argv[])
+{
+    TopOptions_t opt;
+    TopSample_t samples[2] = { { 0 }, { 0 } };
+    TopSample_t *before = &samples[0];
+    TopSample_t *after = &samples[1];
+    TopRow_t *rows = NULL;
+
+    if (!Shell_ParseOptions(handle, &topOptions, argc - 1, &argv[1], &opt))
+    {
+        return;
+    }
+
+    if (Shell_TopAlloc(before) && Shell_TopAlloc(after))
+    {
+        // the snapshots swap roles every window, so either one may be the later
+        UBaseType_t size = (before->size > after->size) ? before->size : after->size;
+        rows = pvPortMalloc(size * sizeof(TopRow_t));
+    }
+
+    if (NULL == rows)
+    {
+        sh_print(handle, "Failed to allocate memory for task information\r\n");
+        Shell_TopFree(before);
+        Shell_TopFree(after);
+        return;
+    }
+
+    if (opt.stream)
+    {
+        sh_print(handle, "Press Enter to stop\r\n");
+    }
+
+    Shell_TopSample(before);
+
+    for (uint32_t n = 0; opt.stream || (n < opt.count); n++)
+    {
+        vTaskDelay(pdMS_TO_TICKS(opt.window));
+        Shell_TopSample(after);
+
+        if (opt.stream)
+        {
+            sh_print(handle, "\033[2J\033[H");
+        }
+        Shell_TopPrint(handle, before, after, rows, opt.window);
+
+        // the newer snapshot is the baseline of the next window
+        TopSample_t *swap = before;
+        before = after;
+        after = swap;
+
+        // a line typed meanwhile ends streaming and runs once top returns
+        if (opt.stream && !xMessageBufferIsEmpty(handle->cmdMessages))
+        {
+            break;
+        }
+    }
+
+    vPortFree(rows);
+    Shell_TopFree(&samples[0]);
+    Shell_TopFree(&samples[1]);
+}
+SHELL_COMMAND_ARGS(top, "Show per task CPU usage", "top [-window <ms>] [-count <n>] [-stream]", shell_cmd_top, &topOptions);
@@ -0,0 +1,22 @@
+#ifndef __SHELL_TOP_H__
+#define __SHELL_TOP_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <destroshell.h>
+
+/* Configuration constants */
+#define SHELL_TOP_SHIFT 4               /* Run time counter ticks every 2^shift CPU cycles */
+#define SHELL_TOP_SPARE_TASKS 4         /* Extra status slots for tasks created while sampling */
+
+/* API prototypes */
+void Shell_TopTimerInit(void);
+uint32_t Shell_TopCounter(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_TOP_H__ */
@@ -0,0 +1,212 @@
+#include <destroshell.h>
+#include <shell_trace.h>
+#include <shell_opt.h>
+
+#if ( configUSE_SHELL_TRACE == 1 )
+
+typedef struct {
+    uint32_t mode;
+} TraceOptions_t;
+
+enum {
+    TRACE_MODE_RING = 0,                /* Keep the newest records */
+    TRACE_MODE_ONCE                     /* Keep the first records, stop when full */
+};
+
+/* Exported variables --------------------------------------------------------*/
+volatile uint32_t ulShellTraceOn = 0;
+
+/* Private variables ----------------------------------------------------------*/
+static ShellTraceRecord_t traceRing[SHELL_TRACE_RECORDS] __attribute__((section(".ccmbss")));
+static volatile uint32_t traceHead;     /* Records claimed since trace start */
+static uint32_t traceMode;
+
+static const ShellWord_t traceModeWords[] = {
+    { "once", NULL, TRACE_MODE_ONCE },
+    { "ring", NULL, TRACE_MODE_RING },
+};
+static const ShellWords_t traceModeValues = SHELL_WORDS(traceModeWords, 0);
+
+static const ShellOpt_t traceOptionTable[] = {
+    SHELL_OPTION_ENUM("-mode", TraceOptions_t, mode, traceModeValues, TRACE_MODE_RING),
+};
+static const ShellWords_t traceOptions = SHELL_OPTIONS(traceOptionTable);
+
+static const ShellWord_t traceWords[] = {
+    { "dump",  NULL, 0 },
+    { "start", &traceOptions, 0 },
+    { "stop",  NULL, 0 },
+};
+static const ShellWords_t traceArgs = SHELL_WORDS(traceWords, 0);
+
+SHELL_STATIC_ASSERT(0 == (SHELL_TRACE_RECORDS & (SHELL_TRACE_RECORDS - 1)), "SHELL_TRACE_RECORDS must be a power of two");
+SHELL_STATIC_ASSERT(8 == sizeof(ShellTraceRecord_t), "trace records are 8 bytes on the wire");
+SHELL_STATIC_ASSERT(configMAX_TASK_NAME_LEN <= sizeof(((ShellTraceTask_t *)0)->name), "task names do not fit the dump");
+
+/**
+  * @brief  append one record
+  * @note   called from kernel hooks and interrupts of any priority; the
+  *         exclusive increment hands every writer its own record, so nothing
+  *         is masked and no writer waits
+  * @param type record type, SHELL_TRACE_*
+  * @param arg 8-bit argument
+  * @param id task number, queue or exception number
+  * @retval None
+  */
+void Shell_TraceRecord(uint32_t type, uint32_t arg, uint32_t id)
+{
+    uint32_t index = __atomic_fetch_add(&traceHead, 1u, __ATOMIC_RELAXED);
+    ShellTraceRecord_t *record;
+
+    if ((TRACE_MODE_ONCE == traceMode) && (index >= SHELL_TRACE_RECORDS))
+    {
+        ulShellTraceOn = 0;
+        return;
+    }
+
+    record = &traceRing[index & (SHELL_TRACE_RECORDS - 1u)];
+    record->time = DWT->CYCCNT;
+    record->type = (uint8_t)type;
+    record->arg = (uint8_t)arg;
+    record->id = (uint16_t)id;
+}
+
+/**
+  * @brief  send the recording in binary, see ShellTraceHeader_t
+  * @note   recording must be stopped
+  * @param handle shell handle
+  * @retval None
+  */
+static void Shell_TraceDump(Shell_Handle_t *handle)
+{
+    uint32_t head = traceHead;
+    uint32_t count = (head < SHELL_TRACE_RECORDS) ? head : SHELL_TRACE_RECORDS;
+    uint32_t first = (TRACE_MODE_ONCE == traceMode) ? 0u : ((head - count) & (SHELL_TRACE_RECORDS - 1u));
+    ShellTraceHeader_t header = { SHELL_TRACE_MAGIC, SystemCoreClock, count, head - count, 0 };
+    UBaseType_t size = uxTaskGetNumberOfTasks();
+    TaskStatus_t *tasks = pvPortMalloc(size * sizeof(TaskStatus_t));
+
+    // without the task table the host still gets the records, with numbers for names
+    if (NULL != tasks)
+    {
+        header.tasks = uxTaskGetSystemState(tasks, size, NULL);
+    }
+
+    sh_write(handle, (const uint8_t *)&header, sizeof(header));
+    for (UBaseType_t i = 0; i < header.tasks; i++)
+    {
+        ShellTraceTask_t task = { tasks[i].xTaskNumber, { 0 } };
+
+        strncpy(task.name, tasks[i].pcTaskName, sizeof(task.name) - 1u);
+        sh_write(handle, (const uint8_t *)&task, sizeof(task));
+    }
+    vPortFree(tasks);
+
+    // oldest first, in at most two pieces around the end of the ring
+    if (first + count > SHELL_TRACE_RECORDS)
+    {
+        sh_write(handle, (const uint8_t *)&traceRing[first], (SHELL_TRACE_RECORDS - first) * sizeof(ShellTraceRecord_t));
+        count -= SHELL_TRACE_RECORDS - first;
+        first = 0;
+    }
+    sh_write(handle, (const uint8_t *)&traceRing[first], count * sizeof(ShellTraceRecord_t));
+}
+
+/**
+  * @brief  trace subcommands, with the recorder locked
+  * @param handle shell handle
+  * @param argc argument count
+  * @param argv argument vector
+  * @retval None
+  */
+static void Shell_TraceCommand(Shell_Handle_t *handle, int argc, char *argv[])
+{
+    const char *action = (argc > 1) ? argv[1] : "";
+    char buf[96];
+
+    if (0 == strcmp(action, "start"))
+    {
+        TraceOptions_t opt;
+
+        if (!Shell_ParseOptions(handle, &traceOptions, argc - 2, &argv[2], &opt))
+        {
+            return;
+        }
+
+        ulShellTraceOn = 0;
+        traceMode = opt.mode;
+        traceHead = 0;
+        ulShellTraceOn = 1;
+
+        snprintf(buf, sizeof(buf), "Tracing into %u records, %s\r\n", (unsigned)SHELL_TRACE_RECORDS,
+                 (TRACE_MODE_ONCE == traceMode) ? "stops when full" : "keeps the newest");
+        sh_print(handle, buf);
+    }
+    else if (0 == strcmp(action, "stop"))
+    {
+        ulShellTraceOn = 0;
+        sh_print(handle, "Trace stopped\r\n");
+    }
+    else if (0 == strcmp(action, "dump"))
+    {
+        // the shell's own output would otherwise be traced while it is sent
+        ulShellTraceOn = 0;
+        Shell_TraceDump(handle);
+    }
+    else if (1 == argc)
+    {
+        uint32_t head = traceHead;
+        uint32_t count = (head < SHELL_TRACE_RECORDS) ? head : SHELL_TRACE_RECORDS;
+
+        snprintf(buf, sizeof(buf), "Trace %s, %s mode, %lu records, %lu lost\r\n",
+                 ulShellTraceOn ? "running" : "stopped",
+                 (TRACE_MODE_ONCE == traceMode) ? "once" : "ring",
+                 (unsigned long)count, (unsigned long)(head - count));
+        sh_print(handle, buf);
+    }
+    else
+    {
+        sh_print(handle, "Usage: trace | trace start [-mode ring|once] | trace stop | trace dump\r\n");
+    }
+}
+
+/**
+  * @brief  record task switches, queue operations and interrupts
+  * @note   a dump on one session keeps the others from restarting the ring under it
+  * @param handle shell handle
+  * @param argc argument count
+  * @param argv argument vector
+  * @retval None
+  */
+void shell_cmd_trace(Shell_Handle_t *handle, int argc, char *argv[])
+{
+    Shell_Lock(SHELL_LOCK_TRACE);
+    Shell_TraceCommand(handle, argc, argv);
+    Shell_Unlock(SHELL_LOCK_TRACE);
+}
+SHELL_COMMAND_ARGS(trace, "Record task switches, queues and interrupts", "trace | trace start [-mode ring|once] | trace stop | trace dump", shell_cmd_trace, &traceArgs);
+
+#endif /* configUSE_SHELL_TRACE */
+
+#if ( configUSE_SHELL_TRACE == 1 ) || ( configUSE_SHELL_STACK_GUARD == 1 )
+
+/**
+  * @brief  hand a task switch-in to SystemView, whose own hook the shell one replaces
+  * @note   called from traceTASK_SWITCHED_IN with the scheduler switching context
+  * @retval None
+  */
+void Shell_TraceSysviewTaskIn(void)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+    if (xTaskGetIdleTaskHandle() == task)
+    {
+        SEGGER_SYSVIEW_OnIdle();
+    }
+    else
+    {
+        SEGGER_SYSVIEW_OnTaskStartExec((U32)task);
+    }
+}
+
+#endif
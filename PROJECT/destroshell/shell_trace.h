@@ -0,0 +1,98 @@
+#ifndef __SHELL_TRACE_H__
+#define __SHELL_TRACE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+/*
+ * Built-in trace recorder. Kernel hooks (see FreeRTOSConfig.h) and the
+ * interrupt handlers in stm32f4xx_it.c write 8 byte records stamped with
+ * CYCCNT into a ring in CCMRAM. Writers claim a record with one exclusive
+ * increment of the head, so tasks and nested interrupts never block each
+ * other; the shell task is the only reader and stops recording before it
+ * dumps. tools/trace_to_perfetto.py turns a dump into a Chrome trace.
+ *
+ * This header is included from FreeRTOSConfig.h and must not pull in
+ * FreeRTOS or HAL headers; include FreeRTOS.h rather than this header so
+ * configUSE_SHELL_TRACE is known when it is read.
+ */
+
+/* Configuration constants */
+#define SHELL_TRACE_RECORDS 4096        /* Power of two, 32 KB of CCMRAM */
+#define SHELL_TRACE_MAGIC 0x31435254u   /* "TRC1" on the wire */
+
+/* Record types */
+#define SHELL_TRACE_TASK_IN 1           /* id: task number */
+#define SHELL_TRACE_TASK_OUT 2          /* id: task number */
+#define SHELL_TRACE_QUEUE_SEND 3        /* id: queue, arg: items waiting before the send */
+#define SHELL_TRACE_QUEUE_SEND_ISR 4
+#define SHELL_TRACE_QUEUE_RECEIVE 5     /* id: queue, arg: items waiting before the receive */
+#define SHELL_TRACE_QUEUE_RECEIVE_ISR 6
+#define SHELL_TRACE_ISR_ENTER 7         /* id: exception number, IRQn + 16 */
+#define SHELL_TRACE_ISR_EXIT 8
+
+typedef struct {
+    uint32_t time;                      /* CYCCNT */
+    uint8_t type;
+    uint8_t arg;
+    uint16_t id;
+} ShellTraceRecord_t;
+
+/*
+ * Dump format, little endian: the header, header.tasks task entries, then
+ * header.count records oldest first.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t clock;                     /* CYCCNT frequency in Hz */
+    uint32_t count;                     /* Records that follow */
+    uint32_t lost;                      /* Records overwritten (ring) or refused (once) */
+    uint32_t tasks;                     /* Task entries that follow */
+} ShellTraceHeader_t;
+
+typedef struct {
+    uint32_t number;                    /* uxTCBNumber, the id of task records */
+    char name[12];
+} ShellTraceTask_t;
+
+/* Set by trace start, tested by the hooks before the call */
+extern volatile uint32_t ulShellTraceOn;
+
+/* API prototypes */
+void Shell_TraceRecord(uint32_t type, uint32_t arg, uint32_t id);
+void Shell_TraceSysviewTaskIn(void);
+
+#if ( configUSE_SHELL_TRACE == 1 )
+
+#define SHELL_TRACE(type, arg, id)                                                         \
+    do                                                                                     \
+    {                                                                                      \
+        if (0 != ulShellTraceOn)                                                           \
+        {                                                                                  \
+            Shell_TraceRecord((type), (uint32_t)(arg), (uint32_t)(id));                    \
+        }                                                                                  \
+    } while (0)
+
+/* Queues are told apart by address; RAM is 128 KB so bits 2..17 are unique */
+#define SHELL_TRACE_QUEUE_ID(queue)  ((uint32_t)(uintptr_t)(queue) >> 2)
+
+/* For interrupt handlers, the exception number comes from IPSR */
+#define SHELL_TRACE_IRQ_ENTER()  SHELL_TRACE(SHELL_TRACE_ISR_ENTER, 0, __get_IPSR())
+#define SHELL_TRACE_IRQ_EXIT()   SHELL_TRACE(SHELL_TRACE_ISR_EXIT, 0, __get_IPSR())
+
+#else
+
+#define SHELL_TRACE(type, arg, id)
+#define SHELL_TRACE_IRQ_ENTER()
+#define SHELL_TRACE_IRQ_EXIT()
+
+#endif /* configUSE_SHELL_TRACE */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_TRACE_H__ */
@@ -0,0 +1,357 @@
+#include <shell_uart.h>
+
+/* Private variables ----------------------------------------------------------*/
+static ShellUartLink_t *uartLinks[SHELL_UART_LINKS];
+
+/* Private function prototypes -----------------------------------------------*/
+static void Shell_UartTxStart(ShellUartLink_t *link);
+static bool Shell_UartWaitBits(volatile uint32_t *reg, uint32_t mask, uint32_t value);
+
+/**
+  * @brief  find the link on a UART, the HAL callbacks are shared by all UARTs
+  * @param huart UART handle
+  * @retval link or NULL if the UART carries none
+  */
+static ShellUartLink_t *Shell_UartLink(UART_HandleTypeDef *huart)
+{
+    for (uint32_t i = 0; i < SHELL_UART_LINKS; i++)
+    {
+        if ((NULL != uartLinks[i]) && (huart == uartLinks[i]->huart))
+        {
+            return uartLinks[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @brief  push the DMA buffer contents up to the given position into the RX ring
+  * @param link UART link
+  * @param pos current DMA write position (0..SHELL_RX_DMA_SIZE)
+  * @param pxWoken set when a task waiting on the ring was woken
+  * @retval None
+  */
+static void Shell_UartRxPush(ShellUartLink_t *link, uint16_t pos, BaseType_t *pxWoken)
+{
+    size_t len;
+    size_t sent;
+
+    if (pos == link->rxDmaPos)
+    {
+        return;
+    }
+
+    if (pos > link->rxDmaPos)
+    {
+        len = pos - link->rxDmaPos;
+        sent = xStreamBufferSendFromISR(link->rxStream, &link->rxDma[link->rxDmaPos], len, pxWoken);
+        link->stats.rxDropped += len - sent;
+    }
+    else
+    {
+        // DMA wrapped around: tail of the buffer first, then the head
+        len = SHELL_RX_DMA_SIZE - link->rxDmaPos;
+        sent = xStreamBufferSendFromISR(link->rxStream, &link->rxDma[link->rxDmaPos], len, pxWoken);
+        link->stats.rxDropped += len - sent;
+
+        len = pos;
+        sent = xStreamBufferSendFromISR(link->rxStream, link->rxDma, len, pxWoken);
+        link->stats.rxDropped += len - sent;
+    }
+
+    link->rxDmaPos = (SHELL_RX_DMA_SIZE == pos) ? 0 : pos;
+}
+
+/**
+  * @brief  bind the link to its UART callbacks and reset the RX/TX state
+  * @param link UART link
+  * @retval true, false when SHELL_UART_LINKS UARTs are taken already
+  */
+bool Shell_UartInit(ShellUartLink_t *link)
+{
+    uint32_t slot = SHELL_UART_LINKS;
+
+    link->rxDmaPos = 0;
+    memset(&link->stats, 0, sizeof(link->stats));
+    link->txHead = 0;
+    link->txTail = 0;
+    link->txDmaLen = 0;
+
+    // a link set up again keeps its slot
+    for (uint32_t i = 0; i < SHELL_UART_LINKS; i++)
+    {
+        if ((NULL == uartLinks[i]) || (link->huart == uartLinks[i]->huart))
+        {
+            slot = i;
+            break;
+        }
+    }
+    if (SHELL_UART_LINKS == slot)
+    {
+        return false;
+    }
+
+    uartLinks[slot] = link;
+    return true;
+}
+
+/**
+  * @brief  start circular DMA reception with IDLE line detection
+  * @param link UART link
+  * @retval None
+  */
+void Shell_UartStartRx(ShellUartLink_t *link)
+{
+    link->rxDmaPos = 0;
+
+    if (HAL_OK == HAL_UARTEx_ReceiveToIdle_DMA(link->huart, link->rxDma, SHELL_RX_DMA_SIZE))
+    {
+        // RXNE must stay off, every byte is moved by the DMA
+        __HAL_UART_DISABLE_IT(link->huart, UART_IT_RXNE);
+    }
+}
+
+/**
+  * @brief  reprogram the UART of an idle link and restart reception
+  * @note   the TX ring must be empty; the last byte is let out at the old settings
+  * @param link UART link
+  * @param init new settings
+  * @retval true if the HAL accepted them, false as well if the last byte
+  *         did not leave within SHELL_UART_DRAIN_TIMEOUT
+  */
+bool Shell_UartConfigure(ShellUartLink_t *link, const UART_InitTypeDef *init)
+{
+    UART_HandleTypeDef *huart = link->huart;
+    bool done;
+
+    // CTS held off, the UART keeps its settings
+    if (!Shell_UartWaitBits(&huart->Instance->SR, USART_SR_TC, USART_SR_TC))
+    {
+        return false;
+    }
+
+    // whatever sits in the DMA buffer was received at the old rate
+    (void)HAL_UART_AbortReceive(huart);
+    huart->Init = *init;
+    done = (HAL_OK == HAL_UART_Init(huart));
+    Shell_UartStartRx(link);
+    return done;
+}
+
+/**
+  * @brief  reception event callback (DMA half/complete transfer or IDLE line)
+  * @param huart UART handle
+  * @param Size current position in the circular DMA buffer
+  * @retval None
+  */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    ShellUartLink_t *link = Shell_UartLink(huart);
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    if (NULL == link)
+    {
+        return;
+    }
+
+    Shell_UartRxPush(link, Size, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/**
+  * @brief  UART error callback, reception is aborted by the HAL and restarted here
+  * @note   a TX DMA error drops the block in flight and output goes on with the next one
+  * @param huart UART handle
+  * @retval None
+  */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    ShellUartLink_t *link = Shell_UartLink(huart);
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    if (NULL == link)
+    {
+        return;
+    }
+
+    if (0 != (huart->ErrorCode & HAL_UART_ERROR_ORE))
+    {
+        link->stats.rxOverruns++;
+    }
+
+    // Keep whatever the DMA stored before it was stopped
+    if (NULL != huart->hdmarx)
+    {
+        Shell_UartRxPush(link, SHELL_RX_DMA_SIZE - __HAL_DMA_GET_COUNTER(huart->hdmarx), &xHigherPriorityTaskWoken);
+    }
+
+    if (HAL_UART_STATE_READY == huart->RxState)
+    {
+        Shell_UartStartRx(link);
+    }
+
+    // the TX stream failed: retire its block, it will not complete
+    if ((NULL != huart->hdmatx) && (HAL_DMA_ERROR_NONE != huart->hdmatx->ErrorCode) && (0 != link->txDmaLen))
+    {
+        (void)HAL_UART_AbortTransmit(huart);
+        huart->hdmatx->ErrorCode = HAL_DMA_ERROR_NONE;
+        link->stats.txDropped += link->txDmaLen;
+        link->txTail += link->txDmaLen;
+        link->txDmaLen = 0;
+        Shell_UartTxStart(link);
+
+        if (NULL != link->txDone)
+        {
+            xSemaphoreGiveFromISR(link->txDone, &xHigherPriorityTaskWoken);
+        }
+    }
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/**
+  * @brief  start a DMA transfer of the next contiguous block of the TX ring
+  * @note   caller must guarantee the DMA is idle (txDmaLen == 0)
+  * @param link UART link
+  * @retval None
+  */
+static void Shell_UartTxStart(ShellUartLink_t *link)
+{
+    uint32_t pending = link->txHead - link->txTail;
+    uint32_t start = link->txTail & (SHELL_TX_BUFFER_SIZE - 1);
+    uint32_t len = SHELL_TX_BUFFER_SIZE - start;
+
+    if (0 == pending)
+    {
+        return;
+    }
+
+    if (len > pending)
+    {
+        len = pending;
+    }
+
+    link->txDmaLen = len;
+    if (HAL_OK != HAL_UART_Transmit_DMA(link->huart, &link->txBuffer[start], len))
+    {
+        link->txDmaLen = 0;
+    }
+}
+
+/**
+  * @brief  start draining the TX ring unless a transfer is already in flight
+  * @param link UART link
+  * @retval None
+  */
+void Shell_UartTxKick(ShellUartLink_t *link)
+{
+    bool start;
+
+    taskENTER_CRITICAL();
+    start = (0 == link->txDmaLen) && (link->txHead != link->txTail);
+    if (start)
+    {
+        // claim the DMA so the TX complete interrupt keeps its hands off
+        link->txDmaLen = 1;
+    }
+    taskEXIT_CRITICAL();
+
+    if (start)
+    {
+        Shell_UartTxStart(link);
+    }
+}
+
+/**
+  * @brief  wait for register bits, counted in core cycles so it works with interrupts disabled
+  * @param reg register to poll
+  * @param mask bits to look at
+  * @param value what the masked bits must read
+  * @retval false if they did not within SHELL_UART_DRAIN_TIMEOUT
+  */
+static bool Shell_UartWaitBits(volatile uint32_t *reg, uint32_t mask, uint32_t value)
+{
+    uint32_t limit = (SystemCoreClock / 1000u) * SHELL_UART_DRAIN_TIMEOUT;
+    uint32_t start;
+
+    // fault handlers and early boot may get here before anyone started CYCCNT
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    start = DWT->CYCCNT;
+    while (value != (*reg & mask))
+    {
+        if ((DWT->CYCCNT - start) >= limit)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+  * @brief  push everything left in the TX ring out by polling, usable with interrupts disabled
+  * @note   every wait is bounded by SHELL_UART_DRAIN_TIMEOUT; with CTS held off
+  *         what is left in the ring is dropped
+  * @param link UART link
+  * @retval None
+  */
+void Shell_UartTxDrain(ShellUartLink_t *link)
+{
+    UART_HandleTypeDef *huart = link->huart;
+
+    if (0 != link->txDmaLen)
+    {
+        // stop the DMA and account for what it already moved
+        CLEAR_BIT(huart->Instance->CR3, USART_CR3_DMAT);
+        if (NULL != huart->hdmatx)
+        {
+            __HAL_DMA_DISABLE(huart->hdmatx);
+            (void)Shell_UartWaitBits(&huart->hdmatx->Instance->CR, DMA_SxCR_EN, 0);
+            link->txTail += link->txDmaLen - __HAL_DMA_GET_COUNTER(huart->hdmatx);
+        }
+        link->txDmaLen = 0;
+        huart->gState = HAL_UART_STATE_READY;
+    }
+
+    while (link->txHead != link->txTail)
+    {
+        if (!Shell_UartWaitBits(&huart->Instance->SR, USART_SR_TXE, USART_SR_TXE))
+        {
+            link->stats.txDropped += link->txHead - link->txTail;
+            link->txTail = link->txHead;
+            return;
+        }
+        huart->Instance->DR = link->txBuffer[link->txTail & (SHELL_TX_BUFFER_SIZE - 1)];
+        link->txTail++;
+    }
+
+    (void)Shell_UartWaitBits(&huart->Instance->SR, USART_SR_TC, USART_SR_TC);
+}
+
+/**
+  * @brief  TX complete callback, retires the finished block and chains the next one
+  * @param huart UART handle
+  * @retval None
+  */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    ShellUartLink_t *link = Shell_UartLink(huart);
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    if (NULL == link)
+    {
+        return;
+    }
+
+    link->txTail += link->txDmaLen;
+    link->txDmaLen = 0;
+
+    // everything written meanwhile goes out as one transfer
+    Shell_UartTxStart(link);
+
+    if (NULL != link->txDone)
+    {
+        xSemaphoreGiveFromISR(link->txDone, &xHigherPriorityTaskWoken);
+    }
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
@@ -0,0 +1,58 @@
+#ifndef __SHELL_UART_H__
+#define __SHELL_UART_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <destroshell.h>
+
+/* Configuration constants */
+#define SHELL_RX_DMA_SIZE 64            /* Circular DMA landing area, HT/TC split it in halves */
+#define SHELL_RX_BUFFER_SIZE 512        /* Ring between the UART ISR and vUartTask */
+#define SHELL_TX_BUFFER_SIZE 2048       /* Output ring drained by DMA, must be a power of two */
+#define SHELL_UART_LINKS 4              /* UARTs carrying a shell session at once */
+#define SHELL_UART_DRAIN_TIMEOUT 100    /* ms the polled drain waits for the line to move, CTS held off */
+
+/*
+ * UART link of the DMA transport (shellUartDma). Output goes into a ring
+ * the driver sends in blocks, input comes out of a stream buffer the
+ * driver fills. The driver is DMA with the UART interrupts on the target
+ * (shell_uart.c) and the PTY task on the host (HOST/shell_uart_pty.c).
+ */
+typedef struct {
+    UART_HandleTypeDef *huart;          /* UART handle */
+    StreamBufferHandle_t rxStream;      /* Ring buffer fed from the UART RX interrupt */
+    uint8_t rxDma[SHELL_RX_DMA_SIZE];   /* Circular DMA buffer */
+    uint16_t rxDmaPos;                  /* DMA position already pushed into rxStream */
+    uint8_t txBuffer[SHELL_TX_BUFFER_SIZE]; /* Output ring, DMA reads straight out of it */
+    volatile uint32_t txHead;           /* Free running write index (producers), SHELL_TX_DROP_OLDEST pulls it back */
+    volatile uint32_t txTail;           /* Free running read index (TX complete interrupt) */
+    volatile uint16_t txDmaLen;         /* Bytes in flight, 0 while the DMA is idle */
+    SemaphoreHandle_t txDone;           /* Given by the TX complete interrupt */
+    bool txStalled;                     /* A write gave up on a full ring, the next ones do not wait */
+    ShellTransportStats_t stats;
+} ShellUartLink_t;
+
+/* UART link of the polled transport (shellUartPoll), no interrupts or DMA */
+typedef struct {
+    UART_HandleTypeDef *huart;          /* UART handle */
+    bool txStalled;                     /* A write timed out, the next ones only try one byte */
+    ShellTransportStats_t stats;
+} ShellUartPollLink_t;
+
+extern const ShellTransport_t shellUartDma;
+extern const ShellTransport_t shellUartPoll;
+
+/* Driver prototypes, used by shellUartDma */
+bool Shell_UartInit(ShellUartLink_t *link);
+void Shell_UartStartRx(ShellUartLink_t *link);
+void Shell_UartTxKick(ShellUartLink_t *link);
+void Shell_UartTxDrain(ShellUartLink_t *link);
+bool Shell_UartConfigure(ShellUartLink_t *link, const UART_InitTypeDef *init);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SHELL_UART_H__ */
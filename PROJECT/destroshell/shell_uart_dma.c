@@ -0,0 +1,286 @@
+#include <shell_uart.h>
+#include <shell_bus.h>
+
+/*
+ * DMA UART transport. Writers fill the TX ring and kick the driver, which
+ * sends the ring in blocks; the RX interrupt feeds rxStream and vUartTask
+ * blocks on it. The driver underneath is shell_uart.c on the target and
+ * HOST/shell_uart_pty.c on the host.
+ */
+
+/**
+  * @brief  create the RX stream and TX semaphore, start reception
+  * @param handle shell handle, link is a ShellUartLink_t
+  * @retval true when the link is up
+  */
+static bool Shell_UartDmaInit(Shell_Handle_t *handle)
+{
+    ShellUartLink_t *link = (ShellUartLink_t *)handle->link;
+
+    Shell_BusReserveUart(link->huart);
+    link->txStalled = false;
+    link->txDone = xSemaphoreCreateBinary();
+    link->rxStream = xStreamBufferCreate(SHELL_RX_BUFFER_SIZE, 1);
+
+    if (!Shell_UartInit(link) || (NULL == link->rxStream) || (NULL == link->txDone))
+    {
+        return false;
+    }
+
+    Shell_UartStartRx(link);
+    return true;
+}
+
+/**
+  * @brief  wait for input
+  * @param handle shell handle
+  * @param data destination
+  * @param len maximum number of bytes
+  * @retval bytes read, at least one
+  */
+static size_t Shell_UartDmaRead(Shell_Handle_t *handle, uint8_t *data, size_t len)
+{
+    ShellUartLink_t *link = (ShellUartLink_t *)handle->link;
+    size_t count = xStreamBufferReceive(link->rxStream, data, len, portMAX_DELAY);
+
+    link->stats.rxBytes += count;
+    return count;
+}
+
+/**
+  * @brief  drop the output queued behind the block in flight, SHELL_TX_DROP_OLDEST
+  * @note   the DMA reads the block in flight and the driver chains from
+  *         txTail to txHead, so pulling txHead back is all it takes
+  * @param link UART link
+  * @retval bytes dropped, 0 when all output pending is in flight
+  */
+static uint32_t Shell_UartDmaDropOldest(ShellUartLink_t *link)
+{
+    uint32_t queued;
+
+    taskENTER_CRITICAL();
+    queued = link->txHead - link->txTail - link->txDmaLen;
+    link->txHead -= queued;
+    taskEXIT_CRITICAL();
+
+    link->stats.txDropped += queued;
+    return queued;
+}
+
+/**
+  * @brief  queue bytes in the TX ring, returns as soon as they are in
+  * @note   a full ring is handled as handle->txPolicy says. The timeout
+  *         counts from the last block the DMA retired, so a long write only
+  *         gives up when the line stops moving. A write that
+  *         timed out leaves the link stalled: later writes drop at once
+  *         until a block completes. Before the scheduler runs the ring is
+  *         drained by polling instead
+  * @param handle shell handle
+  * @param data bytes to send
+  * @param len number of bytes
+  * @retval None
+  */
+static void Shell_UartDmaWrite(Shell_Handle_t *handle, const uint8_t *data, size_t len)
+{
+    ShellUartLink_t *link = (ShellUartLink_t *)handle->link;
+    bool running = (taskSCHEDULER_RUNNING == xTaskGetSchedulerState());
+    TickType_t timeout = pdMS_TO_TICKS(handle->txTimeout);
+    TickType_t start = xTaskGetTickCount();
+    uint32_t tail = link->txTail;
+    bool full = false;
+
+    while (len > 0)
+    {
+        uint32_t space = SHELL_TX_BUFFER_SIZE - (link->txHead - link->txTail);
+
+        if (0 == space)
+        {
+            TickType_t now = xTaskGetTickCount();
+
+            // room freed since the last look restarts the deadline
+            if (tail != link->txTail)
+            {
+                tail = link->txTail;
+                start = now;
+            }
+            TickType_t elapsed = now - start;
+
+            if (!full)
+            {
+                full = true;
+                link->stats.txStalls++;
+            }
+
+            if (!running || (NULL == link->txDone))
+            {
+                Shell_UartTxDrain(link);
+                continue;
+            }
+
+            if ((SHELL_TX_DROP_OLDEST == handle->txPolicy) && (0 != Shell_UartDmaDropOldest(link)))
+            {
+                // of a write longer than the room left only its end would stay
+                uint32_t room = SHELL_TX_BUFFER_SIZE - (link->txHead - link->txTail);
+                if (len > room)
+                {
+                    link->stats.txDropped += len - room;
+                    data += len - room;
+                    len = room;
+                }
+                continue;
+            }
+
+            if (SHELL_TX_DROP_NEWEST == handle->txPolicy)
+            {
+                break;
+            }
+
+            // once stalled, only a block completed since earns another wait
+            if (link->txStalled && (pdPASS == xSemaphoreTake(link->txDone, 0)))
+            {
+                link->txStalled = false;
+            }
+            if (link->txStalled || (elapsed >= timeout))
+            {
+                link->txStalled = true;
+                break;
+            }
+
+            Shell_UartTxKick(link);
+            if (pdPASS == xSemaphoreTake(link->txDone, timeout - elapsed))
+            {
+                start = xTaskGetTickCount();
+            }
+            continue;
+        }
+
+        uint32_t head = link->txHead & (SHELL_TX_BUFFER_SIZE - 1);
+        uint32_t chunk = SHELL_TX_BUFFER_SIZE - head;
+        if (chunk > space)
+        {
+            chunk = space;
+        }
+        if (chunk > len)
+        {
+            chunk = len;
+        }
+
+        memcpy(&link->txBuffer[head], data, chunk);
+        link->txHead += chunk;
+        link->stats.txBytes += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+
+    link->stats.txDropped += len;
+    Shell_UartTxKick(link);
+}
+
+/**
+  * @brief  wait until the TX ring is empty and the last block has been sent
+  * @param handle shell handle
+  * @param timeout maximum time to wait in ticks
+  * @retval true if the ring is empty
+  */
+static bool Shell_UartDmaFlush(Shell_Handle_t *handle, TickType_t timeout)
+{
+    ShellUartLink_t *link = (ShellUartLink_t *)handle->link;
+    TickType_t start = xTaskGetTickCount();
+
+    while ((link->txHead != link->txTail) || (0 != link->txDmaLen))
+    {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout)
+        {
+            break;
+        }
+        Shell_UartTxKick(link);
+        xSemaphoreTake(link->txDone, timeout - elapsed);
+    }
+
+    if ((link->txHead == link->txTail) && (0 == link->txDmaLen))
+    {
+        // the line moves, writes may wait for room again
+        link->txStalled = false;
+        return true;
+    }
+    return false;
+}
+
+/**
+  * @brief  send the TX ring, then data, by polling; usable with interrupts disabled
+  * @param handle shell handle
+  * @param data bytes to send after the ring, may be NULL
+  * @param len number of bytes
+  * @retval None
+  */
+static void Shell_UartDmaDrain(Shell_Handle_t *handle, const uint8_t *data, size_t len)
+{
+    ShellUartLink_t *link = (ShellUartLink_t *)handle->link;
+
+    Shell_UartTxDrain(link);
+
+    // straight through the ring, which the drain just emptied
+    while (len > 0)
+    {
+        size_t chunk = (len > SHELL_TX_BUFFER_SIZE) ? SHELL_TX_BUFFER_SIZE : len;
+        uint32_t head = link->txHead & (SHELL_TX_BUFFER_SIZE - 1);
+        uint32_t first = SHELL_TX_BUFFER_SIZE - head;
+
+        if (first > chunk)
+        {
+            first = chunk;
+        }
+        memcpy(&link->txBuffer[head], data, first);
+        memcpy(link->txBuffer, data + first, chunk - first);
+        link->txHead += chunk;
+        link->stats.txBytes += chunk;
+        Shell_UartTxDrain(link);
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+/**
+  * @brief  copy the link counters
+  * @param handle shell handle
+  * @param stats destination
+  * @retval None
+  */
+static void Shell_UartDmaStats(Shell_Handle_t *handle, ShellTransportStats_t *stats)
+{
+    *stats = ((ShellUartLink_t *)handle->link)->stats;
+}
+
+/**
+  * @brief  UART of the link
+  * @param handle shell handle
+  * @retval UART handle
+  */
+static UART_HandleTypeDef *Shell_UartDmaUart(Shell_Handle_t *handle)
+{
+    return ((ShellUartLink_t *)handle->link)->huart;
+}
+
+/**
+  * @brief  reprogram the UART, reception restarts at the new settings
+  * @param handle shell handle
+  * @param init new settings
+  * @retval true if the HAL accepted them
+  */
+static bool Shell_UartDmaConfigure(Shell_Handle_t *handle, const UART_InitTypeDef *init)
+{
+    return Shell_UartConfigure((ShellUartLink_t *)handle->link, init);
+}
+
+const ShellTransport_t shellUartDma = {
+    "uart-dma",
+    Shell_UartDmaInit,
+    Shell_UartDmaRead,
+    Shell_UartDmaWrite,
+    Shell_UartDmaFlush,
+    Shell_UartDmaDrain,
+    Shell_UartDmaStats,
+    Shell_UartDmaUart,
+    Shell_UartDmaConfigure,
+};
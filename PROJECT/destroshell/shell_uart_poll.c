@@ -0,0 +1,182 @@
+#include <shell_uart.h>
+#include <shell_bus.h>
+
+/*
+ * Polled UART transport: no interrupts, no DMA, nothing but the UART
+ * registers. For bring-up or a board whose DMA streams are taken. The
+ * receiver holds a single byte, so input only survives while vUartTask
+ * polls; pasted text at full line rate overruns (counted in rxOverruns).
+ */
+
+/**
+  * @brief  claim the UART
+  * @param handle shell handle, link is a ShellUartPollLink_t
+  * @retval true
+  */
+static bool Shell_UartPollInit(Shell_Handle_t *handle)
+{
+    ShellUartPollLink_t *link = (ShellUartPollLink_t *)handle->link;
+
+    Shell_BusReserveUart(link->huart);
+    link->txStalled = false;
+    memset(&link->stats, 0, sizeof(link->stats));
+    return true;
+}
+
+/**
+  * @brief  poll the receiver until at least one byte arrives
+  * @note   bytes already following the first one are collected in the same
+  *         call, then the tick sleep lets lower priority tasks run
+  * @param handle shell handle
+  * @param data destination
+  * @param len maximum number of bytes
+  * @retval bytes read, at least one
+  */
+static size_t Shell_UartPollRead(Shell_Handle_t *handle, uint8_t *data, size_t len)
+{
+    ShellUartPollLink_t *link = (ShellUartPollLink_t *)handle->link;
+    size_t count = 0;
+
+    while (1)
+    {
+        if (__HAL_UART_GET_FLAG(link->huart, UART_FLAG_ORE))
+        {
+            link->stats.rxOverruns++;
+        }
+
+        while ((count < len) && (HAL_OK == HAL_UART_Receive(link->huart, &data[count], 1, 0)))
+        {
+            count++;
+        }
+
+        if (count > 0)
+        {
+            link->stats.rxBytes += count;
+            return count;
+        }
+        vTaskDelay(1);
+    }
+}
+
+/**
+  * @brief  send bytes, returns when the last one is in the shift register
+  * @note   nothing is queued, so every policy means the same: wait up to
+  *         handle->txTimeout for the transmitter, then drop the rest. A write
+  *         that timed out leaves the link stalled and later ones are
+  *         dropped unless their first byte leaves within a tick
+  * @param handle shell handle
+  * @param data bytes to send
+  * @param len number of bytes
+  * @retval None
+  */
+static void Shell_UartPollWrite(Shell_Handle_t *handle, const uint8_t *data, size_t len)
+{
+    ShellUartPollLink_t *link = (ShellUartPollLink_t *)handle->link;
+    uint32_t timeout = (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) ? handle->txTimeout : HAL_MAX_DELAY;
+
+    // stalled: one byte gets a tick to go out, otherwise the write is dropped whole
+    if (link->txStalled && (len > 0))
+    {
+        if (HAL_OK != HAL_UART_Transmit(link->huart, (uint8_t *)data, 1, 1))
+        {
+            link->stats.txDropped += len;
+            return;
+        }
+        link->stats.txBytes++;
+        data++;
+        len--;
+    }
+    link->txStalled = false;
+
+    while (len > 0)
+    {
+        uint16_t chunk = (len > 0xFFFF) ? 0xFFFF : (uint16_t)len;
+        HAL_StatusTypeDef status = HAL_UART_Transmit(link->huart, (uint8_t *)data, chunk, timeout);
+
+        if (HAL_OK != status)
+        {
+            // what the HAL did not get to counts as dropped, CTS held off or the line stuck
+            uint32_t sent = (HAL_TIMEOUT == status) ? (uint32_t)(chunk - link->huart->TxXferCount) : 0u;
+
+            link->txStalled = true;
+            link->stats.txStalls++;
+            link->stats.txBytes += sent;
+            link->stats.txDropped += len - sent;
+            return;
+        }
+        link->stats.txBytes += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+/**
+  * @brief  nothing is ever pending, writes return when the bytes are out
+  * @retval true
+  */
+static bool Shell_UartPollFlush(Shell_Handle_t *handle, TickType_t timeout)
+{
+    return true;
+}
+
+/**
+  * @brief  send data; the HAL polls the flags without RTOS calls
+  * @param handle shell handle
+  * @param data bytes to send, may be NULL
+  * @param len number of bytes
+  * @retval None
+  */
+static void Shell_UartPollDrain(Shell_Handle_t *handle, const uint8_t *data, size_t len)
+{
+    if (NULL != data)
+    {
+        Shell_UartPollWrite(handle, data, len);
+    }
+}
+
+/**
+  * @brief  copy the link counters
+  * @param handle shell handle
+  * @param stats destination
+  * @retval None
+  */
+static void Shell_UartPollStats(Shell_Handle_t *handle, ShellTransportStats_t *stats)
+{
+    *stats = ((ShellUartPollLink_t *)handle->link)->stats;
+}
+
+/**
+  * @brief  UART of the link
+  * @param handle shell handle
+  * @retval UART handle
+  */
+static UART_HandleTypeDef *Shell_UartPollUart(Shell_Handle_t *handle)
+{
+    return ((ShellUartPollLink_t *)handle->link)->huart;
+}
+
+/**
+  * @brief  reprogram the UART, writes return once their bytes are out so nothing is in flight
+  * @param handle shell handle
+  * @param init new settings
+  * @retval true if the HAL accepted them
+  */
+static bool Shell_UartPollConfigure(Shell_Handle_t *handle, const UART_InitTypeDef *init)
+{
+    UART_HandleTypeDef *huart = ((ShellUartPollLink_t *)handle->link)->huart;
+
+    huart->Init = *init;
+    return (HAL_OK == HAL_UART_Init(huart));
+}
+
+const ShellTransport_t shellUartPoll = {
+    "uart-poll",
+    Shell_UartPollInit,
+    Shell_UartPollRead,
+    Shell_UartPollWrite,
+    Shell_UartPollFlush,
+    Shell_UartPollDrain,
+    Shell_UartPollStats,
+    Shell_UartPollUart,
+    Shell_UartPollConfigure,
+};
@@ -0,0 +1,238 @@
+/*
+ * Host microbenchmark for shell command dispatch.
+ *
+ * Compares the three lookups the shell has used over a table of 10, 100
+ * and 1000 synthetic commands:
+ *   linear  - strcmp walk over the table (original Shell_Task)
+ *   bsearch - binary search over the name sorted link-time table
+ *   hash    - Shell_HashIndexFind from PROJECT/destroshell/shell_hash.h
+ *
+ * Build and run on the host:
+ *   cc -O2 -I PROJECT/destroshell tools/cmd_lookup_bench.c -o cmd_lookup_bench
+ *   ./cmd_lookup_bench
+ *
+ * Absolute numbers are host numbers; the ratios are what carries over to
+ * the Cortex-M4.
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <shell_hash.h>
+
+#define BENCH_ROUNDS      200000u       /* lookups per measurement */
+#define BENCH_MISS_EVERY  8u            /* one unknown command every N lookups */
+
+/* same layout as ShellCommand_t, without the FreeRTOS dependency */
+typedef struct {
+    const char *commandName;
+    const char *description;
+    const char *usage;
+    void (*commandHandler)(void *, int argc, char *argv[]);
+    uint32_t nameHash;
+} BenchCommand_t;
+
+typedef int (*lookup_fn)(const BenchCommand_t *table, size_t count, const uint16_t *slots,
+                         unsigned bits, const char *key);
+
+static volatile int sink;
+
+static const char *const stems[] = {
+    "adc", "can", "clear", "dac", "dma", "flash", "gpio", "heap", "help", "i2c",
+    "init", "log", "pin", "prof", "pwm", "reset", "rtc", "spi", "stack", "status",
+    "tasks", "tim", "top", "trace", "uart", "usb", "wdg", "perf", "bench", "baud"
+};
+
+static int cmp_name(const void *a, const void *b)
+{
+    return strcmp(((const BenchCommand_t *)a)->commandName, ((const BenchCommand_t *)b)->commandName);
+}
+
+static int lookup_linear(const BenchCommand_t *table, size_t count, const uint16_t *slots,
+                         unsigned bits, const char *key)
+{
+    size_t i;
+
+    (void)slots;
+    (void)bits;
+    for (i = 0; i < count; i++)
+    {
+        if (0 == strcmp(key, table[i].commandName))
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static int lookup_bsearch(const BenchCommand_t *table, size_t count, const uint16_t *slots,
+                          unsigned bits, const char *key)
+{
+    size_t low = 0;
+    size_t high = count;
+
+    (void)slots;
+    (void)bits;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        int cmp = strcmp(key, table[mid].commandName);
+
+        if (0 == cmp)
+        {
+            return (int)mid;
+        }
+        if (cmp < 0)
+        {
+            high = mid;
+        }
+        else
+        {
+            low = mid + 1;
+        }
+    }
+    return -1;
+}
+
+static int lookup_hash(const BenchCommand_t *table, size_t count, const uint16_t *slots,
+                       unsigned bits, const char *key)
+{
+    (void)count;
+    return Shell_HashIndexFind(slots, bits, &table[0].nameHash, &table[0].commandName,
+                               sizeof(BenchCommand_t), key);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double measure(lookup_fn fn, const BenchCommand_t *table, size_t count, const uint16_t *slots,
+                      unsigned bits, char **keys, size_t nkeys)
+{
+    double start;
+    uint32_t r;
+    int acc = 0;
+
+    start = now_ns();
+    for (r = 0; r < BENCH_ROUNDS; r++)
+    {
+        acc += fn(table, count, slots, bits, keys[r % nkeys]);
+    }
+    sink = acc;
+    return (now_ns() - start) / BENCH_ROUNDS;
+}
+
+static int run(size_t count)
+{
+    unsigned bits = 4;
+    size_t nkeys = count + count / BENCH_MISS_EVERY + 1;
+    BenchCommand_t *table = calloc(count, sizeof(*table));
+    char **keys = calloc(nkeys, sizeof(*keys));
+    uint16_t *slots;
+    size_t i;
+
+    // at most half full, like SHELL_CMD_HASH_BITS on the target
+    while ((1u << bits) < 2 * count)
+    {
+        bits++;
+    }
+    slots = calloc(1u << bits, sizeof(*slots));
+    if ((NULL == table) || (NULL == keys) || (NULL == slots))
+    {
+        return -1;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        char *name = malloc(SHELL_CMD_NAME_MAX + 1);
+
+        snprintf(name, SHELL_CMD_NAME_MAX + 1, "%s%u",
+                 stems[i % (sizeof(stems) / sizeof(stems[0]))], (unsigned)(i / (sizeof(stems) / sizeof(stems[0]))));
+        table[i].commandName = name;
+        Shell_NameHash(name, &table[i].nameHash);
+    }
+    qsort(table, count, sizeof(*table), cmp_name);
+
+    if (0 != Shell_HashIndexBuild(slots, bits, &table[0].nameHash, sizeof(BenchCommand_t), count))
+    {
+        return -1;
+    }
+
+    // every command once plus a sprinkle of unknown ones, shuffled
+    for (i = 0; i < count; i++)
+    {
+        keys[i] = (char *)table[i].commandName;
+    }
+    for (; i < nkeys; i++)
+    {
+        keys[i] = malloc(SHELL_CMD_NAME_MAX + 1);
+        snprintf(keys[i], SHELL_CMD_NAME_MAX + 1, "nosuch%u", (unsigned)i);
+    }
+    srand(1);
+    for (i = nkeys - 1; i > 0; i--)
+    {
+        size_t j = (size_t)rand() % (i + 1);
+        char *t = keys[i];
+
+        keys[i] = keys[j];
+        keys[j] = t;
+    }
+
+    // sanity: all three agree on every key
+    for (i = 0; i < nkeys; i++)
+    {
+        int a = lookup_linear(table, count, slots, bits, keys[i]);
+
+        if ((a != lookup_bsearch(table, count, slots, bits, keys[i])) ||
+            (a != lookup_hash(table, count, slots, bits, keys[i])))
+        {
+            fprintf(stderr, "lookup mismatch for %s\n", keys[i]);
+            return -1;
+        }
+    }
+
+    printf("%6u %12.1f %12.1f %12.1f\n", (unsigned)count,
+           measure(lookup_linear, table, count, slots, bits, keys, nkeys),
+           measure(lookup_bsearch, table, count, slots, bits, keys, nkeys),
+           measure(lookup_hash, table, count, slots, bits, keys, nkeys));
+
+    // keys are shuffled, the unknown ones are the ones the table does not own
+    for (i = 0; i < nkeys; i++)
+    {
+        if (lookup_linear(table, count, slots, bits, keys[i]) < 0)
+        {
+            free(keys[i]);
+        }
+    }
+    for (i = 0; i < count; i++)
+    {
+        free((char *)table[i].commandName);
+    }
+    free(slots);
+    free(keys);
+    free(table);
+    return 0;
+}
+
+int main(void)
+{
+    static const size_t sizes[] = { 10, 100, 1000 };
+    size_t i;
+
+    printf("%6s %12s %12s %12s   (ns per lookup, 1/%u misses)\n", "cmds", "linear", "bsearch", "hash",
+           BENCH_MISS_EVERY);
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        if (0 != run(sizes[i]))
+        {
+            fprintf(stderr, "benchmark failed at %u commands\n", (unsigned)sizes[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""
+Flat profile from the destroshell PC sampling profiler.
+
+Reads the binary table written by "prof dump" (see ShellProfHeader_t in
+PROJECT/destroshell/shell_prof.h), either straight from the shell port or
+from a file saved earlier, and attributes every sampled PC to a function of
+the ELF with arm-none-eabi-nm.
+
+    prof start -rate 10000        (on the target, let it run)
+    python3 tools/prof_symbolize.py build/destroshell_debug --port /dev/ttyUSB0
+    python3 tools/prof_symbolize.py build/destroshell_debug --input prof.bin --lines
+
+pyserial is only needed for --port (pip install -r tools/requirements.txt).
+"""
+import argparse
+import bisect
+import struct
+import subprocess
+import sys
+import time
+
+MAGIC = 0x31465250          # "PRF1", SHELL_PROF_MAGIC
+HEADER = struct.Struct("<5I")
+SLOT = struct.Struct("<2I")
+
+
+def read_port(port, baud, timeout):
+    import serial
+
+    with serial.Serial(port, baud, timeout=0.2) as ser:
+        ser.reset_input_buffer()
+        ser.write(b"prof dump\r")
+        data = b""
+        deadline = time.monotonic() + timeout
+        magic = struct.pack("<I", MAGIC)
+        while time.monotonic() < deadline:
+            data += ser.read(4096)
+            start = data.find(magic)
+            if start < 0 or len(data) < start + HEADER.size:
+                continue
+            count = HEADER.unpack_from(data, start)[4]
+            end = start + HEADER.size + count * SLOT.size
+            if len(data) >= end:
+                return data[start:end]
+    sys.exit("no complete dump received from %s" % port)
+
+
+def parse(blob):
+    start = blob.find(struct.pack("<I", MAGIC))
+    if start < 0:
+        sys.exit("no profiler dump found in input")
+    _, rate, samples, dropped, count = HEADER.unpack_from(blob, start)
+    offset = start + HEADER.size
+    if len(blob) < offset + count * SLOT.size:
+        sys.exit("dump truncated: %d of %d slots" % ((len(blob) - offset) // SLOT.size, count))
+    slots = [SLOT.unpack_from(blob, offset + i * SLOT.size) for i in range(count)]
+    if sum(hits for _, hits in slots) + dropped != samples:
+        print("warning: slot hits and dropped do not add up to the sample count", file=sys.stderr)
+    return rate, samples, dropped, slots
+
+
+def load_symbols(elf, prefix):
+    out = subprocess.run([prefix + "nm", "--defined-only", "-n", "-S", "-C", elf],
+                         check=True, capture_output=True, text=True).stdout
+    starts, symbols = [], []
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4 and fields[2] in "tTwW":
+            # Thumb function symbols carry bit 0
+            addr = int(fields[0], 16) & ~1
+            starts.append(addr)
+            symbols.append((addr, int(fields[1], 16), fields[3]))
+    return starts, symbols
+
+
+def function_of(pc, starts, symbols):
+    i = bisect.bisect_right(starts, pc) - 1
+    if i >= 0:
+        addr, size, name = symbols[i]
+        if pc < addr + size:
+            return name
+    return "?? 0x%08x" % pc
+
+
+def source_lines(elf, prefix, pcs):
+    out = subprocess.run([prefix + "addr2line", "-e", elf] + ["0x%x" % pc for pc in pcs],
+                         check=True, capture_output=True, text=True).stdout
+    return dict(zip(pcs, out.splitlines()))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("elf", help="firmware ELF the target is running")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="shell serial port, sends 'prof dump'")
+    source.add_argument("--input", help="file holding a saved dump")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--timeout", type=float, default=10.0, help="seconds to wait for the dump")
+    parser.add_argument("--save", help="also write the raw dump to this file")
+    parser.add_argument("--lines", action="store_true", help="profile by source line instead of function")
+    parser.add_argument("--top", type=int, default=40, help="rows to print, 0 for all")
+    parser.add_argument("--prefix", default="arm-none-eabi-", help="toolchain prefix")
+    args = parser.parse_args()
+
+    if args.port:
+        blob = read_port(args.port, args.baud, args.timeout)
+    else:
+        with open(args.input, "rb") as f:
+            blob = f.read()
+    if args.save:
+        with open(args.save, "wb") as f:
+            f.write(blob)
+
+    rate, samples, dropped, slots = parse(blob)
+    if args.lines:
+        names = source_lines(args.elf, args.prefix, [pc for pc, _ in slots])
+    else:
+        starts, symbols = load_symbols(args.elf, args.prefix)
+        names = {pc: function_of(pc, starts, symbols) for pc, _ in slots}
+
+    profile = {}
+    for pc, hits in slots:
+        profile[names[pc]] = profile.get(names[pc], 0) + hits
+
+    counted = max(samples - dropped, 1)
+    print("%d samples at %d Hz (%.2f s), %d distinct PCs, %d dropped"
+          % (samples, rate, samples / rate if rate else 0.0, len(slots), dropped))
+    print("%7s %7s %9s  %s" % ("self%", "cum%", "samples", "line" if args.lines else "function"))
+    cumulative = 0
+    rows = sorted(profile.items(), key=lambda item: item[1], reverse=True)
+    for name, hits in rows[:args.top or None]:
+        cumulative += hits
+        print("%6.2f%% %6.2f%% %9d  %s"
+              % (100.0 * hits / counted, 100.0 * cumulative / counted, hits, name))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""
+Move the destroshell console to another baud rate, host side of "baud".
+
+Sends "baud <rate>", waits until the announcement has been received in
+full (the shell only reprograms its UART once its output is out), then
+switches the local port and acknowledges at the new rate. If the shell
+does not confirm, the port goes back to the old rate, where the shell
+returns by itself after its ack timeout.
+
+    python3 tools/shell_baud.py --port /dev/ttyUSB0 921600
+    python3 tools/shell_baud.py --port /dev/ttyUSB0 --baud 921600 115200
+
+As a module, before a bulk transfer such as "trace dump":
+
+    negotiate(ser, 2000000)
+
+pyserial is needed (pip install -r tools/requirements.txt).
+"""
+import argparse
+import re
+import sys
+import time
+
+from shell_link_bench import PROMPT, read_until, sync
+
+ACK = b"ok"                                     # SHELL_BAUD_ACK in shell_baud.h
+SWITCH = re.compile(rb"Send 'ok' at the new rate within (\d+) ms\r\n")
+REFUSED = re.compile(rb"(out of reach|more than \d+%|Leave RPC mode|does not run on a UART|Usage)[^\r]*")
+CONFIRM = b"Link at "
+
+
+def negotiate(ser, rate, timeout=5.0):
+    """Switch shell and port to rate; returns the rate in use afterwards."""
+    old = ser.baudrate
+    sync(ser, timeout)
+    ser.write(b"baud %d\r" % rate)
+
+    data = b""
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        data += ser.read(ser.in_waiting or 1)
+        refused = REFUSED.search(data)
+        if refused:
+            raise ValueError(refused.group(0).decode(errors="replace"))
+        match = SWITCH.search(data)
+        if match:
+            break
+    else:
+        raise TimeoutError("no answer to 'baud %d'" % rate)
+
+    # the shell is at the new rate once the announcement has left it
+    ser.baudrate = rate
+    ser.reset_input_buffer()
+    # the leading CR ends whatever noise the shell took in while the rates differed
+    ser.write(b"\r" + ACK + b"\r")
+    reply = read_until(ser, PROMPT, int(match.group(1)) / 1e3 + timeout)
+    if reply is not None and CONFIRM in reply:
+        return rate
+
+    # the shell falls back once its ack timeout has passed
+    ser.baudrate = old
+    time.sleep(int(match.group(1)) / 1e3)
+    sync(ser, timeout)
+    return old
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--port", required=True, help="shell serial port or pseudo-terminal")
+    parser.add_argument("--baud", type=int, default=115200, help="rate the shell runs at now")
+    parser.add_argument("--timeout", type=float, default=5.0)
+    parser.add_argument("rate", type=int, help="rate to switch to")
+    args = parser.parse_args()
+
+    import serial
+
+    with serial.Serial(args.port, args.baud, timeout=0.05) as ser:
+        try:
+            now = negotiate(ser, args.rate, args.timeout)
+        except ValueError as error:
+            sys.exit("refused: %s" % error)
+    if now != args.rate:
+        sys.exit("no confirmation at %d baud, back at %d" % (args.rate, now))
+    print("shell at %d baud" % now)
+
+
+if __name__ == "__main__":
+    main()
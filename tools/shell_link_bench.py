@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+Command-to-prompt latency and paste rate of the destroshell console.
+
+Drives the shell from the far end of its link, so it measures the whole
+path a user sees, whatever carries the bytes: the board on a serial port,
+or the host build on its pseudo-terminal, where HOST/host_uart.c gives the
+line the timing of the configured baud rate and frame.
+
+    python3 tools/shell_link_bench.py --port /tmp/destroshell
+    python3 tools/shell_link_bench.py --port /dev/ttyUSB0 --command status
+
+latency  sends the command line --runs times and times each one from the
+         final '\\r' to the end of the prompt that follows its output.
+paste    sends --lines unknown commands tagged with a number back to back
+         at a given byte rate, then counts the tags coming back in the
+         "Unknown command" replies. The rate is bisected between 1/64 of
+         the wire and the wire for the highest one that loses nothing.
+
+pyserial is needed (pip install -r tools/requirements.txt).
+"""
+import argparse
+import re
+import statistics
+import sys
+import time
+
+PROMPT = b"[root@root ~]# "     # prompt in destroshell.h
+TAG = "x%05d"                   # pasted line, an unknown command
+REPLY = re.compile(rb"Unknown command: x(\d{5})")
+
+
+def read_until(ser, marker, timeout):
+    """Bytes up to and including marker, None on timeout."""
+    data = b""
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        data += ser.read(ser.in_waiting or 1)
+        end = data.find(marker)
+        if end >= 0:
+            return data[:end + len(marker)]
+    return None
+
+
+def read_quiet(ser, quiet, timeout):
+    """Everything received until the link stays quiet for `quiet` seconds."""
+    data = b""
+    deadline = time.monotonic() + timeout
+    last = time.monotonic()
+    while time.monotonic() < deadline and time.monotonic() - last < quiet:
+        chunk = ser.read(ser.in_waiting or 1)
+        if chunk:
+            data += chunk
+            last = time.monotonic()
+    return data
+
+
+def sync(ser, timeout):
+    """Empty line, wait for its prompt, drop whatever else is pending."""
+    read_quiet(ser, 0.1, timeout)
+    ser.write(b"\r")
+    if read_until(ser, PROMPT, timeout) is None:
+        sys.exit("no prompt from the shell")
+    read_quiet(ser, 0.1, timeout)
+
+
+def latency(ser, command, runs, timeout):
+    samples = []
+    line = command.encode()
+    for _ in range(runs):
+        sync(ser, timeout)
+        ser.write(line)
+        # the typed characters are echoed; only the Enter is timed
+        if read_until(ser, line, timeout) is None:
+            sys.exit("command echo not received")
+        start = time.perf_counter()
+        ser.write(b"\r")
+        if read_until(ser, PROMPT, timeout) is None:
+            sys.exit("no prompt after '%s'" % command)
+        samples.append((time.perf_counter() - start) * 1e3)
+    return samples
+
+
+def paste(ser, rate, lines, timeout):
+    """Tags seen back when `lines` lines go out at `rate` bytes per second."""
+    sync(ser, timeout)
+    start = time.perf_counter()
+    sent = 0
+    for i in range(lines):
+        text = (TAG % i + "\r").encode()
+        ser.write(text)
+        sent += len(text)
+        pause = start + sent / rate - time.perf_counter()
+        if pause > 0:
+            time.sleep(pause)
+    data = read_quiet(ser, 0.5, timeout)
+    return {int(tag) for tag in REPLY.findall(data)}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--port", required=True, help="shell serial port or pseudo-terminal")
+    parser.add_argument("--baud", type=int, default=115200, help="line rate, also the paste search bound")
+    parser.add_argument("--frame", type=int, default=10, help="bits per byte on the wire, 10 for 8N1")
+    parser.add_argument("--command", default="status", help="command line timed for latency")
+    parser.add_argument("--runs", type=int, default=50)
+    parser.add_argument("--lines", type=int, default=100, help="lines per paste")
+    parser.add_argument("--steps", type=int, default=6, help="bisection steps of the paste rate")
+    parser.add_argument("--timeout", type=float, default=10.0)
+    args = parser.parse_args()
+
+    import serial
+
+    wire = args.baud / args.frame
+    with serial.Serial(args.port, args.baud, timeout=0.05) as ser:
+        samples = sorted(latency(ser, args.command, args.runs, args.timeout))
+        p95 = samples[min(len(samples) - 1, int(len(samples) * 0.95))]
+        print("latency '%s', %d runs: min %.2f ms, median %.2f ms, p95 %.2f ms, max %.2f ms"
+              % (args.command, len(samples), samples[0], statistics.median(samples), p95, samples[-1]))
+
+        line = len(TAG % 0) + 1
+        print("paste, %d lines of %d bytes, wire %.0f B/s" % (args.lines, line, wire))
+        good, bad = 0.0, None
+        rate = wire
+        for _ in range(args.steps):
+            seen = paste(ser, rate, args.lines, args.timeout)
+            print("  %8.0f B/s  %3d/%d lines" % (rate, len(seen), args.lines))
+            if len(seen) == args.lines:
+                good = rate
+            else:
+                bad = rate
+            if bad is None:
+                break
+            rate = (good + bad) / 2 if good else rate / 4
+            if rate < wire / 64:
+                break
+
+        if good:
+            print("sustained paste rate %.0f B/s, %.0f lines/s, %.0f%% of the wire"
+                  % (good, good / line, 100.0 * good / wire))
+        else:
+            print("no paste rate above %.0f B/s got through intact" % (wire / 64))
+
+
+if __name__ == "__main__":
+    main()
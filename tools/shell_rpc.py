@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+"""
+Client for the framed binary mode of the destroshell console.
+
+Switches the shell out of the line editor with the escape sequence and
+runs commands from the same table as the text shell, getting typed values
+back instead of printed text (see PROJECT/destroshell/shell_rpc.h for the
+wire format). Works on the board's serial port and on the pseudo-terminal
+of the host build alike.
+
+    python3 tools/shell_rpc.py --port /dev/ttyUSB0 "tasks list" heap
+    python3 tools/shell_rpc.py --port /tmp/destroshell "pin read gpioa 0"
+
+As a module:
+
+    with ShellRpc(serial.Serial(port, 115200, timeout=0.05)) as rpc:
+        total, free, min_free, largest, allocs, frees = rpc.call("heap")[0]
+
+pyserial is needed (pip install -r tools/requirements.txt).
+"""
+import argparse
+import struct
+import sys
+import time
+
+ESCAPE = b"\x1b\x02RPC"         # SHELL_RPC_ESCAPE
+
+OP_CALL, OP_PING, OP_EXIT = 1, 2, 3
+
+STATUS = {
+    0: "ok",
+    1: "bad CRC",
+    2: "bad frame",
+    3: "unknown op",
+    4: "unknown command",
+    5: "response overflow",
+    6: "bad arguments",
+}
+OK, ERR_CRC, ERR_FRAME, ERR_OVERFLOW = 0, 1, 2, 5
+
+U8, U16, U32, I32, U64, STR, BYTES, LIST = range(1, 9)
+SCALARS = {U8: "<B", U16: "<H", U32: "<I", I32: "<i", U64: "<Q"}
+
+# decoded row of "tasks list" / "tasks info", states as in eTaskState
+TASK_FIELDS = ("name", "state", "priority", "stack", "number")
+TASK_STATES = ("running", "ready", "blocked", "suspended", "deleted", "invalid")
+
+
+class RpcError(Exception):
+    def __init__(self, status, values=None):
+        super().__init__(STATUS.get(status, "status %d" % status))
+        self.status = status
+        self.values = values
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, 0x29B1 for b"123456789"."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code = 0
+    for byte in data:
+        if byte:
+            out.append(byte)
+        if not byte or len(out) - code == 0xFF:
+            out[code] = len(out) - code
+            code = len(out)
+            out.append(0)
+    out[code] = len(out) - code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    """Decoded bytes, None if the encoding is broken."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def decode_values(data, offset=0, count=None):
+    """Typed items as Python values, LIST as list; stops at the end of data."""
+    values = []
+    while offset < len(data) and (count is None or len(values) < count):
+        kind = data[offset]
+        offset += 1
+        if kind in SCALARS:
+            fmt = SCALARS[kind]
+            size = struct.calcsize(fmt)
+            if offset + size > len(data):
+                break
+            values.append(struct.unpack_from(fmt, data, offset)[0])
+            offset += size
+        elif kind in (STR, BYTES, LIST):
+            if offset + 2 > len(data):
+                break
+            (length,) = struct.unpack_from("<H", data, offset)
+            offset += 2
+            if kind == LIST:
+                items, offset = decode_values(data, offset, length)
+                values.append(items)
+            else:
+                blob = data[offset:offset + length]
+                offset += length
+                values.append(blob.decode(errors="replace") if kind == STR else blob)
+        else:
+            raise ValueError("unknown value type %d at offset %d" % (kind, offset - 1))
+    return values, offset
+
+
+class ShellRpc:
+    """Framed session on an open pyserial port; the shell is put in frame mode by enter()."""
+
+    def __init__(self, ser, timeout=2.0):
+        self.ser = ser
+        self.timeout = timeout
+        self.seq = 0
+        self.pending = b""
+        self.stats = {"sent": 0, "received": 0, "bad": 0}
+
+    def __enter__(self):
+        self.enter()
+        return self
+
+    def __exit__(self, *exc):
+        self.exit()
+
+    def send(self, op, body=b""):
+        """Send one request, returns its sequence number."""
+        # 1..0xFFFF, seq 0 is reserved for ERR_FRAME replies
+        self.seq = self.seq % 0xFFFF + 1
+        frame = struct.pack("<HB", self.seq, op) + body
+        frame += struct.pack("<H", crc16(frame))
+        wire = b"\0" + cobs_encode(frame) + b"\0"
+        self.ser.write(wire)
+        self.stats["sent"] += len(wire)
+        return self.seq
+
+    def receive(self, seq, timeout=None):
+        """(status, payload) of the response to seq, None on timeout."""
+        deadline = time.monotonic() + (self.timeout if timeout is None else timeout)
+        while time.monotonic() < deadline:
+            end = self.pending.find(b"\0")
+            if end < 0:
+                self.pending += self.ser.read(self.ser.in_waiting or 1)
+                continue
+            chunk, self.pending = self.pending[:end], self.pending[end + 1:]
+            self.stats["received"] += len(chunk) + 1
+            if not chunk:
+                continue
+            # text printed around the frames decodes to junk and fails the CRC
+            frame = cobs_decode(chunk)
+            if frame is None or len(frame) < 5 or crc16(frame[:-2]) != struct.unpack("<H", frame[-2:])[0]:
+                self.stats["bad"] += 1
+                continue
+            # seq 0 answers a frame the shell could not read, such as the
+            # escape enter() sends while already in frame mode; never ours
+            rseq, status = struct.unpack_from("<HB", frame)
+            if rseq == seq:
+                return status, frame[3:-2]
+        return None
+
+    def request(self, op, body=b""):
+        """Values of a request, RpcError on any status but ok."""
+        seq = self.send(op, body)
+        reply = self.receive(seq)
+        if reply is None:
+            raise TimeoutError("no response to op %d seq %d" % (op, seq))
+        status, payload = reply
+        values, _ = decode_values(payload)
+        if status != OK:
+            raise RpcError(status, values)
+        return values
+
+    def call(self, line):
+        """Run a command line, returns its values, printed text as str items."""
+        return self.request(OP_CALL, line.encode())
+
+    def ping(self, body=b""):
+        return self.request(OP_PING, body)[0]
+
+    def enter(self, attempts=5):
+        """Escape to frame mode and wait until pings come back."""
+        self.ser.write(ESCAPE)
+        for attempt in range(attempts):
+            token = struct.pack("<I", int(time.monotonic() * 1e6) & 0xFFFFFFFF)
+            seq = self.send(OP_PING, token)
+            reply = self.receive(seq, timeout=0.5)
+            if reply is not None and reply[0] == OK and decode_values(reply[1])[0] == [token]:
+                return
+            # half a frame or a stuck line: escape again; in frame mode it is
+            # answered with a seq 0 ERR_FRAME, which receive() passes over
+            self.ser.write(b"\0" + ESCAPE)
+        raise TimeoutError("shell did not enter frame mode")
+
+    def exit(self):
+        """Back to the line editor, which prints a prompt."""
+        self.request(OP_EXIT)
+
+
+def tasks(values):
+    """Rows of "tasks list" as dicts."""
+    rows = []
+    for row in values[0]:
+        task = dict(zip(TASK_FIELDS, row))
+        task["state"] = TASK_STATES[task["state"]] if task["state"] < len(TASK_STATES) else task["state"]
+        rows.append(task)
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--port", required=True, help="shell serial port or pseudo-terminal")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--timeout", type=float, default=2.0)
+    parser.add_argument("commands", nargs="+", help="command lines to run")
+    args = parser.parse_args()
+
+    import serial
+
+    with serial.Serial(args.port, args.baud, timeout=0.05) as ser:
+        with ShellRpc(ser, args.timeout) as rpc:
+            for line in args.commands:
+                try:
+                    print("%s: %r" % (line, rpc.call(line)))
+                except RpcError as error:
+                    print("%s: %s %r" % (line, error, error.values))
+                    if error.status != ERR_OVERFLOW:
+                        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
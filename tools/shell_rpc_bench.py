@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""
+Text shell against framed RPC mode, per command latency and throughput.
+
+Runs the same command lines both ways on one link: typed into the line
+editor with the reply scraped up to the next prompt, as the test rigs do,
+and as CALL frames decoded by tools/shell_rpc.py.
+
+    python3 tools/shell_rpc_bench.py --port /dev/ttyUSB0
+    python3 tools/shell_rpc_bench.py --port /tmp/destroshell --runs 200 --window 4
+
+latency     one command at a time, from the first byte of the request to
+            the end of the prompt or response frame.
+throughput  --runs commands with up to --window of them in flight, as
+            commands per second, plus the bytes each one costs on the wire
+            in both directions.
+
+pyserial is needed (pip install -r tools/requirements.txt).
+"""
+import argparse
+import statistics
+import sys
+import time
+
+from shell_link_bench import PROMPT, read_until, sync
+from shell_rpc import OP_CALL, ShellRpc
+
+COMMANDS = ["tasks list", "heap", "pin read gpioa 0"]
+
+
+def summary(samples):
+    samples = sorted(samples)
+    p95 = samples[min(len(samples) - 1, int(len(samples) * 0.95))]
+    return "median %7.2f ms  p95 %7.2f ms  max %7.2f ms" % (statistics.median(samples), p95, samples[-1])
+
+
+def text_latency(ser, line, runs, timeout):
+    samples = []
+    received = 0
+    for _ in range(runs):
+        start = time.perf_counter()
+        ser.write(line + b"\r")
+        reply = read_until(ser, PROMPT, timeout)
+        if reply is None:
+            sys.exit("no prompt after '%s'" % line.decode())
+        samples.append((time.perf_counter() - start) * 1e3)
+        received += len(reply)
+    return samples, received / runs
+
+
+def text_throughput(ser, line, runs, window, timeout):
+    """Lines queue in the shell's command buffer, every finished one prints a prompt."""
+    start = time.perf_counter()
+    sent = done = 0
+    data = b""
+    deadline = time.monotonic() + timeout * runs
+    while done < runs:
+        while sent < runs and sent - done < window:
+            ser.write(line + b"\r")
+            sent += 1
+        data += ser.read(ser.in_waiting or 1)
+        done = data.count(PROMPT)
+        if time.monotonic() > deadline:
+            sys.exit("text throughput stalled after %d of %d" % (done, runs))
+    return runs / (time.perf_counter() - start)
+
+
+def rpc_latency(rpc, line, runs, timeout):
+    samples = []
+    received = rpc.stats["received"]
+    for _ in range(runs):
+        start = time.perf_counter()
+        seq = rpc.send(OP_CALL, line)
+        if rpc.receive(seq, timeout) is None:
+            sys.exit("no response to '%s'" % line.decode())
+        samples.append((time.perf_counter() - start) * 1e3)
+    return samples, (rpc.stats["received"] - received) / runs
+
+
+def rpc_throughput(rpc, line, runs, window, timeout):
+    """Frames queue like lines; responses come back in request order."""
+    start = time.perf_counter()
+    inflight = []
+    sent = done = 0
+    while done < runs:
+        while sent < runs and len(inflight) < window:
+            inflight.append(rpc.send(OP_CALL, line))
+            sent += 1
+        if rpc.receive(inflight.pop(0), timeout) is None:
+            sys.exit("rpc throughput stalled after %d of %d" % (done, runs))
+        done += 1
+    return runs / (time.perf_counter() - start)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--port", required=True, help="shell serial port or pseudo-terminal")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--runs", type=int, default=100, help="commands per measurement")
+    parser.add_argument("--window", type=int, default=4, help="commands in flight for throughput")
+    parser.add_argument("--timeout", type=float, default=5.0)
+    parser.add_argument("commands", nargs="*", default=COMMANDS, help="command lines to compare")
+    args = parser.parse_args()
+
+    import serial
+
+    results = {}
+    with serial.Serial(args.port, args.baud, timeout=0.05) as ser:
+        sync(ser, args.timeout)
+        for command in args.commands:
+            line = command.encode()
+            samples, received = text_latency(ser, line, args.runs, args.timeout)
+            rate = text_throughput(ser, line, args.runs, args.window, args.timeout)
+            results[command] = {"text": (samples, len(line) + 1, received, rate)}
+            sync(ser, args.timeout)
+
+        with ShellRpc(ser, args.timeout) as rpc:
+            for command in args.commands:
+                line = command.encode()
+                sent = rpc.stats["sent"]
+                samples, received = rpc_latency(rpc, line, args.runs, args.timeout)
+                request = (rpc.stats["sent"] - sent) / args.runs
+                rate = rpc_throughput(rpc, line, args.runs, args.window, args.timeout)
+                results[command]["rpc"] = (samples, request, received, rate)
+            if rpc.stats["bad"]:
+                print("%d frames failed to decode" % rpc.stats["bad"])
+
+    print("%d runs per command, window %d, %d baud" % (args.runs, args.window, args.baud))
+    for command, paths in results.items():
+        print("'%s'" % command)
+        for path in ("text", "rpc"):
+            samples, sent, received, rate = paths[path]
+            print("  %-4s  %s  %7.1f cmd/s  %5.0f B out  %6.0f B in"
+                  % (path, summary(samples), rate, sent, received))
+        speedup = statistics.median(paths["text"][0]) / statistics.median(paths["rpc"][0])
+        print("        rpc median latency %.2fx, throughput %.2fx of text"
+              % (1 / speedup, paths["rpc"][3] / paths["text"][3]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""
+Chrome trace / Perfetto JSON from the destroshell trace recorder.
+
+Reads the binary dump written by "trace dump" (see ShellTraceHeader_t in
+PROJECT/destroshell/shell_trace.h), either straight from the shell port or
+from a file saved earlier, and writes a JSON trace for ui.perfetto.dev or
+chrome://tracing: one track per task with its run slices, one track per
+interrupt, and queue operations as instant events on the running context.
+
+    trace start                   (on the target, let it run)
+    python3 tools/trace_to_perfetto.py --port /dev/ttyUSB0 -o trace.json
+    python3 tools/trace_to_perfetto.py --input trace.bin -o trace.json
+
+pyserial is only needed for --port (pip install -r tools/requirements.txt).
+"""
+import argparse
+import json
+import struct
+import sys
+import time
+
+MAGIC = 0x31435254          # "TRC1", SHELL_TRACE_MAGIC
+HEADER = struct.Struct("<5I")
+TASK = struct.Struct("<I12s")
+RECORD = struct.Struct("<IBBH")
+
+TASK_IN, TASK_OUT = 1, 2
+QUEUE_SEND, QUEUE_SEND_ISR, QUEUE_RECEIVE, QUEUE_RECEIVE_ISR = 3, 4, 5, 6
+ISR_ENTER, ISR_EXIT = 7, 8
+
+QUEUE_EVENTS = {
+    QUEUE_SEND: "send",
+    QUEUE_SEND_ISR: "send from ISR",
+    QUEUE_RECEIVE: "receive",
+    QUEUE_RECEIVE_ISR: "receive from ISR",
+}
+
+# exception number (IRQn + 16) of the handlers that record
+IRQ_NAMES = {
+    22: "EXTI0",
+    32: "DMA1_Stream5",
+    33: "DMA1_Stream6",
+    54: "USART2",
+    70: "TIM6_DAC",
+    71: "TIM7",
+    73: "DMA2_Stream1",
+    85: "DMA2_Stream6",
+    87: "USART6",
+}
+
+PID = 1
+IRQ_TID = 1000              # interrupt tracks sit above any task number
+
+
+def dump_size(data, start):
+    _, _, count, _, tasks = HEADER.unpack_from(data, start)
+    return HEADER.size + tasks * TASK.size + count * RECORD.size
+
+
+def read_port(port, baud, timeout):
+    import serial
+
+    with serial.Serial(port, baud, timeout=0.2) as ser:
+        ser.reset_input_buffer()
+        ser.write(b"trace dump\r")
+        data = b""
+        deadline = time.monotonic() + timeout
+        magic = struct.pack("<I", MAGIC)
+        while time.monotonic() < deadline:
+            data += ser.read(4096)
+            start = data.find(magic)
+            if start < 0 or len(data) < start + HEADER.size:
+                continue
+            end = start + dump_size(data, start)
+            if len(data) >= end:
+                return data[start:end]
+    sys.exit("no complete dump received from %s" % port)
+
+
+def parse(blob):
+    start = blob.find(struct.pack("<I", MAGIC))
+    if start < 0:
+        sys.exit("no trace dump found in input")
+    if len(blob) < start + dump_size(blob, start):
+        sys.exit("trace dump truncated")
+    _, clock, count, lost, ntasks = HEADER.unpack_from(blob, start)
+    offset = start + HEADER.size
+    tasks = {}
+    for i in range(ntasks):
+        number, name = TASK.unpack_from(blob, offset + i * TASK.size)
+        tasks[number] = name.split(b"\0", 1)[0].decode(errors="replace")
+    offset += ntasks * TASK.size
+    records = [RECORD.unpack_from(blob, offset + i * RECORD.size) for i in range(count)]
+    return clock, lost, tasks, records
+
+
+def unwrap(records):
+    """CYCCNT wraps every 2^32 cycles; writers may also stamp a few cycles out of order."""
+    out = []
+    last_raw = None
+    now = 0
+    for raw, kind, arg, ident in records:
+        if last_raw is not None:
+            delta = (raw - last_raw) & 0xFFFFFFFF
+            now += delta - (1 << 32) if delta >= (1 << 31) else delta
+        last_raw = raw
+        out.append((now, kind, arg, ident))
+    return out
+
+
+def convert(clock, tasks, records):
+    def us(cycles):
+        return cycles * 1e6 / clock
+
+    events = [{"ph": "M", "pid": PID, "name": "process_name", "args": {"name": "destroshell"}}]
+    for number, name in sorted(tasks.items()):
+        events.append({"ph": "M", "pid": PID, "tid": number, "name": "thread_name",
+                       "args": {"name": name}})
+    irq_tracks = set()
+
+    running = None          # (task number, start)
+    isr_stack = []          # (exception number, start), innermost last
+    for now, kind, arg, ident in unwrap(records):
+        if kind in (TASK_IN, TASK_OUT):
+            if running is not None and (kind == TASK_IN or running[0] == ident):
+                number, begin = running
+                events.append({"ph": "X", "pid": PID, "tid": number, "name": tasks.get(number, "task %d" % number),
+                               "ts": us(begin), "dur": us(now - begin)})
+                running = None
+            if kind == TASK_IN:
+                running = (ident, now)
+        elif kind == ISR_ENTER:
+            isr_stack.append((ident, now))
+        elif kind == ISR_EXIT:
+            # a handler entered before the trace started has no enter record
+            if isr_stack and isr_stack[-1][0] == ident:
+                number, begin = isr_stack.pop()
+                irq_tracks.add(number)
+                events.append({"ph": "X", "pid": PID, "tid": IRQ_TID + number,
+                               "name": IRQ_NAMES.get(number, "IRQ %d" % (number - 16)),
+                               "ts": us(begin), "dur": us(now - begin)})
+        elif kind in QUEUE_EVENTS:
+            if isr_stack:
+                tid = IRQ_TID + isr_stack[-1][0]
+                irq_tracks.add(isr_stack[-1][0])
+            else:
+                tid = running[0] if running is not None else 0
+            queue = 0x20000000 | ((ident << 2) & 0x3FFFF)
+            events.append({"ph": "i", "s": "t", "pid": PID, "tid": tid,
+                           "name": "%s 0x%08x" % (QUEUE_EVENTS[kind], queue),
+                           "ts": us(now), "args": {"queue": "0x%08x" % queue, "waiting": arg}})
+
+    for number in sorted(irq_tracks):
+        events.append({"ph": "M", "pid": PID, "tid": IRQ_TID + number, "name": "thread_name",
+                       "args": {"name": "ISR " + IRQ_NAMES.get(number, "IRQ %d" % (number - 16))}})
+    return events
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="shell serial port, sends 'trace dump'")
+    source.add_argument("--input", help="file holding a saved dump")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--timeout", type=float, default=20.0, help="seconds to wait for the dump")
+    parser.add_argument("--save", help="also write the raw dump to this file")
+    parser.add_argument("-o", "--output", default="trace.json", help="JSON file to write")
+    args = parser.parse_args()
+
+    if args.port:
+        blob = read_port(args.port, args.baud, args.timeout)
+    else:
+        with open(args.input, "rb") as f:
+            blob = f.read()
+    if args.save:
+        with open(args.save, "wb") as f:
+            f.write(blob)
+
+    clock, lost, tasks, records = parse(blob)
+    events = convert(clock, tasks, records)
+    with open(args.output, "w") as f:
+        json.dump({"traceEvents": events, "displayTimeUnit": "ns"}, f)
+
+    span = unwrap(records)[-1][0] / clock if records else 0.0
+    print("%d records over %.3f s, %d lost, %d tasks -> %s"
+          % (len(records), span, lost, len(tasks), args.output))
+
+
+if __name__ == "__main__":
+    main()